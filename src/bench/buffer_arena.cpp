@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "tlsf_allocator.h"
+
+// Allocator behind BufferArena under mesh-like churn: random sizes and
+// vertex-stride alignments, a third of the operations frees. Reports time
+// per operation, occupancy and fragmentation before and after packing the
+// live blocks the way BufferArena::compact() does, then pages requests
+// up to several pages large the way BufferArena::allocate() does. CPU only.
+//   ./buffer_arena.o [operations] [capacity MB]
+
+struct Live {
+    TlsfBlock block;
+    size_t size;
+    size_t alignment;
+};
+
+void print_stats(const char* label, const TlsfStats& stats){
+    float fragmentation = stats.free > 0 ? 1.0f - (float)stats.largest_free / (float)stats.free : 0.0f;
+    printf(
+        "%-8s %zu allocations, %.1f%% used, %zu free blocks, largest %zu KB, fragmentation %.2f\n",
+        label,
+        stats.allocations,
+        100.0 * stats.used / stats.capacity,
+        stats.free_blocks,
+        stats.largest_free / 1024,
+        fragmentation
+    );
+}
+
+// BufferArena's paging without the GL buffers: first fit over the pages,
+// else a new page, sized for the request when it does not fit in one
+bool page_requests(size_t requests, size_t page_size, const size_t* strides, size_t stride_count){
+    std::vector<TlsfAllocator> pages;
+    std::mt19937 random(2);
+    size_t oversized = 0;
+    size_t failed = 0;
+    for(size_t i = 0; i < requests; i++){
+        size_t alignment = strides[random() % stride_count];
+        size_t size = random() % 4 == 0 ? page_size + random() % (3 * page_size) : 1 + random() % (page_size / 8);
+        TlsfBlock block = TLSF_NONE;
+        for(size_t page = 0; page < pages.size() && block == TLSF_NONE; page++){
+            block = pages[page].allocate(size, alignment);
+        }
+        if(block != TLSF_NONE){
+            continue;
+        }
+        oversized += size > page_size;
+        pages.emplace_back(std::max(page_size, TlsfAllocator::capacity_for(size, alignment)));
+        failed += pages.back().allocate(size, alignment) == TLSF_NONE;
+    }
+
+    size_t capacity = 0;
+    size_t used = 0;
+    for(const TlsfAllocator& page : pages){
+        capacity += page.stats().capacity;
+        used += page.stats().used;
+    }
+    printf(
+        "paged    %zu requests, %zu pages (%zu dedicated), %.1f%% used, %zu failed\n",
+        requests,
+        pages.size(),
+        oversized,
+        100.0 * used / capacity,
+        failed
+    );
+    return failed == 0;
+}
+
+int main(int argc, char** argv){
+    size_t operations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+    size_t capacity = (argc > 2 ? strtoul(argv[2], nullptr, 10) : 64) * 1024 * 1024;
+    const size_t strides[] = {12, 16, 20, 24, 32, 48};
+
+    TlsfAllocator allocator(capacity);
+    std::vector<Live> live;
+    std::mt19937 random(1);
+    size_t failed = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < operations; i++){
+        if(live.empty() || random() % 3 != 0){
+            size_t alignment = strides[random() % 6];
+            size_t size = (16 + random() % 4096) * alignment;
+            TlsfBlock block = allocator.allocate(size, alignment);
+            if(block == TLSF_NONE){
+                failed++;
+                continue;
+            }
+            live.push_back({block, size, alignment});
+        } else {
+            size_t victim = random() % live.size();
+            allocator.free(live[victim].block);
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // Blocks must be aligned and must not overlap
+    bool valid = true;
+    std::sort(live.begin(), live.end(), [&](const Live& a, const Live& b){
+        return allocator.offset(a.block) < allocator.offset(b.block);
+    });
+    for(size_t i = 0; valid && i < live.size(); i++){
+        valid = allocator.offset(live[i].block) % live[i].alignment == 0 && allocator.size(live[i].block) >= live[i].size;
+        if(valid && i > 0){
+            valid = allocator.offset(live[i - 1].block) + allocator.size(live[i - 1].block) <= allocator.offset(live[i].block);
+        }
+    }
+
+    printf("%zu operations on %zu MB, %.0f ns each, %zu failed\n", operations, capacity >> 20, elapsed / operations, failed);
+    print_stats("churned", allocator.stats());
+
+    // Pack in offset order, as compaction does
+    std::vector<size_t> offsets(live.size());
+    size_t cursor = 0;
+    for(size_t i = 0; i < live.size(); i++){
+        size_t alignment = TlsfAllocator::alignment(live[i].alignment);
+        offsets[i] = (cursor + alignment - 1) / alignment * alignment;
+        cursor = offsets[i] + allocator.size(live[i].block);
+    }
+    allocator.reset(capacity);
+    for(size_t i = 0; valid && i < live.size(); i++){
+        valid = allocator.allocate_at(offsets[i], live[i].size) != TLSF_NONE;
+    }
+    print_stats("packed", allocator.stats());
+
+    if(!valid){
+        printf("INVALID LAYOUT\n");
+    }
+    bool paged = page_requests(10000, 4 * 1024 * 1024, strides, 6);
+    return valid && paged ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "asset_archive.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+#define BENCH_SHADER_DIR "bench_shaders"
+#define BENCH_ARCHIVE "bench_shaders" ASSET_ARCHIVE_EXTENSION
+
+// The original loader: heap string filled through istreambuf_iterator
+std::string* read_shader_program(std::string filepath){
+    std::ifstream file_stream(filepath);
+    return new std::string(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
+}
+
+std::vector<std::string> write_shaders(int count, size_t size){
+    mkdir(BENCH_SHADER_DIR, 0755);
+    std::string body = "#version 400\nuniform vec4 inputColour;\nout vec4 fragColour;\n";
+    while(body.size() < size){
+        body += "// padding so the file looks like a real shader with comments and code\n";
+    }
+    body += "void main(){\n    fragColour = inputColour;\n}\n";
+
+    std::vector<std::string> paths;
+    for(int i = 0; i < count; i++){
+        char path[64];
+        snprintf(path, sizeof(path), BENCH_SHADER_DIR "/shader_%05d.frag", i);
+        FILE* file = fopen(path, "wb");
+        fwrite(body.data(), 1, body.size(), file);
+        fclose(file);
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// Every path hashes the bytes so both loaders actually touch the contents
+template <typename Fn>
+double measure(const std::vector<std::string>& paths, Fn load, uint64_t& checksum){
+    double best = 1e30;
+    for(int run = 0; run < 5; run++){
+        checksum = FNV_OFFSET_BASIS;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(const std::string& path : paths){
+            checksum = load(path, checksum);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+int main(int argc, char** argv){
+    int count = argc > 1 ? atoi(argv[1]) : 4000;
+    size_t size = argc > 2 ? (size_t)atoi(argv[2]) : 4096;
+    std::vector<std::string> paths = write_shaders(count, size);
+
+    uint64_t iterator_sum = 0;
+    uint64_t mapped_sum = 0;
+    double iterator_ms = measure(paths, [](const std::string& path, uint64_t hash){
+        std::string* source = read_shader_program(path);
+        hash = fnv1a(source->data(), source->size(), hash);
+        delete source;
+        return hash;
+    }, iterator_sum);
+    double mapped_ms = measure(paths, [](const std::string& path, uint64_t hash){
+        MappedFile source(path.c_str());
+        return fnv1a(source.data(), source.size(), hash);
+    }, mapped_sum);
+
+    // The same files from one archive, opened inside the timed loop so the
+    // single open is paid like the per-file ones
+    std::vector<AssetSource> sources;
+    for(const std::string& path : paths){
+        sources.push_back({path, path});
+    }
+    double archive_ms[2];
+    uint64_t archive_sum[2];
+    for(int compressed = 0; compressed < 2; compressed++){
+        AssetPackOptions options;
+        options.compress = compressed != 0;
+        write_asset_archive(BENCH_ARCHIVE, sources.data(), sources.size(), options);
+        AssetArchive archive;
+        AssetBlob blob;
+        archive_ms[compressed] = measure(paths, [&](const std::string& path, uint64_t hash){
+            if(&path == &paths[0]){
+                archive.open(BENCH_ARCHIVE);
+            }
+            archive.read(path.c_str(), blob);
+            return fnv1a(blob.data(), blob.size(), hash);
+        }, archive_sum[compressed]);
+    }
+
+    printf("%d files of %zu bytes (warm page cache)\n", count, size);
+    printf("istreambuf_iterator %8.2f ms  %6.2f us/file\n", iterator_ms, iterator_ms * 1000.0 / count);
+    printf("mmap                %8.2f ms  %6.2f us/file\n", mapped_ms, mapped_ms * 1000.0 / count);
+    printf("archive             %8.2f ms  %6.2f us/file\n", archive_ms[0], archive_ms[0] * 1000.0 / count);
+    printf("archive, lz4        %8.2f ms  %6.2f us/file\n", archive_ms[1], archive_ms[1] * 1000.0 / count);
+    bool match = iterator_sum == mapped_sum && mapped_sum == archive_sum[0] && mapped_sum == archive_sum[1];
+    printf("checksums %s\n", match ? "match" : "DIFFER");
+
+    for(const std::string& path : paths){
+        remove(path.c_str());
+    }
+    rmdir(BENCH_SHADER_DIR);
+    remove(BENCH_ARCHIVE);
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_log.h"
+#include "gl_state.h"
+#include "instancing.h"
+#include "shader.h"
+#include "stream_buffer.h"
+
+// Frame time for N small quads drawn one glDrawArrays each (two uniforms
+// per quad) vs through InstanceRenderer. Runs headless under Mesa's
+// llvmpipe, e.g. LIBGL_ALWAYS_SOFTWARE=1 ./instancing.o [quads] [frames]
+
+const char* SINGLE_VERTEX =
+    "#version 410\n"
+    "layout(location = 0) in vec3 vertex_position;\n"
+    "uniform vec4 transform;\n"
+    "void main(){\n"
+    "    gl_Position = vec4(vertex_position * transform.w + transform.xyz, 1.0);\n"
+    "}\n";
+
+const char* SINGLE_FRAGMENT =
+    "#version 410\n"
+    "uniform vec4 colour;\n"
+    "out vec4 fragColour;\n"
+    "void main(){\n"
+    "    fragColour = colour;\n"
+    "}\n";
+
+const char* INSTANCED_VERTEX =
+    "#version 410\n"
+    "layout(location = 0) in vec3 vertex_position;\n"
+    "layout(location = 1) in vec4 instance_transform;\n"
+    "layout(location = 2) in vec4 instance_colour;\n"
+    "out vec4 colour;\n"
+    "void main(){\n"
+    "    colour = instance_colour;\n"
+    "    gl_Position = vec4(vertex_position * instance_transform.w + instance_transform.xyz, 1.0);\n"
+    "}\n";
+
+const char* INSTANCED_FRAGMENT =
+    "#version 410\n"
+    "in vec4 colour;\n"
+    "out vec4 fragColour;\n"
+    "void main(){\n"
+    "    fragColour = colour;\n"
+    "}\n";
+
+const float QUAD[] = {
+    -1.0f, -1.0f, 0.0f,   1.0f, -1.0f, 0.0f,   1.0f, 1.0f, 0.0f,
+    -1.0f, -1.0f, 0.0f,   1.0f, 1.0f, 0.0f,   -1.0f, 1.0f, 0.0f,
+};
+
+GLuint make_program(const char* vertex, const char* fragment){
+    ShaderSource sources[] = {
+        {GL_VERTEX_SHADER, vertex, -1},
+        {GL_FRAGMENT_SHADER, fragment, -1},
+    };
+    return build_program(sources, 2, nullptr);
+}
+
+GLuint make_vao(GLuint vbo){
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+    return vao;
+}
+
+InstanceData quad_instance(int i, int count){
+    int side = 1;
+    while(side * side < count){
+        side++;
+    }
+    float step = 2.0f / side;
+    InstanceData instance = {
+        {-1.0f + step * (i % side + 0.5f), -1.0f + step * (i / side + 0.5f), 0.0f, step * 0.4f},
+        {(float)(i % side) / side, (float)(i / side) / side, 0.5f, 1.0f},
+    };
+    return instance;
+}
+
+int main(int argc, char** argv){
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int frames = argc > 2 ? atoi(argv[2]) : 20;
+    restart_gl_log();
+
+    // Hidden 4.1 core context
+    if(!glfwInit()){
+        fprintf(stderr, "ERROR: could not start GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(512, 512, "instancing", NULL, NULL);
+    if(!window){
+        fprintf(stderr, "ERROR: could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+    printf("Renderer: %s\n", glGetString(GL_RENDERER));
+
+    GLuint vbo = 0;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+    GLuint single_vao = make_vao(vbo);
+    GLuint instanced_vao = make_vao(vbo);
+    GLuint single_program = make_program(SINGLE_VERTEX, SINGLE_FRAGMENT);
+    GLuint instanced_program = make_program(INSTANCED_VERTEX, INSTANCED_FRAGMENT);
+    if(!single_program || !instanced_program){
+        fprintf(stderr, "ERROR: could not build the benchmark programs\n");
+        glfwTerminate();
+        return 1;
+    }
+    GLint transform_loc = glGetUniformLocation(single_program, "transform");
+    GLint colour_loc = glGetUniformLocation(single_program, "colour");
+
+    // One draw per quad
+    glUseProgram(single_program);
+    glBindVertexArray(single_vao);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; frame++){
+        glClear(GL_COLOR_BUFFER_BIT);
+        for(int i = 0; i < count; i++){
+            InstanceData instance = quad_instance(i, count);
+            glUniform4fv(transform_loc, 1, instance.transform);
+            glUniform4fv(colour_loc, 1, instance.colour);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
+        glFinish();
+    }
+    double single = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+    // Instanced
+    GlState gl_state;
+    StreamBuffer stream;
+    stream.create(count * sizeof(InstanceData) + 256);
+    InstanceRenderer renderer(stream);
+    InstancedMesh mesh;
+    mesh.vao = instanced_vao;
+    mesh.count = 6;
+    start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; frame++){
+        glClear(GL_COLOR_BUFFER_BIT);
+        stream.begin_frame();
+        for(int i = 0; i < count; i++){
+            renderer.add(instanced_program, mesh, quad_instance(i, count));
+        }
+        renderer.submit(gl_state);
+        stream.end_frame();
+        gl_state.end_frame();
+        glFinish();
+    }
+    double instanced = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+    InstanceStats stats = renderer.stats();
+
+    printf("%d quads, %d frames\n", count, frames);
+    printf("individual  %9.2f ms/frame  (%d draw calls)\n", single, count);
+    printf("instanced   %9.2f ms/frame  (%llu draw calls)\n", instanced, (unsigned long long)stats.draw_calls);
+    printf("speedup %.1fx\n", single / instanced);
+
+    stream.destroy();
+    glfwTerminate();
+    gl_log_shutdown();
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "gl_log.h"
+#include "gl_log_binary.h"
+
+#define BENCH_TEXT_FILE "bench_gl.log"
+#define BENCH_BINARY_FILE "bench_gl.bin"
+
+long file_size(const char* path){
+    struct stat info;
+    return stat(path, &info) == 0 ? (long)info.st_size : -1;
+}
+
+// Producer throughput including the final drain to disk
+void run(const char* name, const char* path, LogFormat format, int records){
+    LogConfig config;
+    config.path = path;
+    config.capacity = 1 << 16;
+    config.overflow_policy = LogOverflowPolicy::BLOCK;
+    config.format = format;
+    restart_gl_log(config);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i = 0; i < records; i++){
+        gl_log("frame %i draw calls %i cpu %.3f ms gpu %.3f ms\n", i, 1200 + (i & 63), 4.25 + (i & 7) * 0.01, 6.5);
+    }
+    std::chrono::steady_clock::time_point enqueued = std::chrono::steady_clock::now();
+    gl_log_shutdown();
+    std::chrono::steady_clock::time_point drained = std::chrono::steady_clock::now();
+
+    double produce = std::chrono::duration<double>(enqueued - start).count();
+    double total = std::chrono::duration<double>(drained - start).count();
+    long size = file_size(path);
+    printf(
+        "%-7s %12.0f records/s (producer)  %12.0f records/s (to disk)  %10ld bytes  %5.1f bytes/record\n",
+        name,
+        records / produce,
+        records / total,
+        size,
+        (double)size / records
+    );
+}
+
+int main(int argc, char** argv){
+    int records = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    run("text", BENCH_TEXT_FILE, LogFormat::TEXT, records);
+    run("binary", BENCH_BINARY_FILE, LogFormat::BINARY, records);
+
+    remove(BENCH_TEXT_FILE);
+    remove(BENCH_BINARY_FILE);
+    return 0;
+}
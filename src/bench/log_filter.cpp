@@ -0,0 +1,71 @@
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Compile TRACE out so the compile-time path can be measured next to DEBUG,
+// which stays compiled in but is disabled at runtime
+#define GL_LOG_MIN_LEVEL 1
+#include "gl_log_filter.h"
+
+#define BENCH_LOG_FILE "bench_gl.log"
+
+template <typename T>
+inline void do_not_optimize(const T& value){
+    asm volatile("" : : "g"(value) : "memory");
+}
+
+// Stands in for argument formatting work that must not run when disabled
+double expensive_argument(int i){
+    return sqrt((double)i) * 1.0001;
+}
+
+// Best of several runs, in ns per iteration
+template <typename Fn>
+double measure(int iterations, Fn body){
+    double best = 1e30;
+    for(int run = 0; run < 7; run++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int i = 0; i < iterations; i++){
+            body(i);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        best = ns < best ? ns : best;
+    }
+    return best;
+}
+
+int main(int argc, char** argv){
+    int iterations = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    LogConfig config;
+    config.path = BENCH_LOG_FILE;
+    restart_gl_log(config);
+    gl_log_set_level(LogLevel::INFO);
+
+    double empty = measure(iterations, [](int i){
+        do_not_optimize(i);
+    });
+    double compiled_out = measure(iterations, [](int i){
+        do_not_optimize(i);
+        GL_LOG_TRACE(FRAME, "frame %i value %f\n", i, expensive_argument(i));
+    });
+    double runtime_off = measure(iterations, [](int i){
+        do_not_optimize(i);
+        GL_LOG_DEBUG(FRAME, "frame %i value %f\n", i, expensive_argument(i));
+    });
+    double enabled = measure(iterations / 100, [](int i){
+        do_not_optimize(i);
+        GL_LOG_INFO(FRAME, "frame %i value %f\n", i, expensive_argument(i));
+    });
+    gl_log_shutdown();
+
+    printf("empty loop          %7.3f ns/iter\n", empty);
+    printf("compiled out        %7.3f ns/iter (%+.3f)\n", compiled_out, compiled_out - empty);
+    printf("disabled at runtime %7.3f ns/iter (%+.3f)\n", runtime_off, runtime_off - empty);
+    printf("enabled             %7.3f ns/iter\n", enabled);
+
+    remove(BENCH_LOG_FILE);
+    return 0;
+}
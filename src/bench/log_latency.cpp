@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "gl_log.h"
+
+#define BENCH_LOG_FILE "bench_gl.log"
+
+// The original lesson 2 path: open, append, close on every call
+bool gl_log_open_append_close(const char* message, ...){
+    va_list arguments;
+    FILE* file = fopen(BENCH_LOG_FILE, "a");
+    if(!file){
+        return false;
+    }
+    va_start(arguments, message);
+    vfprintf(file, message, arguments);
+    va_end(arguments);
+    fclose(file);
+    return true;
+}
+
+template <typename Fn>
+void report(const char* name, int iterations, Fn log_call){
+    std::vector<double> samples(iterations);
+    for(int i = 0; i < iterations; i++){
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        log_call(i);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        samples[i] = std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for(double sample : samples){
+        total += sample;
+    }
+    printf(
+        "%-20s mean %9.1f ns  p50 %9.1f ns  p99 %9.1f ns  max %11.1f ns\n",
+        name,
+        total / iterations,
+        samples[iterations / 2],
+        samples[(size_t)(iterations * 0.99)],
+        samples.back()
+    );
+}
+
+int main(int argc, char** argv){
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+
+    remove(BENCH_LOG_FILE);
+    report("open-append-close", iterations, [](int i){
+        gl_log_open_append_close("frame %i GL_MAX_TEXTURE_SIZE %i %s\n", i, 16384, "ok");
+    });
+
+    LogConfig config;
+    config.path = BENCH_LOG_FILE;
+    config.capacity = 1 << 16;
+    restart_gl_log(config);
+    report("async ring", iterations, [](int i){
+        gl_log("frame %i GL_MAX_TEXTURE_SIZE %i %s\n", i, 16384, "ok");
+    });
+    gl_log_shutdown();
+
+    LogStats stats = gl_log_stats();
+    printf(
+        "ring: enqueued %llu written %llu dropped %llu lost %llu backpressure %llu flushes %llu\n",
+        (unsigned long long)stats.enqueued,
+        (unsigned long long)stats.written,
+        (unsigned long long)stats.dropped,
+        (unsigned long long)stats.lost,
+        (unsigned long long)stats.backpressure_waits,
+        (unsigned long long)stats.flushes
+    );
+
+    remove(BENCH_LOG_FILE);
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+#include "mesh_importer.h"
+
+#define BENCH_MESH_FILE "bench_mesh.obj"
+
+// Import throughput of a generated OBJ grid with positions, uvs and
+// normals, at 1, 2, 4... threads up to the core count. The file is kept
+// between runs.
+//   ./mesh_import.o [size MB] [max threads]
+
+// Roughly size bytes of OBJ text
+bool write_obj(const char* path, size_t size){
+    FILE* file = fopen(path, "wb");
+    if(!file){
+        return false;
+    }
+    int grid = 16;
+    while((size_t)grid * grid * 220 < size){
+        grid++;
+    }
+    for(int y = 0; y <= grid; y++){
+        for(int x = 0; x <= grid; x++){
+            float u = (float)x / grid;
+            float v = (float)y / grid;
+            fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 0.000000 1.000000\n", u * 100.0f, v * 100.0f, u * v, u, v);
+        }
+    }
+    for(int y = 0; y < grid; y++){
+        for(int x = 0; x < grid; x++){
+            int a = y * (grid + 1) + x + 1;
+            int b = a + 1;
+            int c = a + grid + 1;
+            int d = c + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d);
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, c, c, c);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv){
+    size_t size = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned max_threads = argc > 2 ? (unsigned)atoi(argv[2]) : (cores > 0 ? cores : 1);
+
+    struct stat info;
+    if(stat(BENCH_MESH_FILE, &info) != 0 || (size_t)info.st_size < size * 9 / 10 || (size_t)info.st_size > size * 11 / 10){
+        printf("writing %s...\n", BENCH_MESH_FILE);
+        if(!write_obj(BENCH_MESH_FILE, size)){
+            fprintf(stderr, "ERROR: could not write %s\n", BENCH_MESH_FILE);
+            return 1;
+        }
+    }
+
+    std::vector<unsigned> thread_counts;
+    for(unsigned threads = 1; threads < max_threads; threads *= 2){
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    printf("%8s %10s %10s %10s %10s\n", "threads", "parse ms", "build ms", "MB/s", "vertices");
+    for(unsigned threads : thread_counts){
+        MeshImportOptions options;
+        options.threads = threads;
+        ImportedMesh mesh;
+        MeshImportStats stats;
+        if(!import_mesh(BENCH_MESH_FILE, mesh, options, &stats)){
+            return 1;
+        }
+        double total_ms = stats.parse_ms + stats.build_ms;
+        printf(
+            "%8u %10.1f %10.1f %10.1f %10zu\n",
+            threads,
+            stats.parse_ms,
+            stats.build_ms,
+            stats.bytes / (1024.0 * 1024.0) / (total_ms / 1000.0),
+            mesh.vertex_count()
+        );
+    }
+    return 0;
+}
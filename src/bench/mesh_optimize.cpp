@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "mesh_optimizer.h"
+
+// ACMR and optimizer time on a grid mesh given as a shuffled, unindexed
+// triangle list, the worst case an importer can hand us. CPU only.
+//   ./mesh_optimize.o [grid size]
+
+struct Vertex {
+    float position[3];
+    float uv[2];
+};
+
+std::vector<Vertex> shuffled_grid(int size){
+    std::vector<Vertex> triangles;
+    for(int y = 0; y < size; y++){
+        for(int x = 0; x < size; x++){
+            Vertex corners[4];
+            for(int i = 0; i < 4; i++){
+                float cx = (float)(x + (i & 1));
+                float cy = (float)(y + (i >> 1));
+                corners[i] = {{cx, cy, 0.0f}, {cx / size, cy / size}};
+            }
+            Vertex quad[] = {corners[0], corners[1], corners[3], corners[0], corners[3], corners[2]};
+            triangles.insert(triangles.end(), quad, quad + 6);
+        }
+    }
+
+    // Shuffle whole triangles
+    std::vector<size_t> order(triangles.size() / 3);
+    for(size_t i = 0; i < order.size(); i++){
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+    std::vector<Vertex> shuffled;
+    shuffled.reserve(triangles.size());
+    for(size_t triangle : order){
+        shuffled.insert(shuffled.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+    }
+    return shuffled;
+}
+
+int main(int argc, char** argv){
+    int size = argc > 1 ? atoi(argv[1]) : 256;
+    std::vector<Vertex> triangles = shuffled_grid(size);
+
+    std::vector<unsigned char> vertices;
+    std::vector<uint32_t> indices;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    MeshOptimizeReport report = optimize_mesh(triangles.data(), triangles.size(), sizeof(Vertex), vertices, indices);
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // The triangle set must survive the reordering
+    bool valid = indices.size() == triangles.size();
+    for(size_t i = 0; valid && i < indices.size(); i++){
+        valid = indices[i] < report.vertices_after;
+    }
+
+    printf("%dx%d grid, %zu triangles\n", size, size, indices.size() / 3);
+    printf("vertices  %zu -> %zu (%zu bytes/vertex)\n", report.vertices_before, report.vertices_after, sizeof(Vertex));
+    printf("ACMR      %.3f -> %.3f (FIFO %zu)\n", report.acmr_before, report.acmr_after, VERTEX_CACHE_SIZE);
+    printf("optimized in %.2f ms%s\n", elapsed, valid ? "" : "  (INVALID INDICES)");
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "radix_sort.h"
+#include "render_queue.h"
+
+// Per-frame sort cost of the render queue's keys, radix sort vs std::sort,
+// and the state changes left after sorting. CPU only, no context needed.
+//   ./render_queue.o [items] [frames]
+
+const unsigned PROGRAMS = 16;
+const unsigned MATERIALS = 64;
+const unsigned VAOS = 32;
+
+// Scene-like keys: a few layers, a limited set of programs/materials/VAOs
+// and random depth
+std::vector<uint64_t> make_keys(size_t count, unsigned seed){
+    srand(seed);
+    std::vector<uint64_t> keys(count);
+    for(size_t i = 0; i < count; i++){
+        unsigned layer = rand() % 3;
+        GLuint program = 1 + rand() % PROGRAMS;
+        unsigned material = rand() % MATERIALS;
+        GLuint vao = 1 + rand() % VAOS;
+        float depth = (float)rand() / (float)RAND_MAX;
+        keys[i] = draw_sort_key(layer, program, material, vao, depth);
+    }
+    return keys;
+}
+
+struct StateChanges {
+    size_t programs;
+    size_t materials;
+    size_t vaos;
+};
+
+// Switches of each kind when drawing in the given key order
+StateChanges state_changes(const SortEntry* entries, size_t count){
+    const unsigned vao_shift = SORT_DEPTH_BITS;
+    const unsigned material_shift = vao_shift + SORT_VAO_BITS;
+    const unsigned program_shift = material_shift + SORT_MATERIAL_BITS;
+    StateChanges changes = {0, 0, 0};
+    for(size_t i = 1; i < count; i++){
+        uint64_t previous = entries[i - 1].key;
+        uint64_t current = entries[i].key;
+        changes.programs += (previous >> program_shift) != (current >> program_shift);
+        changes.materials += (previous >> material_shift) != (current >> material_shift);
+        changes.vaos += (previous >> vao_shift) != (current >> vao_shift);
+    }
+    return changes;
+}
+
+void fill(std::vector<SortEntry>& entries, const std::vector<uint64_t>& keys){
+    for(size_t i = 0; i < keys.size(); i++){
+        entries[i].key = keys[i];
+        entries[i].index = (uint32_t)i;
+    }
+}
+
+int main(int argc, char** argv){
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    int frames = argc > 2 ? atoi(argv[2]) : 100;
+
+    std::vector<uint64_t> keys = make_keys(count, 1);
+    std::vector<SortEntry> entries(count);
+    std::vector<SortEntry> scratch(count);
+
+    fill(entries, keys);
+    StateChanges unsorted_changes = state_changes(entries.data(), count);
+
+    // Best of frames for both, the input is refilled unsorted each time
+    double radix_best = 1e9;
+    double std_best = 1e9;
+    for(int frame = 0; frame < frames; frame++){
+        fill(entries, keys);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        radix_sort(entries.data(), scratch.data(), count);
+        double radix = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        radix_best = std::min(radix_best, radix);
+    }
+    StateChanges sorted_changes = state_changes(entries.data(), count);
+    bool ordered = std::is_sorted(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b){
+        return a.key < b.key;
+    });
+
+    for(int frame = 0; frame < frames; frame++){
+        fill(entries, keys);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b){
+            return a.key < b.key;
+        });
+        double sorted = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std_best = std::min(std_best, sorted);
+    }
+
+    printf("%zu items, best of %d frames\n", count, frames);
+    printf("radix sort  %8.3f ms%s\n", radix_best, ordered ? "" : "  (NOT SORTED)");
+    printf("std::sort   %8.3f ms\n", std_best);
+    printf("unsorted    %zu program, %zu material, %zu VAO changes\n",
+        unsorted_changes.programs, unsorted_changes.materials, unsorted_changes.vaos);
+    printf("sorted      %zu program, %zu material, %zu VAO changes\n",
+        sorted_changes.programs, sorted_changes.materials, sorted_changes.vaos);
+    return ordered ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_log.h"
+#include "shader.h"
+#include "shader_cache.h"
+
+#define BENCH_CACHE_DIR "bench_shader_cache"
+
+// Cold vs warm start for a set of program variants. Runs headless with
+// Mesa's software driver, e.g. LIBGL_ALWAYS_SOFTWARE=1 ./shader_cache_startup.o
+
+const char* VERTEX_TEMPLATE =
+    "#version 410\n"
+    "in vec3 vertex_position;\n"
+    "uniform mat4 transform;\n"
+    "void main(){\n"
+    "    vec4 p = transform * vec4(vertex_position, 1.0);\n"
+    "    for(int i = 0; i < %d; i++){ p.xy = p.xy * 0.999 + sin(p.yx * float(i)) * 0.001; }\n"
+    "    gl_Position = p;\n"
+    "}\n";
+
+const char* FRAGMENT_TEMPLATE =
+    "#version 410\n"
+    "uniform vec4 inputColour;\n"
+    "out vec4 fragColour;\n"
+    "void main(){\n"
+    "    fragColour = inputColour * %d.0 / 64.0;\n"
+    "}\n";
+
+std::string variant(const char* format, int value){
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer), format, value);
+    return buffer;
+}
+
+double build_all(const std::vector<std::string>& vertex, const std::vector<std::string>& fragment, ProgramCacheStats& stats){
+    ProgramBinaryCache cache(BENCH_CACHE_DIR);
+    std::vector<GLuint> programs;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < vertex.size(); i++){
+        ShaderSource sources[] = {
+            {GL_VERTEX_SHADER, vertex[i].c_str(), -1},
+            {GL_FRAGMENT_SHADER, fragment[i].c_str(), -1},
+        };
+        programs.push_back(build_program(sources, 2, &cache));
+    }
+    glFinish();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    for(GLuint program : programs){
+        glDeleteProgram(program);
+    }
+    stats = cache.stats();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv){
+    int count = argc > 1 ? atoi(argv[1]) : 64;
+    restart_gl_log();
+
+    // Hidden 4.1 core context
+    if(!glfwInit()){
+        fprintf(stderr, "ERROR: could not start GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "shader cache", NULL, NULL);
+    if(!window){
+        fprintf(stderr, "ERROR: could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+    printf("Renderer: %s\n", glGetString(GL_RENDERER));
+
+    std::vector<std::string> vertex;
+    std::vector<std::string> fragment;
+    for(int i = 0; i < count; i++){
+        vertex.push_back(variant(VERTEX_TEMPLATE, 8 + i));
+        fragment.push_back(variant(FRAGMENT_TEMPLATE, i));
+    }
+
+    // Start cold: remove anything a previous run left behind
+    if(system("rm -rf " BENCH_CACHE_DIR) != 0){
+        fprintf(stderr, "could not clear %s\n", BENCH_CACHE_DIR);
+    }
+
+    ProgramCacheStats cold_stats;
+    ProgramCacheStats warm_stats;
+    double cold = build_all(vertex, fragment, cold_stats);
+    double warm = build_all(vertex, fragment, warm_stats);
+
+    printf("%d programs\n", count);
+    if(cold_stats.stored == 0){
+        printf("no binaries stored, the driver does not support program binaries\n");
+    }
+    printf("cold  %9.2f ms  (%llu hits, %llu misses, %llu stored)\n", cold,
+        (unsigned long long)cold_stats.hits, (unsigned long long)cold_stats.misses, (unsigned long long)cold_stats.stored);
+    printf("warm  %9.2f ms  (%llu hits, %llu misses, %llu rejected)\n", warm,
+        (unsigned long long)warm_stats.hits, (unsigned long long)warm_stats.misses, (unsigned long long)warm_stats.rejected);
+    printf("speedup %.1fx\n", cold / warm);
+
+    glfwTerminate();
+    gl_log_shutdown();
+    return 0;
+}
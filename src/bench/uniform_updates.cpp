@@ -0,0 +1,144 @@
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_log.h"
+#include "shader.h"
+#include "shader_reflection.h"
+
+// Per-frame uniform updates by name lookup vs the reflection cache. Every
+// frame sets all UNIFORM_COUNT vec4s and a mat4; only CHANGED_PER_FRAME of
+// them actually change. Runs headless with Mesa's software driver, e.g.
+// LIBGL_ALWAYS_SOFTWARE=1 ./uniform_updates.o [frames]
+
+const int UNIFORM_COUNT = 16;
+const int CHANGED_PER_FRAME = 2;
+
+const char* VERTEX_SOURCE =
+    "#version 410\n"
+    "in vec3 vertex_position;\n"
+    "uniform mat4 transform;\n"
+    "void main(){\n"
+    "    gl_Position = transform * vec4(vertex_position, 1.0);\n"
+    "}\n";
+
+std::string fragment_source(){
+    std::string source = "#version 410\nout vec4 fragColour;\n";
+    for(int i = 0; i < UNIFORM_COUNT; i++){
+        source += "uniform vec4 u" + std::to_string(i) + ";\n";
+    }
+    source += "void main(){\n    fragColour = vec4(0.0)";
+    for(int i = 0; i < UNIFORM_COUNT; i++){
+        source += " + u" + std::to_string(i);
+    }
+    source += ";\n}\n";
+    return source;
+}
+
+void frame_values(int frame, float values[UNIFORM_COUNT][4]){
+    for(int i = 0; i < UNIFORM_COUNT; i++){
+        float value = i < CHANGED_PER_FRAME ? (float)frame : (float)i;
+        values[i][0] = values[i][1] = values[i][2] = values[i][3] = value;
+    }
+}
+
+const float IDENTITY[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+double by_name(GLuint program, int frames, char names[UNIFORM_COUNT][8]){
+    float values[UNIFORM_COUNT][4];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; frame++){
+        frame_values(frame, values);
+        glUniformMatrix4fv(glGetUniformLocation(program, "transform"), 1, GL_FALSE, IDENTITY);
+        for(int i = 0; i < UNIFORM_COUNT; i++){
+            glUniform4fv(glGetUniformLocation(program, names[i]), 1, values[i]);
+        }
+    }
+    glFinish();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+double by_reflection(ProgramReflection& reflection, int frames, const uint64_t ids[UNIFORM_COUNT]){
+    float values[UNIFORM_COUNT][4];
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int frame = 0; frame < frames; frame++){
+        frame_values(frame, values);
+        reflection.set_mat4(SHADER_NAME("transform"), IDENTITY);
+        for(int i = 0; i < UNIFORM_COUNT; i++){
+            reflection.set_vec4(ids[i], values[i]);
+        }
+    }
+    glFinish();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+int main(int argc, char** argv){
+    int frames = argc > 1 ? atoi(argv[1]) : 20000;
+    restart_gl_log();
+
+    // Hidden 4.1 core context
+    if(!glfwInit()){
+        fprintf(stderr, "ERROR: could not start GLFW3\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "uniform updates", NULL, NULL);
+    if(!window){
+        fprintf(stderr, "ERROR: could not open window with GLFW3\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glewExperimental = GL_TRUE;
+    glewInit();
+    printf("Renderer: %s\n", glGetString(GL_RENDERER));
+
+    std::string fragment = fragment_source();
+    ShaderSource sources[] = {
+        {GL_VERTEX_SHADER, VERTEX_SOURCE, -1},
+        {GL_FRAGMENT_SHADER, fragment.c_str(), -1},
+    };
+    GLuint program = build_program(sources, 2, nullptr);
+    if(!program){
+        fprintf(stderr, "ERROR: could not build the benchmark program\n");
+        glfwTerminate();
+        return 1;
+    }
+    glUseProgram(program);
+
+    char names[UNIFORM_COUNT][8];
+    uint64_t ids[UNIFORM_COUNT];
+    for(int i = 0; i < UNIFORM_COUNT; i++){
+        snprintf(names[i], sizeof(names[i]), "u%d", i);
+        ids[i] = fnv1a(names[i]);
+    }
+
+    ProgramReflection reflection;
+    reflection.reflect(program);
+    double named = by_name(program, frames, names);
+    double reflected = by_reflection(reflection, frames, ids);
+
+    ReflectionStats stats = reflection.stats();
+    int per_frame = UNIFORM_COUNT + 1;
+    printf("%d frames, %d uniforms set per frame, %d changing\n", frames, per_frame, CHANGED_PER_FRAME);
+    printf("by name     %8.3f us/frame  (%d GL calls/frame)\n", named, per_frame * 2);
+    printf("reflection  %8.3f us/frame  (%.2f GL calls/frame, %llu of %llu sets skipped)\n",
+        reflected,
+        (double)(stats.sets - stats.skipped - stats.missing) / frames,
+        (unsigned long long)stats.skipped,
+        (unsigned long long)stats.sets);
+    printf("speedup %.1fx\n", named / reflected);
+
+    glDeleteProgram(program);
+    glfwTerminate();
+    gl_log_shutdown();
+    return 0;
+}
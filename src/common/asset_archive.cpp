@@ -0,0 +1,379 @@
+#include "asset_archive.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <utility>
+
+#include "error_reporter.h"
+#include "hash.h"
+#include "lz4_block.h"
+
+// The header and table are the on-disk layout; they must not pick up padding
+static_assert(sizeof(AssetArchiveHeader) == 40, "asset archive header layout changed");
+static_assert(sizeof(AssetArchiveEntry) == 56, "asset archive entry layout changed");
+
+namespace {
+
+size_t align_offset(size_t offset){
+    return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) / ASSET_ARCHIVE_ALIGNMENT * ASSET_ARCHIVE_ALIGNMENT;
+}
+
+bool write_padded(FILE* file, const void* data, size_t size, size_t& offset){
+    static const char PADDING[ASSET_ARCHIVE_ALIGNMENT] = {};
+    size_t aligned = align_offset(offset);
+    if(fwrite(PADDING, 1, aligned - offset, file) != aligned - offset){
+        return false;
+    }
+    offset = aligned + size;
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+// Whether the file at path holds exactly data's bytes
+bool same_contents(const std::string& path, const MappedFile& data){
+    MappedFile other;
+    return other.open(path.c_str()) &&
+        other.size() == data.size() &&
+        (data.size() == 0 || memcmp(other.data(), data.data(), data.size()) == 0);
+}
+
+uint32_t slot_count_for(size_t entries){
+    // At most half full keeps probe chains short
+    uint32_t slots = 1;
+    while(slots < entries * 2){
+        slots <<= 1;
+    }
+    return slots;
+}
+
+}
+
+std::string normalize_asset_path(const char* path){
+    std::vector<std::string> parts;
+    for(const char* p = path; *p;){
+        const char* end = strchr(p, '/');
+        end = end ? end : p + strlen(p);
+        std::string part(p, end);
+        if(part == ".."){
+            if(!parts.empty() && parts.back() != ".."){
+                parts.pop_back();
+            } else {
+                parts.push_back(part);
+            }
+        } else if(!part.empty() && part != "."){
+            parts.push_back(part);
+        }
+        p = *end ? end + 1 : end;
+    }
+
+    std::string out;
+    for(const std::string& part : parts){
+        if(!out.empty()){
+            out += '/';
+        }
+        out += part;
+    }
+    return out;
+}
+
+bool write_asset_archive(
+    const char* path,
+    const AssetSource* sources,
+    size_t count,
+    const AssetPackOptions& options,
+    AssetPackStats* stats
+){
+    AssetPackStats totals = {0, 0, 0, 0, 0, 0};
+    uint32_t slot_count = slot_count_for(count);
+    std::vector<AssetArchiveEntry> slots(slot_count);
+    memset(slots.data(), 0, slots.size() * sizeof(AssetArchiveEntry));
+    std::string names;
+
+    // Handle IO
+    std::string temporary = std::string(path) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(!file){
+        report_error(LogCategory::ASSET, "ERROR: could not open %s for writing\n", temporary.c_str());
+        return false;
+    }
+    AssetArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    size_t offset = sizeof(header);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Data is written as it is read, one source mapped at a time; contents
+    // seen before, compared byte for byte once the hash and size match,
+    // point at the earlier copy
+    struct StoredData {
+        const AssetArchiveEntry* entry;
+        size_t source;
+    };
+    typedef std::unordered_multimap<uint64_t, StoredData> StoredMap;
+    StoredMap stored;
+    std::vector<char> compressed;
+    for(size_t i = 0; i < count && written; i++){
+        std::string name = normalize_asset_path(sources[i].path.c_str());
+        MappedFile source;
+        if(name.empty() || !source.open(sources[i].file.c_str())){
+            report_error(LogCategory::ASSET, "ERROR: could not pack %s\n", sources[i].file.c_str());
+            written = false;
+            break;
+        }
+
+        uint64_t path_hash = fnv1a(name.c_str());
+        uint32_t slot = (uint32_t)path_hash & (slot_count - 1);
+        for(; slots[slot].name_length; slot = (slot + 1) & (slot_count - 1)){
+            if(slots[slot].path_hash == path_hash && name == names.c_str() + slots[slot].name_offset){
+                break;
+            }
+        }
+        if(slots[slot].name_length){
+            report_error(LogCategory::ASSET, "ERROR: %s is packed twice\n", name.c_str());
+            written = false;
+            break;
+        }
+
+        AssetArchiveEntry& entry = slots[slot];
+        entry.path_hash = path_hash;
+        entry.content_hash = fnv1a((const void*)source.data(), source.size());
+        entry.size = source.size();
+        entry.name_offset = (uint32_t)names.size();
+        entry.name_length = (uint32_t)name.size();
+        names += name;
+        names += '\0';
+        totals.entries++;
+        totals.bytes += source.size();
+
+        const AssetArchiveEntry* same = nullptr;
+        std::pair<StoredMap::iterator, StoredMap::iterator> candidates = stored.equal_range(entry.content_hash);
+        for(StoredMap::iterator candidate = candidates.first; candidate != candidates.second; ++candidate){
+            if(candidate->second.entry->size == entry.size && same_contents(sources[candidate->second.source].file, source)){
+                same = candidate->second.entry;
+                break;
+            }
+        }
+        if(same){
+            entry.offset = same->offset;
+            entry.stored_size = same->stored_size;
+            entry.compression = same->compression;
+            continue;
+        }
+
+        const char* data = source.data();
+        size_t size = source.size();
+        entry.compression = (uint32_t)AssetCompression::NONE;
+        if(options.compress && size > 0){
+            compressed.resize(lz4_compress_bound(size));
+            size_t compressed_size = lz4_compress(data, size, compressed.data(), compressed.size());
+            if(compressed_size && compressed_size <= size - (size_t)(size * options.min_saving)){
+                data = compressed.data();
+                size = compressed_size;
+                entry.compression = (uint32_t)AssetCompression::LZ4;
+                totals.compressed++;
+            }
+        }
+        entry.stored_size = size;
+        written = write_padded(file, data, size, offset);
+        entry.offset = offset - size;
+        stored.insert({entry.content_hash, {&entry, i}});
+        totals.unique++;
+        totals.stored_bytes += size;
+    }
+
+    // Table and names go last, then the header that points at them
+    memcpy(header.magic, ASSET_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entry_count = (uint32_t)count;
+    header.slot_count = slot_count;
+    written = written && write_padded(file, slots.data(), slots.size() * sizeof(AssetArchiveEntry), offset);
+    header.toc_offset = offset - slots.size() * sizeof(AssetArchiveEntry);
+    written = written && write_padded(file, names.data(), names.size(), offset);
+    header.names_offset = offset - names.size();
+    header.names_size = names.size();
+    written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+
+    if(!written || rename(temporary.c_str(), path) != 0){
+        report_error(LogCategory::ASSET, "ERROR: could not write asset archive %s\n", path);
+        remove(temporary.c_str());
+        return false;
+    }
+    if(stats){
+        totals.archive_bytes = offset;
+        *stats = totals;
+    }
+    return true;
+}
+
+AssetBlob::AssetBlob(AssetBlob&& other) noexcept{
+    *this = std::move(other);
+}
+
+AssetBlob& AssetBlob::operator=(AssetBlob&& other) noexcept{
+    if(this != &other){
+        // Moving the vector and mapping keeps their addresses
+        data_ = other.data_;
+        size_ = other.size_;
+        storage_ = std::move(other.storage_);
+        file_ = std::move(other.file_);
+        other.data_ = "";
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void AssetBlob::reference(const char* data, size_t size){
+    clear();
+    data_ = data;
+    size_ = size;
+}
+
+char* AssetBlob::allocate(size_t size){
+    clear();
+    storage_.resize(size);
+    data_ = size ? storage_.data() : "";
+    size_ = size;
+    return storage_.data();
+}
+
+bool AssetBlob::map(const char* path){
+    clear();
+    if(!file_.open(path)){
+        return false;
+    }
+    data_ = file_.data();
+    size_ = file_.size();
+    return true;
+}
+
+void AssetBlob::clear(){
+    data_ = "";
+    size_ = 0;
+    storage_.clear();
+    file_.close();
+}
+
+bool AssetArchive::open(const char* path){
+    close();
+    if(!file_.open(path)){
+        return false;
+    }
+
+    // The table is checked once here so lookups and reads can trust it
+    const AssetArchiveHeader* header = (const AssetArchiveHeader*)file_.data();
+    size_t size = file_.size();
+    bool valid = size >= sizeof(AssetArchiveHeader) &&
+        memcmp(header->magic, ASSET_ARCHIVE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == ASSET_ARCHIVE_VERSION;
+    valid = valid &&
+        header->slot_count > 0 &&
+        (header->slot_count & (header->slot_count - 1)) == 0 &&
+        header->entry_count < header->slot_count &&
+        header->toc_offset % ASSET_ARCHIVE_ALIGNMENT == 0 &&
+        header->slot_count <= size / sizeof(AssetArchiveEntry) &&
+        header->toc_offset <= size - header->slot_count * sizeof(AssetArchiveEntry) &&
+        header->names_size <= size &&
+        header->names_offset <= size - header->names_size &&
+        (header->names_size == 0 || file_.data()[header->names_offset + header->names_size - 1] == '\0');
+    const AssetArchiveEntry* slots = valid ? (const AssetArchiveEntry*)(file_.data() + header->toc_offset) : nullptr;
+    for(uint32_t i = 0; valid && i < header->slot_count; i++){
+        const AssetArchiveEntry& entry = slots[i];
+        if(entry.name_length == 0){
+            continue;
+        }
+        valid = entry.name_offset < header->names_size &&
+            entry.name_length < header->names_size - entry.name_offset &&
+            entry.stored_size <= size &&
+            entry.offset <= size - entry.stored_size &&
+            (entry.compression == (uint32_t)AssetCompression::NONE ? entry.stored_size == entry.size :
+                entry.compression == (uint32_t)AssetCompression::LZ4 && entry.size <= lz4_decompress_bound(entry.stored_size));
+        entries_.push_back(&entry);
+    }
+    if(!valid || entries_.size() != header->entry_count){
+        report_error(LogCategory::ASSET, "ERROR: %s is not a version %u asset archive\n", path, ASSET_ARCHIVE_VERSION);
+        close();
+        return false;
+    }
+    header_ = header;
+    slots_ = slots;
+    names_ = file_.data() + header->names_offset;
+    return true;
+}
+
+void AssetArchive::close(){
+    file_.close();
+    header_ = nullptr;
+    slots_ = nullptr;
+    names_ = nullptr;
+    entries_.clear();
+}
+
+const AssetArchiveEntry* AssetArchive::find(const char* path) const{
+    if(!header_){
+        return nullptr;
+    }
+    std::string name = normalize_asset_path(path);
+    uint64_t path_hash = fnv1a(name.c_str());
+    uint32_t mask = header_->slot_count - 1;
+    for(uint32_t slot = (uint32_t)path_hash & mask;; slot = (slot + 1) & mask){
+        const AssetArchiveEntry& entry = slots_[slot];
+        if(entry.name_length == 0){
+            return nullptr;
+        }
+        if(entry.path_hash == path_hash && entry.name_length == name.size() &&
+            memcmp(names_ + entry.name_offset, name.data(), name.size()) == 0){
+            return &entry;
+        }
+    }
+}
+
+bool AssetArchive::read(const char* path, AssetBlob& out) const{
+    const AssetArchiveEntry* entry = find(path);
+    if(!entry){
+        out.clear();
+        return false;
+    }
+    return read(*entry, out);
+}
+
+bool AssetArchive::read(const AssetArchiveEntry& entry, AssetBlob& out) const{
+    const char* data = file_.data() + entry.offset;
+    if(entry.compression == (uint32_t)AssetCompression::NONE){
+        out.reference(data, entry.size);
+        return true;
+    }
+    char* decoded = out.allocate(entry.size);
+    if(!lz4_decompress(data, entry.stored_size, decoded, entry.size)){
+        report_error(LogCategory::ASSET, "ERROR: asset %s is corrupt\n", name(entry));
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AssetArchive::verify() const{
+    bool result = true;
+    AssetBlob blob;
+    for(const AssetArchiveEntry* entry : entries_){
+        if(!read(*entry, blob)){
+            result = false;
+        } else if(fnv1a((const void*)blob.data(), blob.size()) != entry->content_hash){
+            report_error(LogCategory::ASSET, "ERROR: asset %s does not match its content hash\n", name(*entry));
+            result = false;
+        }
+    }
+    return result;
+}
+
+bool read_asset(const AssetArchive* archive, const char* path, AssetBlob& out){
+    if(archive && archive->read(path, out)){
+        return true;
+    }
+    return out.map(path);
+}
+
+bool asset_exists(const AssetArchive* archive, const char* path){
+    struct stat info;
+    return (archive && archive->contains(path)) || stat(path, &info) == 0;
+}
@@ -0,0 +1,281 @@
+#include "asset_pipeline.h"
+
+#include <algorithm>
+
+#include "error_reporter.h"
+#include "gl_state.h"
+
+namespace {
+
+const size_t ASSET_PAGE_SIZE = 4096;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end){
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void record(AssetStageStats& stage, double ms){
+    stage.count++;
+    stage.total_ms += ms;
+    stage.max_ms = std::max(stage.max_ms, ms);
+}
+
+// Reads a byte per page so mapped data is paged in here, not in the
+// render thread's glBufferSubData
+void fault_in(const char* data, size_t size){
+    volatile char sink = 0;
+    for(size_t offset = 0; offset < size; offset += ASSET_PAGE_SIZE){
+        sink = sink + data[offset];
+    }
+}
+
+}
+
+AssetPipeline::AssetPipeline(
+    GlState& gl_state,
+    BufferArena& arena,
+    const AssetArchive* archive,
+    const AssetPipelineOptions& options
+) : gl_state_(gl_state), arena_(arena), archive_(archive), options_(options){
+    stats_ = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0.0, {0, 0.0, 0.0}, {0, 0.0, 0.0}, {0, 0.0, 0.0}, {0, 0.0, 0.0}, {0, 0.0, 0.0}};
+    options_.workers = std::max(options_.workers, (size_t)1);
+    options_.upload_bytes = std::max(options_.upload_bytes, ASSET_PAGE_SIZE);
+    options_.upload_chunk = std::max(options_.upload_chunk, ASSET_PAGE_SIZE);
+    for(size_t i = 0; i < options_.workers; i++){
+        workers_.emplace_back(&AssetPipeline::work, this);
+    }
+}
+
+AssetPipeline::~AssetPipeline(){
+    stop();
+}
+
+AssetHandle AssetPipeline::load_mesh(const char* path){
+    return request(path, AssetType::MESH);
+}
+
+AssetHandle AssetPipeline::load_data(const char* path){
+    return request(path, AssetType::DATA);
+}
+
+AssetHandle AssetPipeline::request(const char* path, AssetType type){
+    std::unique_ptr<Job> job(new Job());
+    job->path = path;
+    job->type = type;
+    job->requested = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    AssetHandle handle = (AssetHandle)jobs_.size();
+    queue_.push_back(job.get());
+    jobs_.push_back(std::move(job));
+    stats_.queued = queue_.size();
+    stats_.max_queued = std::max(stats_.max_queued, stats_.queued);
+    wake_.notify_one();
+    return handle;
+}
+
+void AssetPipeline::work(){
+    for(;;){
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]{ return stopping_ || !queue_.empty(); });
+            if(stopping_){
+                return;
+            }
+            job = queue_.front();
+            queue_.pop_front();
+            job->status = AssetStatus::LOADING;
+            job->started = std::chrono::steady_clock::now();
+            stats_.queued = queue_.size();
+            stats_.loading++;
+            record(stats_.wait, elapsed_ms(job->requested, job->started));
+        }
+
+        bool decoded = decode(*job);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->decoded = std::chrono::steady_clock::now();
+        stats_.loading--;
+        record(stats_.load, elapsed_ms(job->started, job->decoded));
+        if(decoded){
+            job->status = AssetStatus::UPLOADING;
+            decoded_.push_back(job);
+            stats_.uploads++;
+            stats_.max_uploads = std::max(stats_.max_uploads, stats_.uploads);
+        } else {
+            job->status = AssetStatus::FAILED;
+            stats_.failed++;
+        }
+    }
+}
+
+bool AssetPipeline::decode(Job& job){
+    if(job.type == AssetType::DATA){
+        if(!read_asset(archive_, job.path.c_str(), job.blob)){
+            return false;
+        }
+        fault_in(job.blob.data(), job.blob.size());
+        return true;
+    }
+
+    if(!job.file.open(job.path.c_str(), archive_)){
+        return false;
+    }
+    const MeshFileHeader& header = job.file.header();
+    if(header.vertex_count == 0 || header.index_count == 0){
+        report_error(LogCategory::ASSET, "ERROR: mesh %s is empty\n", job.path.c_str());
+        job.file.close();
+        return false;
+    }
+    job.header = header;
+    fault_in((const char*)job.file.vertices(), job.file.vertex_bytes());
+    fault_in((const char*)job.file.indices(), job.file.index_bytes());
+    return true;
+}
+
+void AssetPipeline::update(){
+    TimePoint frame_start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uploads_.insert(uploads_.end(), decoded_.begin(), decoded_.end());
+        decoded_.clear();
+    }
+
+    size_t bytes = 0;
+    while(!uploads_.empty()){
+        Job& job = *uploads_.front();
+        if(!upload(job, bytes, frame_start)){
+            break;
+        }
+        uploads_.pop_front();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.uploaded_bytes += bytes;
+    stats_.frame_bytes = bytes;
+    stats_.frame_ms = elapsed_ms(frame_start, std::chrono::steady_clock::now());
+}
+
+bool AssetPipeline::upload(Job& job, size_t& bytes, TimePoint frame_start){
+    if(job.type == AssetType::DATA){
+        finish(job, true);
+        return true;
+    }
+
+    if(!job.allocated){
+        job.upload_started = std::chrono::steady_clock::now();
+        job.allocated = true;
+        if(!allocate_indexed_mesh(
+            arena_,
+            job.file.format(),
+            job.header.vertex_count,
+            job.header.index_type,
+            job.header.index_count,
+            job.mesh
+        )){
+            report_error(LogCategory::ASSET, "ERROR: no arena space for mesh %s\n", job.path.c_str());
+            finish(job, false);
+            return true;
+        }
+    }
+
+    // Vertex bytes, then index bytes, a chunk at a time until the budget
+    // runs out; the first chunk of a frame always goes
+    size_t vertex_bytes = job.file.vertex_bytes();
+    size_t total = vertex_bytes + job.file.index_bytes();
+    while(job.uploaded < total){
+        if(bytes > 0 && (bytes >= options_.upload_bytes ||
+            elapsed_ms(frame_start, std::chrono::steady_clock::now()) >= options_.upload_ms)){
+            return false;
+        }
+        bool vertices = job.uploaded < vertex_bytes;
+        size_t offset = vertices ? job.uploaded : job.uploaded - vertex_bytes;
+        size_t size = std::min(options_.upload_chunk, options_.upload_bytes - bytes);
+        size = std::min(size, (vertices ? vertex_bytes : total - vertex_bytes) - offset);
+        const char* source = (const char*)(vertices ? job.file.vertices() : job.file.indices());
+        if(!arena_.upload(vertices ? job.mesh.vertices : job.mesh.indices, source + offset, size, offset)){
+            destroy_indexed_mesh(job.mesh);
+            finish(job, false);
+            return true;
+        }
+        job.uploaded += size;
+        bytes += size;
+    }
+
+    refresh_indexed_mesh(job.mesh);
+    job.mesh.vao = create_mesh_vao(gl_state_, job.mesh);
+    finish(job, true);
+    return true;
+}
+
+void AssetPipeline::finish(Job& job, bool ready){
+    // The data is on the GPU now, or never will be
+    job.file.close();
+    TimePoint now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    job.status = ready ? AssetStatus::READY : AssetStatus::FAILED;
+    stats_.uploads--;
+    if(!ready){
+        stats_.failed++;
+        return;
+    }
+    stats_.ready++;
+    record(stats_.upload_wait, elapsed_ms(job.decoded, job.type == AssetType::MESH ? job.upload_started : now));
+    if(job.type == AssetType::MESH){
+        record(stats_.upload, elapsed_ms(job.upload_started, now));
+    }
+    record(stats_.total, elapsed_ms(job.requested, now));
+}
+
+AssetStatus AssetPipeline::status(AssetHandle handle) const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_[handle]->status;
+}
+
+bool AssetPipeline::idle() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.queued == 0 && stats_.loading == 0 && stats_.uploads == 0;
+}
+
+const IndexedMesh* AssetPipeline::mesh(AssetHandle handle) const{
+    const Job& job = *jobs_[handle];
+    return job.type == AssetType::MESH && status(handle) == AssetStatus::READY ? &job.mesh : nullptr;
+}
+
+const MeshFileHeader* AssetPipeline::mesh_header(AssetHandle handle) const{
+    const Job& job = *jobs_[handle];
+    return job.type == AssetType::MESH && status(handle) == AssetStatus::READY ? &job.header : nullptr;
+}
+
+const AssetBlob* AssetPipeline::data(AssetHandle handle) const{
+    const Job& job = *jobs_[handle];
+    return job.type == AssetType::DATA && status(handle) == AssetStatus::READY ? &job.blob : nullptr;
+}
+
+void AssetPipeline::destroy(){
+    stop();
+    for(std::unique_ptr<Job>& job : jobs_){
+        if(job->allocated){
+            destroy_indexed_mesh(job->mesh);
+            job->allocated = false;
+        }
+    }
+}
+
+void AssetPipeline::stop(){
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for(std::thread& worker : workers_){
+        worker.join();
+    }
+    workers_.clear();
+}
+
+AssetPipelineStats AssetPipeline::stats() const{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
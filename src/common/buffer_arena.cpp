@@ -0,0 +1,221 @@
+#include "buffer_arena.h"
+
+#include <algorithm>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+
+namespace {
+
+float page_fragmentation(const TlsfStats& stats){
+    return stats.free > 0 ? 1.0f - (float)stats.largest_free / (float)stats.free : 0.0f;
+}
+
+}
+
+uint32_t BufferArena::new_page(size_t size){
+    std::unique_ptr<Page> page(new Page());
+    page->size = (size + TlsfAllocator::GRANULE - 1) / TlsfAllocator::GRANULE * TlsfAllocator::GRANULE;
+    page->allocator.reset(page->size);
+
+    glGenBuffers(1, &page->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page->buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, page->size, NULL, GL_STATIC_DRAW);
+    GL_LOG_INFO(GL, "buffer arena page %u: %zu bytes\n", page->buffer, page->size);
+
+    // Reuse a released page's index so slots stay small
+    for(uint32_t index = 0; index < pages_.size(); index++){
+        if(!pages_[index]){
+            pages_[index] = std::move(page);
+            return index;
+        }
+    }
+    pages_.push_back(std::move(page));
+    return (uint32_t)pages_.size() - 1;
+}
+
+ArenaHandle BufferArena::allocate(size_t size, size_t alignment){
+    uint32_t page_index = 0;
+    TlsfBlock block = TLSF_NONE;
+    for(; page_index < pages_.size(); page_index++){
+        if(pages_[page_index]){
+            block = pages_[page_index]->allocator.allocate(size, alignment);
+            if(block != TLSF_NONE){
+                break;
+            }
+        }
+    }
+
+    if(block == TLSF_NONE){
+        // A larger request gets a page just big enough for the allocator's
+        // search to find it
+        page_index = new_page(std::max(page_size_, TlsfAllocator::capacity_for(size, alignment)));
+        block = pages_[page_index]->allocator.allocate(size, alignment);
+        if(block == TLSF_NONE){
+            report_error(LogCategory::GL, "ERROR: buffer arena could not allocate %zu bytes\n", size);
+            return ARENA_NONE;
+        }
+    }
+
+    ArenaHandle handle;
+    if(!free_slots_.empty()){
+        handle = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        handle = (ArenaHandle)slots_.size();
+        slots_.push_back(Slot());
+    }
+    Slot& slot = slots_[handle];
+    slot.page = page_index;
+    slot.block = block;
+    slot.size = size;
+    slot.alignment = alignment;
+    return handle;
+}
+
+void BufferArena::free(ArenaHandle handle){
+    if(handle >= slots_.size() || slots_[handle].block == TLSF_NONE){
+        return;
+    }
+    Slot& slot = slots_[handle];
+    pages_[slot.page]->allocator.free(slot.block);
+    slot.block = TLSF_NONE;
+    free_slots_.push_back(handle);
+}
+
+bool BufferArena::upload(ArenaHandle handle, const void* data, size_t size, size_t offset){
+    ArenaAllocation allocation = get(handle);
+    if(!allocation.buffer || offset + size > allocation.size){
+        return false;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset + offset, size, data);
+    return true;
+}
+
+ArenaAllocation BufferArena::get(ArenaHandle handle) const{
+    if(handle >= slots_.size() || slots_[handle].block == TLSF_NONE){
+        return {0, 0, 0};
+    }
+    const Slot& slot = slots_[handle];
+    const Page& page = *pages_[slot.page];
+    return {page.buffer, page.allocator.offset(slot.block), slot.size};
+}
+
+size_t BufferArena::compact(float min_fragmentation){
+    size_t moved = 0;
+    bool changed = false;
+    for(uint32_t page = 0; page < pages_.size(); page++){
+        if(!pages_[page]){
+            continue;
+        }
+        TlsfStats stats = pages_[page]->allocator.stats();
+        if(stats.allocations == 0){
+            glDeleteBuffers(1, &pages_[page]->buffer);
+            pages_[page].reset();
+            changed = true;
+            continue;
+        }
+        if(page_fragmentation(stats) < min_fragmentation){
+            continue;
+        }
+
+        moved += compact_page(page);
+        changed = true;
+        compactions_++;
+    }
+    if(changed){
+        generation_++;
+    }
+    return moved;
+}
+
+// Packs the page's live blocks in offset order through a scratch buffer;
+// returns how many moved
+size_t BufferArena::compact_page(uint32_t page_index){
+    Page& page = *pages_[page_index];
+
+    std::vector<ArenaHandle> live;
+    for(ArenaHandle handle = 0; handle < slots_.size(); handle++){
+        if(slots_[handle].block != TLSF_NONE && slots_[handle].page == page_index){
+            live.push_back(handle);
+        }
+    }
+    std::sort(live.begin(), live.end(), [&](ArenaHandle a, ArenaHandle b){
+        return page.allocator.offset(slots_[a].block) < page.allocator.offset(slots_[b].block);
+    });
+
+    // New offsets: each block moves down to the next position with its
+    // alignment, which is never past where it was, so the layout fits
+    std::vector<size_t> offsets(live.size());
+    size_t cursor = 0;
+    for(size_t i = 0; i < live.size(); i++){
+        const Slot& slot = slots_[live[i]];
+        size_t alignment = page.allocator.alignment(slot.alignment);
+        offsets[i] = (cursor + alignment - 1) / alignment * alignment;
+        cursor = offsets[i] + page.allocator.size(slot.block);
+    }
+
+    GLuint scratch = 0;
+    glGenBuffers(1, &scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+    glBufferData(GL_COPY_WRITE_BUFFER, cursor, NULL, GL_STREAM_COPY);
+    glBindBuffer(GL_COPY_READ_BUFFER, page.buffer);
+    size_t moved = 0;
+    for(size_t i = 0; i < live.size(); i++){
+        const Slot& slot = slots_[live[i]];
+        size_t offset = page.allocator.offset(slot.block);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, offsets[i], slot.size);
+        if(offset != offsets[i]){
+            moved++;
+            moved_bytes_ += slot.size;
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cursor);
+    glDeleteBuffers(1, &scratch);
+
+    // Rebuild the allocator around the packed layout
+    page.allocator.reset(page.size);
+    for(size_t i = 0; i < live.size(); i++){
+        slots_[live[i]].block = page.allocator.allocate_at(offsets[i], slots_[live[i]].size);
+        if(slots_[live[i]].block == TLSF_NONE){
+            report_error(LogCategory::GL, "ERROR: buffer arena lost an allocation while compacting\n");
+        }
+    }
+
+    GL_LOG_DEBUG(GL, "buffer arena page %u: compacted %zu allocations into %zu bytes\n", page.buffer, live.size(), cursor);
+    return moved;
+}
+
+void BufferArena::destroy(){
+    for(std::unique_ptr<Page>& page : pages_){
+        if(page){
+            glDeleteBuffers(1, &page->buffer);
+        }
+    }
+    pages_.clear();
+    slots_.clear();
+    free_slots_.clear();
+    generation_++;
+}
+
+BufferArenaStats BufferArena::stats() const{
+    BufferArenaStats stats = {0, 0, 0, 0, 0, 0.0f, compactions_, moved_bytes_};
+    size_t free = 0;
+    for(const std::unique_ptr<Page>& page : pages_){
+        if(!page){
+            continue;
+        }
+        TlsfStats page_stats = page->allocator.stats();
+        stats.pages++;
+        stats.capacity += page_stats.capacity;
+        stats.used += page_stats.used;
+        stats.allocations += page_stats.allocations;
+        stats.largest_free = std::max(stats.largest_free, page_stats.largest_free);
+        free += page_stats.free;
+    }
+    stats.fragmentation = free > 0 ? 1.0f - (float)stats.largest_free / (float)free : 0.0f;
+    return stats;
+}
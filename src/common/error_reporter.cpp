@@ -0,0 +1,257 @@
+#include "error_reporter.h"
+#include "hash.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+const size_t ERROR_TABLE_SIZE = 256;
+const size_t ERROR_TABLE_PROBES = 8;
+const size_t ERROR_TEXT_SIZE = 256;
+
+const char* CATEGORY_NAMES[] = {"GL", "GLFW", "shader", "frame", "asset"};
+
+struct ErrorEntry {
+    uint64_t key = 0;                   // 0 marks an empty slot
+    LogCategory category = LogCategory::GL;
+    double window_start = 0.0;
+    uint32_t repeats = 0;
+    char text[ERROR_TEXT_SIZE];         // first message of the current window
+};
+
+struct TokenBucket {
+    double tokens = -1.0;               // negative until first use
+    double last_refill = 0.0;
+    uint64_t throttled = 0;             // not yet summarised
+};
+
+struct ErrorReporter {
+    std::mutex mutex;
+    ErrorReportConfig config;
+    ErrorEntry entries[ERROR_TABLE_SIZE];
+    TokenBucket buckets[(int)LogCategory::COUNT];
+    double next_sweep = 0.0;
+    std::atomic<bool> pending{false};   // anything for tick() to summarise
+
+    uint64_t emitted = 0;
+    uint64_t repeats = 0;
+    uint64_t throttled = 0;
+    uint64_t summaries = 0;
+};
+
+ErrorReporter g_reporter;
+
+double now_seconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a over the template, with the detail value folded in
+uint64_t hash_template(const char* message, uint64_t detail){
+    uint64_t hash = hash_combine(fnv1a(message), detail);
+    return hash ? hash : 1;
+}
+
+void emit(LogCategory category, const char* text){
+    if(log_enabled(LogLevel::ERROR, category)){
+        gl_log_error("%s", text);
+    }
+}
+
+void emit_repeat_summary(ErrorEntry& entry, double now){
+    char line[ERROR_TEXT_SIZE + 96];
+    snprintf(
+        line,
+        sizeof(line),
+        "[%s] repeated %u times in %.1f s: %s",
+        CATEGORY_NAMES[(int)entry.category],
+        entry.repeats,
+        now - entry.window_start,
+        entry.text
+    );
+    emit(entry.category, line);
+    entry.repeats = 0;
+    g_reporter.summaries++;
+}
+
+void emit_throttle_summary(LogCategory category, TokenBucket& bucket){
+    char line[96];
+    snprintf(
+        line,
+        sizeof(line),
+        "[%s] %llu errors throttled\n",
+        CATEGORY_NAMES[(int)category],
+        (unsigned long long)bucket.throttled
+    );
+    emit(category, line);
+    bucket.throttled = 0;
+    g_reporter.summaries++;
+}
+
+bool take_token(TokenBucket& bucket, double now){
+    const ErrorReportConfig& config = g_reporter.config;
+    if(bucket.tokens < 0.0){
+        bucket.tokens = config.burst;
+        bucket.last_refill = now;
+    }
+
+    bucket.tokens += (now - bucket.last_refill) * config.tokens_per_second;
+    bucket.last_refill = now;
+    if(bucket.tokens > config.burst){
+        bucket.tokens = config.burst;
+    }
+    if(bucket.tokens < 1.0){
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+// Finds the slot for key, or claims an empty one, or evicts the oldest of
+// the probed slots after summarising it
+ErrorEntry& find_entry(uint64_t key, double now){
+    ErrorEntry* oldest = nullptr;
+    for(size_t probe = 0; probe < ERROR_TABLE_PROBES; probe++){
+        ErrorEntry& entry = g_reporter.entries[(key + probe) & (ERROR_TABLE_SIZE - 1)];
+        if(entry.key == key || entry.key == 0){
+            return entry;
+        }
+        if(!oldest || entry.window_start < oldest->window_start){
+            oldest = &entry;
+        }
+    }
+    if(oldest->repeats > 0){
+        emit_repeat_summary(*oldest, now);
+    }
+    oldest->key = 0;
+    return *oldest;
+}
+
+void sweep(double now, bool force){
+    ErrorReporter& g = g_reporter;
+    bool pending = false;
+
+    for(size_t i = 0; i < ERROR_TABLE_SIZE; i++){
+        ErrorEntry& entry = g.entries[i];
+        if(entry.repeats == 0){
+            continue;
+        }
+        if(force || now - entry.window_start >= g.config.window_seconds){
+            emit_repeat_summary(entry, now);
+        } else {
+            pending = true;
+        }
+    }
+
+    for(int i = 0; i < (int)LogCategory::COUNT; i++){
+        TokenBucket& bucket = g.buckets[i];
+        if(bucket.throttled == 0){
+            continue;
+        }
+        if(force || take_token(bucket, now)){
+            emit_throttle_summary((LogCategory)i, bucket);
+        } else {
+            pending = true;
+        }
+    }
+
+    g.next_sweep = now + g.config.window_seconds;
+    g.pending.store(pending, std::memory_order_relaxed);
+}
+
+bool report(LogCategory category, uint64_t detail, const char* message, va_list arguments){
+    ErrorReporter& g = g_reporter;
+    uint64_t key = hash_template(message, detail);
+    double now = now_seconds();
+
+    std::lock_guard<std::mutex> lock(g.mutex);
+    ErrorEntry& entry = find_entry(key, now);
+
+    // Repeat inside the window: count it, no formatting, no IO
+    if(entry.key == key && now - entry.window_start < g.config.window_seconds){
+        entry.repeats++;
+        g.repeats++;
+        g.pending.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    if(entry.key == key && entry.repeats > 0){
+        emit_repeat_summary(entry, now);
+    }
+
+    entry.key = key;
+    entry.category = category;
+    entry.window_start = now;
+    entry.repeats = 0;
+
+    // New window, spend a token from the category budget. The text is kept
+    // either way, a later repeat summary quotes it.
+    vsnprintf(entry.text, sizeof(entry.text), message, arguments);
+    TokenBucket& bucket = g.buckets[(int)category];
+    if(!take_token(bucket, now)){
+        bucket.throttled++;
+        g.throttled++;
+        g.pending.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    if(bucket.throttled > 0){
+        emit_throttle_summary(category, bucket);
+    }
+
+    emit(category, entry.text);
+    g.emitted++;
+    return true;
+}
+
+}
+
+void error_reporter_configure(const ErrorReportConfig& config){
+    std::lock_guard<std::mutex> lock(g_reporter.mutex);
+    g_reporter.config = config;
+}
+
+bool report_error(LogCategory category, const char* message, ...){
+    va_list arguments;
+    va_start(arguments, message);
+    bool result = report(category, 0, message, arguments);
+    va_end(arguments);
+    return result;
+}
+
+bool report_error_detail(LogCategory category, uint64_t detail, const char* message, ...){
+    va_list arguments;
+    va_start(arguments, message);
+    bool result = report(category, detail, message, arguments);
+    va_end(arguments);
+    return result;
+}
+
+void error_reporter_tick(){
+    if(!g_reporter.pending.load(std::memory_order_relaxed)){
+        return;
+    }
+
+    double now = now_seconds();
+    std::lock_guard<std::mutex> lock(g_reporter.mutex);
+    if(now >= g_reporter.next_sweep){
+        sweep(now, false);
+    }
+}
+
+void error_reporter_flush(){
+    std::lock_guard<std::mutex> lock(g_reporter.mutex);
+    sweep(now_seconds(), true);
+}
+
+ErrorReportStats error_reporter_stats(){
+    std::lock_guard<std::mutex> lock(g_reporter.mutex);
+    ErrorReportStats stats;
+    stats.emitted = g_reporter.emitted;
+    stats.repeats = g_reporter.repeats;
+    stats.throttled = g_reporter.throttled;
+    stats.summaries = g_reporter.summaries;
+    return stats;
+}
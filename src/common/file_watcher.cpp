@@ -0,0 +1,130 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include "gl_log_filter.h"
+
+namespace {
+
+const double FILE_WATCHER_SCAN_INTERVAL = 0.25;
+
+long long modified_time(const std::string& path){
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0){
+        return 0;
+    }
+#ifdef __APPLE__
+    return (long long)info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#else
+    return (long long)info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#endif
+}
+
+double now_seconds(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void add_once(std::vector<int>& changed, int id){
+    if(std::find(changed.begin(), changed.end(), id) == changed.end()){
+        changed.push_back(id);
+    }
+}
+
+}
+
+FileWatcher::FileWatcher(){
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd_ < 0){
+        GL_LOG_WARN(GL, "file watcher: inotify unavailable, polling modification times\n");
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher(){
+    if(inotify_fd_ >= 0){
+        close(inotify_fd_);
+    }
+}
+
+int FileWatcher::watch(const char* path){
+    WatchedFile file;
+    std::string full = path;
+    size_t slash = full.find_last_of('/');
+    file.directory = slash == std::string::npos ? "." : full.substr(0, slash);
+    file.name = slash == std::string::npos ? full : full.substr(slash + 1);
+    file.modified = modified_time(full);
+
+    // Watching a path twice hands back the first id
+    for(size_t i = 0; i < files_.size(); i++){
+        if(files_[i].name == file.name && files_[i].directory == file.directory){
+            return (int)i;
+        }
+    }
+
+#ifdef __linux__
+    // Watch the directory so rename-over saves are seen
+    if(inotify_fd_ >= 0){
+        file.directory_watch = inotify_add_watch(
+            inotify_fd_,
+            file.directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE
+        );
+        if(file.directory_watch < 0){
+            GL_LOG_WARN(GL, "file watcher: could not watch %s\n", file.directory.c_str());
+            return -1;
+        }
+    }
+#endif
+
+    files_.push_back(file);
+    return (int)files_.size() - 1;
+}
+
+void FileWatcher::poll(std::vector<int>& changed){
+#ifdef __linux__
+    if(inotify_fd_ >= 0){
+        alignas(struct inotify_event) char buffer[4096];
+        for(;;){
+            ssize_t length = read(inotify_fd_, buffer, sizeof(buffer));
+            if(length <= 0){
+                return;
+            }
+            for(char* p = buffer; p < buffer + length;){
+                const struct inotify_event* event = (const struct inotify_event*)p;
+                p += sizeof(struct inotify_event) + event->len;
+                if(event->len == 0){
+                    continue;
+                }
+                for(size_t i = 0; i < files_.size(); i++){
+                    if(files_[i].directory_watch == event->wd && files_[i].name == event->name){
+                        add_once(changed, (int)i);
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    // Portable fallback
+    double now = now_seconds();
+    if(now < next_scan_){
+        return;
+    }
+    next_scan_ = now + FILE_WATCHER_SCAN_INTERVAL;
+    for(size_t i = 0; i < files_.size(); i++){
+        long long modified = modified_time(files_[i].directory + "/" + files_[i].name);
+        if(modified != 0 && modified != files_[i].modified){
+            files_[i].modified = modified;
+            add_once(changed, (int)i);
+        }
+    }
+}
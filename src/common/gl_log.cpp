@@ -0,0 +1,602 @@
+#include "gl_log.h"
+#include "gl_log_binary.h"
+#include "mmap_log_sink.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+namespace {
+
+// Records are split over fixed-size cells; the first cell starts with the
+// record length so the writer knows how many cells to consume.
+const size_t LOG_CELL_SIZE = 128;
+const size_t LOG_MAX_MESSAGE = 4096;
+const size_t LOG_BATCH_SIZE = 64 * 1024;
+const size_t LOG_FORMAT_TABLE_SIZE = 1024;
+
+struct alignas(64) LogCell {
+    std::atomic<size_t> sequence;
+    char data[LOG_CELL_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+const size_t LOG_CELL_PAYLOAD = sizeof(LogCell::data);
+
+struct Logger {
+    LogConfig config;
+    FILE* file = nullptr;
+    MmapLogSink mapped;
+    std::unique_ptr<LogCell[]> cells;
+    size_t mask = 0;
+
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+
+    std::atomic<bool> running{false};
+    std::atomic<bool> flush_requested{false};
+    std::thread writer;
+
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> lost{0};
+    std::atomic<uint64_t> backpressure_waits{0};
+    std::atomic<uint64_t> flushes{0};
+
+    ~Logger(){
+        gl_log_shutdown();
+    }
+};
+
+Logger g_logger;
+
+// Format strings seen in BINARY mode, keyed by address. Lookups are lock-free;
+// inserts take the mutex and enqueue the definition record before publishing
+// the key, so no event can reach the file ahead of its definition.
+struct LogFormatEntry {
+    std::atomic<const char*> format{nullptr};
+    uint32_t id = 0;
+    std::vector<LogArgType> args;
+};
+
+LogFormatEntry g_formats[LOG_FORMAT_TABLE_SIZE];
+std::mutex g_formats_mutex;
+uint32_t g_format_count = 0;
+
+bool sink_write(const char* data, size_t size){
+    Logger& g = g_logger;
+    if(g.config.sink == LogSink::MMAP){
+        return g.mapped.write(data, size);
+    }
+    return fwrite(data, 1, size, g.file) == size;
+}
+
+void sink_flush(){
+    Logger& g = g_logger;
+    if(g.config.sink == LogSink::MMAP){
+        g.mapped.flush();
+    } else {
+        fflush(g.file);
+    }
+}
+
+// Writes a batch of records and counts them as written or lost
+void write_batch(const std::vector<char>& batch, size_t used, size_t records){
+    Logger& g = g_logger;
+    if(sink_write(batch.data(), used)){
+        g.written.fetch_add(records, std::memory_order_relaxed);
+    } else {
+        g.lost.fetch_add(records, std::memory_order_relaxed);
+    }
+}
+
+size_t cells_for(size_t length){
+    return (sizeof(uint32_t) + length + LOG_CELL_PAYLOAD - 1) / LOG_CELL_PAYLOAD;
+}
+
+size_t round_up_pow2(size_t value){
+    size_t result = 1;
+    while(result < value){
+        result <<= 1;
+    }
+    return result;
+}
+
+// Multi-producer enqueue. A record spanning k cells is claimed in one CAS by
+// checking only the last cell: the writer frees cells strictly in order, so if
+// the last one is free for this lap all the earlier ones are too.
+bool enqueue_record(const char* text, size_t length, bool must_block = false){
+    Logger& g = g_logger;
+    if(!g.running.load(std::memory_order_acquire)){
+        return false;
+    }
+
+    size_t cells_needed = cells_for(length);
+    size_t pos = g.enqueue_pos.load(std::memory_order_relaxed);
+    bool waited = false;
+    for(;;){
+        size_t last = pos + cells_needed - 1;
+        size_t seq = g.cells[last & g.mask].sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)last;
+
+        if(diff == 0){
+            if(g.enqueue_pos.compare_exchange_weak(pos, pos + cells_needed, std::memory_order_relaxed)){
+                break;
+            }
+        } else if(diff < 0){
+            // Ring is full
+            if(g.config.overflow_policy == LogOverflowPolicy::DROP && !must_block){
+                g.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if(!waited){
+                g.backpressure_waits.fetch_add(1, std::memory_order_relaxed);
+                waited = true;
+            }
+            std::this_thread::yield();
+            pos = g.enqueue_pos.load(std::memory_order_relaxed);
+        } else {
+            pos = g.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Copy the length prefix and text across the claimed cells, then publish
+    uint32_t length32 = (uint32_t)length;
+    size_t offset = 0;
+    for(size_t i = 0; i < cells_needed; i++){
+        LogCell& cell = g.cells[(pos + i) & g.mask];
+        size_t room = LOG_CELL_PAYLOAD;
+        char* dst = cell.data;
+        if(i == 0){
+            memcpy(dst, &length32, sizeof(length32));
+            dst += sizeof(length32);
+            room -= sizeof(length32);
+        }
+        size_t chunk = length - offset < room ? length - offset : room;
+        memcpy(dst, text + offset, chunk);
+        offset += chunk;
+        cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+
+    g.enqueued.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void wait_for_cell(const LogCell& cell, size_t pos){
+    while(cell.sequence.load(std::memory_order_acquire) != pos + 1){
+        std::this_thread::yield();
+    }
+}
+
+// Single consumer. Copies every published record into the batch buffer,
+// releasing cells as it goes, and writes the batch with one fwrite.
+size_t drain_records(std::vector<char>& batch){
+    Logger& g = g_logger;
+    size_t pos = g.dequeue_pos.load(std::memory_order_relaxed);
+    size_t used = 0;
+    size_t records = 0;
+    size_t batched = 0;
+
+    for(;;){
+        LogCell& first = g.cells[pos & g.mask];
+        if(first.sequence.load(std::memory_order_acquire) != pos + 1){
+            break;
+        }
+
+        uint32_t length = 0;
+        memcpy(&length, first.data, sizeof(length));
+        if(used + length > batch.size()){
+            write_batch(batch, used, batched);
+            used = 0;
+            batched = 0;
+        }
+
+        size_t cells_needed = cells_for(length);
+        size_t offset = 0;
+        for(size_t i = 0; i < cells_needed; i++){
+            LogCell& cell = g.cells[(pos + i) & g.mask];
+            wait_for_cell(cell, pos + i);
+            const char* src = cell.data;
+            size_t room = LOG_CELL_PAYLOAD;
+            if(i == 0){
+                src += sizeof(uint32_t);
+                room -= sizeof(uint32_t);
+            }
+            size_t chunk = length - offset < room ? length - offset : room;
+            memcpy(batch.data() + used + offset, src, chunk);
+            offset += chunk;
+            cell.sequence.store(pos + i + g.mask + 1, std::memory_order_release);
+        }
+
+        used += length;
+        pos += cells_needed;
+        records++;
+        batched++;
+        g.dequeue_pos.store(pos, std::memory_order_release);
+    }
+
+    if(used > 0){
+        write_batch(batch, used, batched);
+    }
+    return records;
+}
+
+void writer_main(){
+    Logger& g = g_logger;
+    std::vector<char> batch(LOG_BATCH_SIZE);
+    std::chrono::steady_clock::time_point last_flush = std::chrono::steady_clock::now();
+    bool dirty = false;
+
+    for(;;){
+        bool stopping = !g.running.load(std::memory_order_acquire);
+        size_t records = drain_records(batch);
+        dirty = dirty || records > 0;
+
+        // Apply the flush policy
+        bool flush = false;
+        if(dirty){
+            switch(g.config.flush_policy){
+                case LogFlushPolicy::EVERY_BATCH:
+                    flush = true;
+                    break;
+                case LogFlushPolicy::INTERVAL:
+                    flush = std::chrono::steady_clock::now() - last_flush >=
+                        std::chrono::milliseconds(g.config.flush_interval_ms);
+                    break;
+                case LogFlushPolicy::ON_SHUTDOWN:
+                    break;
+            }
+        }
+        if(g.flush_requested.load(std::memory_order_acquire)){
+            flush = true;
+        }
+        if(flush){
+            sink_flush();
+            g.flushes.fetch_add(1, std::memory_order_relaxed);
+            last_flush = std::chrono::steady_clock::now();
+            dirty = false;
+            g.flush_requested.store(false, std::memory_order_release);
+        }
+
+        if(stopping &&
+           g.dequeue_pos.load(std::memory_order_relaxed) == g.enqueue_pos.load(std::memory_order_acquire)){
+            break;
+        }
+        if(records == 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+size_t format_slot(const char* format){
+    uintptr_t key = (uintptr_t)format;
+    return (size_t)((key >> 3) * 0x9E3779B97F4A7C15ull >> 32) & (LOG_FORMAT_TABLE_SIZE - 1);
+}
+
+const LogFormatEntry* find_format(const char* format){
+    size_t slot = format_slot(format);
+    for(size_t probe = 0; probe < LOG_FORMAT_TABLE_SIZE; probe++){
+        const LogFormatEntry& entry = g_formats[slot];
+        const char* key = entry.format.load(std::memory_order_acquire);
+        if(key == format){
+            return &entry;
+        }
+        if(!key){
+            return nullptr;
+        }
+        slot = (slot + 1) & (LOG_FORMAT_TABLE_SIZE - 1);
+    }
+    return nullptr;
+}
+
+// Returns the entry for format, registering it on first use. Formats that
+// cannot be deferred are registered with LOG_TEXT_ID; nullptr means the table
+// is full and the caller should log text.
+const LogFormatEntry* lookup_format(const char* format){
+    const LogFormatEntry* found = find_format(format);
+    if(found){
+        return found;
+    }
+
+    std::lock_guard<std::mutex> lock(g_formats_mutex);
+    found = find_format(format);
+    if(found){
+        return found;
+    }
+    if(g_format_count >= LOG_FORMAT_TABLE_SIZE * 3 / 4){
+        return nullptr;
+    }
+
+    size_t slot = format_slot(format);
+    while(g_formats[slot].format.load(std::memory_order_relaxed)){
+        slot = (slot + 1) & (LOG_FORMAT_TABLE_SIZE - 1);
+    }
+    LogFormatEntry& entry = g_formats[slot];
+    entry.id = LOG_TEXT_ID;
+    if(parse_log_format(format, entry.args)){
+        entry.id = g_format_count;
+
+        // Definition record: header + format text
+        char record[LOG_MAX_MESSAGE];
+        size_t length = strlen(format);
+        if(length > sizeof(record) - LOG_RECORD_HEADER_SIZE){
+            length = sizeof(record) - LOG_RECORD_HEADER_SIZE;
+        }
+        uint32_t id = entry.id | LOG_DEFINITION_BIT;
+        uint16_t length16 = (uint16_t)length;
+        memcpy(record, &id, sizeof(id));
+        memcpy(record + sizeof(id), &length16, sizeof(length16));
+        memcpy(record + LOG_RECORD_HEADER_SIZE, format, length);
+        // Preamble first: a segment the writer rotates to after this must
+        // carry the definition, as the record may land in it
+        if(g_logger.config.sink == LogSink::MMAP){
+            g_logger.mapped.append_preamble(record, LOG_RECORD_HEADER_SIZE + length);
+        }
+        enqueue_record(record, LOG_RECORD_HEADER_SIZE + length, true);
+    }
+    g_format_count++;
+    entry.format.store(format, std::memory_order_release);
+    return &entry;
+}
+
+// Copies the raw arguments behind a header; false if they do not fit
+bool pack_arguments(const LogFormatEntry& entry, va_list arguments, char* record, size_t& used){
+    const size_t limit = LOG_MAX_MESSAGE;
+    for(LogArgType type : entry.args){
+        char value[sizeof(int64_t)];
+        size_t size = sizeof(int64_t);
+        int64_t integer = 0;
+        switch(type){
+            case LogArgType::INT: {
+                int32_t v = va_arg(arguments, int);
+                size = sizeof(v);
+                memcpy(value, &v, size);
+                break;
+            }
+            case LogArgType::LONG: integer = va_arg(arguments, long); memcpy(value, &integer, size); break;
+            case LogArgType::LONG_LONG: integer = va_arg(arguments, long long); memcpy(value, &integer, size); break;
+            case LogArgType::SIZE: integer = (int64_t)va_arg(arguments, size_t); memcpy(value, &integer, size); break;
+            case LogArgType::INTMAX: integer = va_arg(arguments, intmax_t); memcpy(value, &integer, size); break;
+            case LogArgType::PTRDIFF: integer = va_arg(arguments, ptrdiff_t); memcpy(value, &integer, size); break;
+            case LogArgType::DOUBLE: {
+                double v = va_arg(arguments, double);
+                memcpy(value, &v, size);
+                break;
+            }
+            case LogArgType::POINTER: {
+                uint64_t v = (uint64_t)(uintptr_t)va_arg(arguments, void*);
+                memcpy(value, &v, size);
+                break;
+            }
+            case LogArgType::STRING: {
+                const char* text = va_arg(arguments, const char*);
+                if(!text){
+                    text = "(null)";
+                }
+                size_t length = strlen(text);
+                if(used + sizeof(uint16_t) + length > limit){
+                    return false;
+                }
+                uint16_t length16 = (uint16_t)length;
+                memcpy(record + used, &length16, sizeof(length16));
+                memcpy(record + used + sizeof(length16), text, length);
+                used += sizeof(length16) + length;
+                continue;
+            }
+        }
+        if(used + size > limit){
+            return false;
+        }
+        memcpy(record + used, value, size);
+        used += size;
+    }
+    return true;
+}
+
+bool log_binary(const char* message, va_list arguments){
+    char record[LOG_MAX_MESSAGE];
+    size_t used = LOG_RECORD_HEADER_SIZE;
+    uint32_t id = LOG_TEXT_ID;
+
+    const LogFormatEntry* entry = lookup_format(message);
+    bool packed = false;
+    if(entry && entry->id != LOG_TEXT_ID){
+        va_list copy;
+        va_copy(copy, arguments);
+        packed = pack_arguments(*entry, copy, record, used);
+        va_end(copy);
+        id = entry->id;
+    }
+
+    // Fall back to preformatted text for formats we cannot defer
+    if(!packed){
+        id = LOG_TEXT_ID;
+        int length = vsnprintf(record + LOG_RECORD_HEADER_SIZE, sizeof(record) - LOG_RECORD_HEADER_SIZE, message, arguments);
+        if(length < 0){
+            return false;
+        }
+        used = LOG_RECORD_HEADER_SIZE + length;
+        if(used >= sizeof(record)){
+            used = sizeof(record) - 1;
+        }
+    }
+
+    uint16_t length16 = (uint16_t)(used - LOG_RECORD_HEADER_SIZE);
+    memcpy(record, &id, sizeof(id));
+    memcpy(record + sizeof(id), &length16, sizeof(length16));
+    return enqueue_record(record, used);
+}
+
+bool log_formatted(const char* message, va_list arguments, bool echo_stderr){
+    // Errors are shown straight away, the file copy goes through the ring
+    if(echo_stderr){
+        va_list copy;
+        va_copy(copy, arguments);
+        vfprintf(stderr, message, copy);
+        va_end(copy);
+    }
+
+    if(g_logger.config.format == LogFormat::BINARY){
+        return log_binary(message, arguments);
+    }
+
+    char text[LOG_MAX_MESSAGE];
+    int length = vsnprintf(text, sizeof(text), message, arguments);
+    if(length < 0){
+        return false;
+    }
+    if((size_t)length >= sizeof(text)){
+        length = sizeof(text) - 1;
+    }
+    return enqueue_record(text, length);
+}
+
+}
+
+bool restart_gl_log(){
+    return restart_gl_log(LogConfig());
+}
+
+bool restart_gl_log(const LogConfig& config){
+    gl_log_shutdown();
+    Logger& g = g_logger;
+
+    // Handle IO
+    g.config = config;
+    if(config.sink == LogSink::MMAP){
+        // A whole writer batch must fit in one segment, next to the header
+        // and definitions binary segments start with
+        size_t min_size = config.format == LogFormat::BINARY ? 2 * LOG_BATCH_SIZE : LOG_BATCH_SIZE;
+        size_t segment_size = config.segment_size < min_size ? min_size : config.segment_size;
+        if(!g.mapped.open(config.path, segment_size, config.max_segments)){
+            return false;
+        }
+    } else {
+        g.file = fopen(config.path, "w");
+        if(!g.file){
+            fprintf(
+                stderr,
+                "ERROR: could not open GL_LOG_FILE log file %s for writing\n",
+                config.path
+            );
+            return false;
+        }
+    }
+
+    // Binary logs start with a magic and version for the decoder
+    if(config.format == LogFormat::BINARY){
+        uint32_t version = GL_LOG_BINARY_VERSION;
+        sink_write(GL_LOG_BINARY_MAGIC, strlen(GL_LOG_BINARY_MAGIC));
+        sink_write((const char*)&version, sizeof(version));
+        if(config.sink == LogSink::MMAP){
+            g.mapped.append_preamble(GL_LOG_BINARY_MAGIC, strlen(GL_LOG_BINARY_MAGIC));
+            g.mapped.append_preamble(&version, sizeof(version));
+        }
+    }
+
+    // Setup ring, it must hold at least one maximum sized record
+    size_t capacity = round_up_pow2(config.capacity);
+    if(capacity < cells_for(LOG_MAX_MESSAGE)){
+        capacity = round_up_pow2(cells_for(LOG_MAX_MESSAGE));
+    }
+    g.cells.reset(new LogCell[capacity]);
+    g.mask = capacity - 1;
+    for(size_t i = 0; i < capacity; i++){
+        g.cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    g.enqueue_pos.store(0, std::memory_order_relaxed);
+    g.dequeue_pos.store(0, std::memory_order_relaxed);
+    g.enqueued = g.written = g.dropped = g.lost = g.backpressure_waits = g.flushes = 0;
+
+    // Forget format ids from any previous binary log
+    for(size_t i = 0; i < LOG_FORMAT_TABLE_SIZE; i++){
+        g_formats[i].format.store(nullptr, std::memory_order_relaxed);
+    }
+    g_format_count = 0;
+
+    // Start background writer
+    g.running.store(true, std::memory_order_release);
+    g.writer = std::thread(writer_main);
+
+    // Obtain current time
+    time_t now = time(NULL);
+    char* date = ctime(&now);
+
+    // Initialise logfile with date
+    gl_log("[GL_LOG_FILE log. local time %s\n]", date);
+    return true;
+}
+
+bool gl_log(const char* message, ...){
+    // Handle variable arguments
+    va_list arguments;
+    va_start(arguments, message);
+    bool result = log_formatted(message, arguments, false);
+    va_end(arguments);
+    return result;
+}
+
+bool gl_log_error(const char* message, ...){
+    // Handle variable arguments
+    va_list arguments;
+    va_start(arguments, message);
+    bool result = log_formatted(message, arguments, true);
+    va_end(arguments);
+    return result;
+}
+
+void gl_log_flush(){
+    Logger& g = g_logger;
+    if(!g.running.load(std::memory_order_acquire)){
+        return;
+    }
+
+    // Wait for the writer to pass everything enqueued so far, then flush
+    size_t target = g.enqueue_pos.load(std::memory_order_acquire);
+    while(g.dequeue_pos.load(std::memory_order_acquire) < target){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    g.flush_requested.store(true, std::memory_order_release);
+    while(g.flush_requested.load(std::memory_order_acquire)){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void gl_log_shutdown(){
+    Logger& g = g_logger;
+    if(!g.writer.joinable()){
+        return;
+    }
+
+    // Writer drains whatever is left before exiting
+    g.flush_requested.store(true, std::memory_order_release);
+    g.running.store(false, std::memory_order_release);
+    g.writer.join();
+
+    // IO cleanup
+    if(g.file){
+        fclose(g.file);
+        g.file = nullptr;
+    }
+    g.mapped.close();
+}
+
+LogStats gl_log_stats(){
+    Logger& g = g_logger;
+    LogStats stats;
+    stats.enqueued = g.enqueued.load(std::memory_order_relaxed);
+    stats.written = g.written.load(std::memory_order_relaxed);
+    stats.dropped = g.dropped.load(std::memory_order_relaxed);
+    stats.lost = g.lost.load(std::memory_order_relaxed);
+    stats.backpressure_waits = g.backpressure_waits.load(std::memory_order_relaxed);
+    stats.flushes = g.flushes.load(std::memory_order_relaxed);
+    stats.rotations = g.mapped.rotations();
+    return stats;
+}
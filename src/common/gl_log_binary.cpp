@@ -0,0 +1,274 @@
+#include "gl_log_binary.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+enum class LengthModifier {
+    NONE, HH, H, L, LL, Z, J, T, LONG_DOUBLE,
+};
+
+struct ConversionSpec {
+    const char* begin;      // points at '%'
+    const char* end;        // one past the conversion character
+    int stars;              // '*' width/precision arguments before the value
+    LengthModifier length;
+    char conversion;
+};
+
+// Parses the conversion starting at format (which points at '%')
+bool parse_spec(const char* format, ConversionSpec& spec){
+    const char* p = format + 1;
+    spec.begin = format;
+    spec.stars = 0;
+    spec.length = LengthModifier::NONE;
+
+    // Flags
+    while(*p && strchr("-+ #0'", *p)){
+        p++;
+    }
+
+    // Width
+    if(*p == '*'){
+        spec.stars++;
+        p++;
+    }
+    while(*p >= '0' && *p <= '9'){
+        p++;
+    }
+
+    // Precision
+    if(*p == '.'){
+        p++;
+        if(*p == '*'){
+            spec.stars++;
+            p++;
+        }
+        while(*p >= '0' && *p <= '9'){
+            p++;
+        }
+    }
+
+    // Length modifier
+    switch(*p){
+        case 'h':
+            p++;
+            spec.length = LengthModifier::H;
+            if(*p == 'h'){
+                p++;
+                spec.length = LengthModifier::HH;
+            }
+            break;
+        case 'l':
+            p++;
+            spec.length = LengthModifier::L;
+            if(*p == 'l'){
+                p++;
+                spec.length = LengthModifier::LL;
+            }
+            break;
+        case 'z': p++; spec.length = LengthModifier::Z; break;
+        case 'j': p++; spec.length = LengthModifier::J; break;
+        case 't': p++; spec.length = LengthModifier::T; break;
+        case 'L': p++; spec.length = LengthModifier::LONG_DOUBLE; break;
+        default: break;
+    }
+
+    if(!*p){
+        return false;
+    }
+    spec.conversion = *p;
+    spec.end = p + 1;
+    return true;
+}
+
+// Maps a parsed conversion to the stored argument type
+bool value_type(const ConversionSpec& spec, LogArgType& type){
+    switch(spec.conversion){
+        case 'c':
+            if(spec.length != LengthModifier::NONE){
+                return false;
+            }
+            type = LogArgType::INT;
+            return true;
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            switch(spec.length){
+                case LengthModifier::NONE:
+                case LengthModifier::HH:
+                case LengthModifier::H:
+                    type = LogArgType::INT;
+                    return true;
+                case LengthModifier::L: type = LogArgType::LONG; return true;
+                case LengthModifier::LL: type = LogArgType::LONG_LONG; return true;
+                case LengthModifier::Z: type = LogArgType::SIZE; return true;
+                case LengthModifier::J: type = LogArgType::INTMAX; return true;
+                case LengthModifier::T: type = LogArgType::PTRDIFF; return true;
+                default: return false;
+            }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if(spec.length == LengthModifier::LONG_DOUBLE){
+                return false;
+            }
+            type = LogArgType::DOUBLE;
+            return true;
+        case 's':
+            if(spec.length != LengthModifier::NONE){
+                return false;
+            }
+            type = LogArgType::STRING;
+            return true;
+        case 'p':
+            type = LogArgType::POINTER;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Bounds-checked payload reader
+struct PayloadReader {
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+
+    template <typename T>
+    bool read(T& value){
+        if(offset + sizeof(T) > length){
+            return false;
+        }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+};
+
+// Formats a single conversion with its '*' arguments and value
+template <typename T>
+void append_formatted(std::string& out, const std::string& spec, const int* stars, int star_count, T value){
+    char buffer[1024];
+    int written = 0;
+    switch(star_count){
+        case 0: written = snprintf(buffer, sizeof(buffer), spec.c_str(), value); break;
+        case 1: written = snprintf(buffer, sizeof(buffer), spec.c_str(), stars[0], value); break;
+        default: written = snprintf(buffer, sizeof(buffer), spec.c_str(), stars[0], stars[1], value); break;
+    }
+    if(written > 0){
+        out.append(buffer, (size_t)written < sizeof(buffer) ? written : sizeof(buffer) - 1);
+    }
+}
+
+}
+
+bool parse_log_format(const char* format, std::vector<LogArgType>& args){
+    args.clear();
+    for(const char* p = format; *p; p++){
+        if(*p != '%'){
+            continue;
+        }
+        if(p[1] == '%'){
+            p++;
+            continue;
+        }
+
+        ConversionSpec spec;
+        LogArgType type;
+        if(!parse_spec(p, spec) || !value_type(spec, type)){
+            return false;
+        }
+        for(int i = 0; i < spec.stars; i++){
+            args.push_back(LogArgType::INT);
+        }
+        args.push_back(type);
+        p = spec.end - 1;
+    }
+    return true;
+}
+
+bool format_log_event(const char* format, const uint8_t* payload, size_t length, std::string& out){
+    PayloadReader reader = {payload, length, 0};
+
+    for(const char* p = format; *p; p++){
+        if(*p != '%'){
+            out.push_back(*p);
+            continue;
+        }
+        if(p[1] == '%'){
+            out.push_back('%');
+            p++;
+            continue;
+        }
+
+        ConversionSpec spec;
+        LogArgType type;
+        if(!parse_spec(p, spec) || !value_type(spec, type)){
+            return false;
+        }
+
+        int stars[2] = {0, 0};
+        for(int i = 0; i < spec.stars; i++){
+            int32_t star = 0;
+            if(!reader.read(star)){
+                return false;
+            }
+            stars[i] = star;
+        }
+
+        // Rebuild the spec with the widened C type the payload holds
+        std::string piece(spec.begin, spec.end - spec.begin);
+        int64_t integer = 0;
+        switch(type){
+            case LogArgType::INT: {
+                int32_t value = 0;
+                if(!reader.read(value)){
+                    return false;
+                }
+                append_formatted(out, piece, stars, spec.stars, (int)value);
+                break;
+            }
+            case LogArgType::LONG:
+            case LogArgType::LONG_LONG:
+            case LogArgType::SIZE:
+            case LogArgType::INTMAX:
+            case LogArgType::PTRDIFF: {
+                if(!reader.read(integer)){
+                    return false;
+                }
+                // Swap whatever length modifier was used for 'll'
+                size_t modifier = piece.find_first_of("lzjt");
+                size_t conversion = piece.size() - 1;
+                piece = piece.substr(0, modifier) + "ll" + piece.substr(conversion);
+                append_formatted(out, piece, stars, spec.stars, (long long)integer);
+                break;
+            }
+            case LogArgType::DOUBLE: {
+                double value = 0.0;
+                if(!reader.read(value)){
+                    return false;
+                }
+                append_formatted(out, piece, stars, spec.stars, value);
+                break;
+            }
+            case LogArgType::STRING: {
+                uint16_t size = 0;
+                if(!reader.read(size) || reader.offset + size > reader.length){
+                    return false;
+                }
+                std::string value((const char*)reader.data + reader.offset, size);
+                reader.offset += size;
+                append_formatted(out, piece, stars, spec.stars, value.c_str());
+                break;
+            }
+            case LogArgType::POINTER: {
+                uint64_t value = 0;
+                if(!reader.read(value)){
+                    return false;
+                }
+                append_formatted(out, piece, stars, spec.stars, (void*)(uintptr_t)value);
+                break;
+            }
+        }
+        p = spec.end - 1;
+    }
+    return true;
+}
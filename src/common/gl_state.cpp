@@ -0,0 +1,168 @@
+#include "gl_state.h"
+
+#include <string.h>
+
+namespace {
+
+// Never a name the driver hands out, so the first bind always goes through
+const GLuint UNKNOWN_NAME = 0xffffffffu;
+
+}
+
+void GlState::invalidate(){
+    program_ = UNKNOWN_NAME;
+    vao_ = UNKNOWN_NAME;
+    for(GLuint& buffer : buffers_){
+        buffer = UNKNOWN_NAME;
+    }
+    active_unit_ = MAX_TEXTURE_UNITS;
+    for(unsigned i = 0; i < MAX_TEXTURE_UNITS; i++){
+        texture_targets_[i] = GL_NONE;
+        textures_[i] = UNKNOWN_NAME;
+    }
+    viewport_[0] = viewport_[1] = 0;
+    viewport_[2] = viewport_[3] = -1;
+    clear_colour_known_ = false;
+    for(int8_t& capability : capabilities_){
+        capability = -1;
+    }
+    depth_func_ = GL_NONE;
+    depth_mask_ = -1;
+    blend_source_ = GL_NONE;
+    blend_destination_ = GL_NONE;
+}
+
+int GlState::buffer_slot(GLenum target){
+    switch(target){
+        case GL_ARRAY_BUFFER: return ARRAY_BUFFER;
+        case GL_ELEMENT_ARRAY_BUFFER: return ELEMENT_BUFFER;
+        case GL_DRAW_INDIRECT_BUFFER: return INDIRECT_BUFFER;
+        case GL_PIXEL_UNPACK_BUFFER: return UNPACK_BUFFER;
+        default: return -1;
+    }
+}
+
+int GlState::capability_slot(GLenum capability){
+    switch(capability){
+        case GL_DEPTH_TEST: return DEPTH_TEST;
+        case GL_BLEND: return BLEND;
+        case GL_CULL_FACE: return CULL_FACE;
+        case GL_SCISSOR_TEST: return SCISSOR_TEST;
+        default: return -1;
+    }
+}
+
+void GlState::use_program(GLuint program){
+    if(changed(program != program_)){
+        glUseProgram(program);
+        program_ = program;
+    }
+}
+
+void GlState::bind_vertex_array(GLuint vao){
+    if(changed(vao != vao_)){
+        glBindVertexArray(vao);
+        vao_ = vao;
+        buffers_[ELEMENT_BUFFER] = UNKNOWN_NAME;
+    }
+}
+
+void GlState::bind_buffer(GLenum target, GLuint buffer){
+    int slot = buffer_slot(target);
+    if(slot < 0){
+        frame_.issued++;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if(changed(buffer != buffers_[slot])){
+        glBindBuffer(target, buffer);
+        buffers_[slot] = buffer;
+    }
+}
+
+void GlState::bind_texture(unsigned unit, GLenum target, GLuint texture){
+    if(unit >= MAX_TEXTURE_UNITS){
+        frame_.issued += 2;
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        active_unit_ = MAX_TEXTURE_UNITS;
+        return;
+    }
+    // glActiveTexture and glBindTexture are counted separately; a redundant
+    // bind skips both
+    if(texture == textures_[unit] && target == texture_targets_[unit]){
+        frame_.filtered += 2;
+        return;
+    }
+    if(changed(unit != active_unit_)){
+        glActiveTexture(GL_TEXTURE0 + unit);
+        active_unit_ = unit;
+    }
+    frame_.issued++;
+    glBindTexture(target, texture);
+    texture_targets_[unit] = target;
+    textures_[unit] = texture;
+}
+
+void GlState::viewport(GLint x, GLint y, GLsizei width, GLsizei height){
+    GLint value[] = {x, y, width, height};
+    if(changed(memcmp(value, viewport_, sizeof(value)) != 0)){
+        glViewport(x, y, width, height);
+        memcpy(viewport_, value, sizeof(value));
+    }
+}
+
+void GlState::clear_colour(float red, float green, float blue, float alpha){
+    float value[] = {red, green, blue, alpha};
+    if(changed(!clear_colour_known_ || memcmp(value, clear_colour_, sizeof(value)) != 0)){
+        glClearColor(red, green, blue, alpha);
+        memcpy(clear_colour_, value, sizeof(value));
+        clear_colour_known_ = true;
+    }
+}
+
+void GlState::set_enabled(GLenum capability, bool enabled){
+    int slot = capability_slot(capability);
+    if(slot >= 0 && !changed(capabilities_[slot] != (int8_t)enabled)){
+        return;
+    }
+    if(slot < 0){
+        frame_.issued++;
+    } else {
+        capabilities_[slot] = (int8_t)enabled;
+    }
+    if(enabled){
+        glEnable(capability);
+    } else {
+        glDisable(capability);
+    }
+}
+
+void GlState::depth_func(GLenum func){
+    if(changed(func != depth_func_)){
+        glDepthFunc(func);
+        depth_func_ = func;
+    }
+}
+
+void GlState::depth_mask(bool write){
+    if(changed(depth_mask_ != (int8_t)write)){
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+        depth_mask_ = (int8_t)write;
+    }
+}
+
+void GlState::blend_func(GLenum source, GLenum destination){
+    if(changed(source != blend_source_ || destination != blend_destination_)){
+        glBlendFunc(source, destination);
+        blend_source_ = source;
+        blend_destination_ = destination;
+    }
+}
+
+void GlState::end_frame(){
+    total_.issued += frame_.issued;
+    total_.filtered += frame_.filtered;
+    last_frame_ = frame_;
+    frame_ = {0, 0};
+}
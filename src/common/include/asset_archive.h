@@ -0,0 +1,156 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Many assets packed into one file, little-endian, offsets from the start:
+//   AssetArchiveHeader
+//   entry data, each starting on ASSET_ARCHIVE_ALIGNMENT
+//   table of contents: slot_count AssetArchiveEntry, open addressing on
+//   the FNV-1a hash of the path, linear probing, empty slots have no name
+//   names: the NUL-terminated paths
+// Entries with identical contents share their data. Opening maps the file
+// and checks the table; reads of stored entries point into the mapping,
+// compressed ones are decoded into the blob.
+
+#define ASSET_ARCHIVE_EXTENSION ".pack"
+
+const char ASSET_ARCHIVE_MAGIC[4] = {'G', 'L', 'P', 'K'};
+const uint32_t ASSET_ARCHIVE_VERSION = 1;
+const size_t ASSET_ARCHIVE_ALIGNMENT = 64;
+
+enum class AssetCompression : uint32_t {
+    NONE,
+    LZ4,                                // raw LZ4 block, see lz4_block.h
+};
+
+struct AssetArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t slot_count;                // power of two
+    uint64_t toc_offset;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+struct AssetArchiveEntry {
+    uint64_t path_hash;                 // fnv1a of the normalized path
+    uint64_t content_hash;              // fnv1a of the uncompressed data
+    uint64_t offset;
+    uint64_t stored_size;               // bytes in the archive
+    uint64_t size;                      // bytes once decompressed
+    uint32_t name_offset;               // into the names
+    uint32_t name_length;               // 0 for an empty slot
+    uint32_t compression;               // AssetCompression
+    uint32_t reserved;
+};
+
+// What to pack: the file on disk and the path it is looked up by
+struct AssetSource {
+    std::string path;
+    std::string file;
+};
+
+struct AssetPackOptions {
+    bool compress = true;
+    float min_saving = 0.125f;          // stored raw unless LZ4 saves this much
+};
+
+struct AssetPackStats {
+    uint64_t entries;
+    uint64_t unique;                    // after merging identical contents
+    uint64_t compressed;
+    uint64_t bytes;                     // of the source files
+    uint64_t stored_bytes;              // of entry data in the archive
+    uint64_t archive_bytes;
+};
+
+// "./a//b/../c" -> "a/c"; the form paths are hashed and stored in
+std::string normalize_asset_path(const char* path);
+
+// Written to a temporary name and renamed, so readers never map a partial
+// archive
+bool write_asset_archive(
+    const char* path,
+    const AssetSource* sources,
+    size_t count,
+    const AssetPackOptions& options = AssetPackOptions(),
+    AssetPackStats* stats = nullptr
+);
+
+// An asset's bytes: a view into an archive mapping, a decompressed copy or
+// a mapped loose file. Not NUL terminated, like MappedFile.
+class AssetBlob {
+public:
+    AssetBlob() = default;
+    AssetBlob(AssetBlob&& other) noexcept;
+    AssetBlob& operator=(AssetBlob&& other) noexcept;
+    AssetBlob(const AssetBlob&) = delete;
+    AssetBlob& operator=(const AssetBlob&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Points at memory the caller keeps alive
+    void reference(const char* data, size_t size);
+    // Owned storage of size bytes to fill in
+    char* allocate(size_t size);
+    // Maps a loose file
+    bool map(const char* path);
+    void clear();
+
+private:
+    const char* data_ = "";
+    size_t size_ = 0;
+    std::vector<char> storage_;
+    MappedFile file_;
+};
+
+// A mapped, validated archive. Lookups and reads do not modify it, so any
+// number of threads may read at once.
+class AssetArchive {
+public:
+    // false for a missing, truncated, foreign or other-version file
+    bool open(const char* path);
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    // nullptr if the path is not in the archive
+    const AssetArchiveEntry* find(const char* path) const;
+    bool contains(const char* path) const { return find(path) != nullptr; }
+
+    // false if the path is missing or its data does not decode
+    bool read(const char* path, AssetBlob& out) const;
+    bool read(const AssetArchiveEntry& entry, AssetBlob& out) const;
+
+    // Decodes every entry and checks its content hash
+    bool verify() const;
+
+    // Occupied slots, in table order
+    const std::vector<const AssetArchiveEntry*>& entries() const { return entries_; }
+    const char* name(const AssetArchiveEntry& entry) const { return names_ + entry.name_offset; }
+    size_t size() const { return file_.size(); }
+
+private:
+    MappedFile file_;
+    const AssetArchiveHeader* header_ = nullptr;
+    const AssetArchiveEntry* slots_ = nullptr;
+    const char* names_ = nullptr;
+    std::vector<const AssetArchiveEntry*> entries_;
+};
+
+// The asset from archive if it has it, otherwise the loose file. archive
+// may be nullptr or closed.
+bool read_asset(const AssetArchive* archive, const char* path, AssetBlob& out);
+
+// Whether read_asset would find path, for optional assets that should not
+// report an error when missing
+bool asset_exists(const AssetArchive* archive, const char* path);
+
+#endif
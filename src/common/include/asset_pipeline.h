@@ -0,0 +1,156 @@
+#ifndef ASSET_PIPELINE_H
+#define ASSET_PIPELINE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_archive.h"
+#include "indexed_mesh.h"
+#include "mesh_file.h"
+
+class GlState;
+
+typedef uint32_t AssetHandle;
+
+enum class AssetStatus {
+    QUEUED,         // waiting for a worker
+    LOADING,        // being read and decoded on a worker
+    UPLOADING,      // decoded, waiting for or part way through its upload
+    READY,
+    FAILED,
+};
+
+struct AssetPipelineOptions {
+    size_t workers = 2;
+    size_t upload_bytes = 4 * 1024 * 1024;  // per update()
+    double upload_ms = 2.0;                 // per update()
+    size_t upload_chunk = 256 * 1024;       // largest single glBufferSubData
+};
+
+// Latency of one stage over every asset that went through it
+struct AssetStageStats {
+    uint64_t count;
+    double total_ms;
+    double max_ms;
+};
+
+struct AssetPipelineStats {
+    size_t queued;                  // waiting for a worker
+    size_t loading;                 // on a worker
+    size_t uploads;                 // decoded, not yet fully uploaded
+    size_t max_queued;
+    size_t max_uploads;
+    uint64_t ready;
+    uint64_t failed;
+    uint64_t uploaded_bytes;        // all updates
+    uint64_t frame_bytes;           // last update
+    double frame_ms;                // last update
+    AssetStageStats wait;           // request to a worker picking it up
+    AssetStageStats load;           // read, decompress, validate, fault in
+    AssetStageStats upload_wait;    // decoded to its first upload
+    AssetStageStats upload;         // first to last upload
+    AssetStageStats total;          // request to ready
+};
+
+// Loads assets without stalling the render thread. Workers read files
+// (from the archive when it has them), decompress, validate and fault the
+// data in; update() on the render thread then uploads decoded meshes into
+// the arena in chunks, stopping once the frame's byte or time budget is
+// spent, so a large mesh arrives over several frames rather than in one
+// long one. At least one chunk goes out per update so progress never stops.
+// Meshes are drawable once status() is READY and belong to the pipeline
+// until destroy(). Requests and update() come from one thread.
+class AssetPipeline {
+public:
+    AssetPipeline(
+        GlState& gl_state,
+        BufferArena& arena,
+        const AssetArchive* archive = nullptr,
+        const AssetPipelineOptions& options = AssetPipelineOptions()
+    );
+    ~AssetPipeline();
+
+    AssetPipeline(const AssetPipeline&) = delete;
+    AssetPipeline& operator=(const AssetPipeline&) = delete;
+
+    // A mesh file, uploaded into the arena
+    AssetHandle load_mesh(const char* path);
+    // Bytes for the caller, e.g. for its own decoding; nothing is uploaded
+    AssetHandle load_data(const char* path);
+
+    // Uploads within the frame budget; call once per frame
+    void update();
+
+    AssetStatus status(AssetHandle handle) const;
+    bool idle() const;
+
+    // nullptr until READY
+    const IndexedMesh* mesh(AssetHandle handle) const;
+    const MeshFileHeader* mesh_header(AssetHandle handle) const;
+    const AssetBlob* data(AssetHandle handle) const;
+
+    // Frees the meshes; GL context must be current. Stops the workers.
+    void destroy();
+
+    AssetPipelineStats stats() const;
+
+private:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    enum class AssetType {
+        MESH,
+        DATA,
+    };
+
+    struct Job {
+        std::string path;
+        AssetType type;
+        AssetStatus status = AssetStatus::QUEUED;
+        MeshFile file;
+        MeshFileHeader header;      // kept once the file is closed
+        AssetBlob blob;
+        IndexedMesh mesh;
+        bool allocated = false;
+        size_t uploaded = 0;        // vertex then index bytes
+        TimePoint requested;
+        TimePoint started;
+        TimePoint decoded;
+        TimePoint upload_started;
+    };
+
+    AssetHandle request(const char* path, AssetType type);
+    void work();
+    bool decode(Job& job);
+    // false once the budget is spent with the job unfinished
+    bool upload(Job& job, size_t& bytes, TimePoint frame_start);
+    void finish(Job& job, bool ready);
+    void stop();
+
+    GlState& gl_state_;
+    BufferArena& arena_;
+    const AssetArchive* archive_;
+    AssetPipelineOptions options_;
+    std::vector<std::unique_ptr<Job>> jobs_;
+
+    // Shared with the workers
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job*> queue_;
+    std::vector<Job*> decoded_;
+    bool stopping_ = false;
+    AssetPipelineStats stats_;
+
+    // Render thread only
+    std::deque<Job*> uploads_;
+    std::vector<std::thread> workers_;
+};
+
+#endif
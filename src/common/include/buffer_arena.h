@@ -0,0 +1,102 @@
+#ifndef BUFFER_ARENA_H
+#define BUFFER_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "tlsf_allocator.h"
+
+typedef uint32_t ArenaHandle;
+
+const ArenaHandle ARENA_NONE = 0xffffffffu;
+
+struct ArenaAllocation {
+    GLuint buffer;                  // 0 for a stale handle
+    size_t offset;
+    size_t size;
+};
+
+struct BufferArenaStats {
+    size_t pages;
+    size_t capacity;
+    size_t used;
+    size_t largest_free;
+    size_t allocations;
+    float fragmentation;            // 1 - largest free block / free bytes
+    uint64_t compactions;           // pages compacted
+    uint64_t moved_bytes;
+};
+
+// Static vertex and index data carved out of a few large GL buffers
+// ("pages") by a TlsfAllocator each, instead of one buffer per mesh.
+// Meshes in the same page share a buffer, so they share VAO and element
+// buffer bindings and can be drawn with base vertex offsets or one
+// multi-draw. A request larger than page_size gets a page of its own.
+//
+// compact() packs a fragmented page's live allocations to its start: they
+// are copied to a scratch buffer and back, so buffer names and VAOs stay
+// valid and only offsets move. Owners keep handles, and re-read their
+// allocation when generation() changes.
+//
+// Buffers are bound to GL_COPY_READ_BUFFER/GL_COPY_WRITE_BUFFER, which
+// GlState leaves alone. The destructor does not touch GL; destroy() before
+// the context goes.
+class BufferArena {
+public:
+    explicit BufferArena(size_t page_size = 4 * 1024 * 1024) : page_size_(page_size){}
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+    // alignment need not be a power of two, pass a vertex stride so that
+    // offset / stride is a base vertex; needs a current context
+    ArenaHandle allocate(size_t size, size_t alignment = 16);
+    void free(ArenaHandle handle);
+
+    // Writes size bytes at offset within the allocation
+    bool upload(ArenaHandle handle, const void* data, size_t size, size_t offset = 0);
+
+    ArenaAllocation get(ArenaHandle handle) const;
+
+    // Compacts pages whose fragmentation is at least min_fragmentation and
+    // releases empty pages; returns how many allocations moved
+    size_t compact(float min_fragmentation = 0.25f);
+
+    uint32_t generation() const { return generation_; }
+
+    // Deletes every page; handles are invalid after
+    void destroy();
+
+    BufferArenaStats stats() const;
+
+private:
+    struct Page {
+        GLuint buffer = 0;
+        size_t size = 0;
+        TlsfAllocator allocator;
+    };
+
+    struct Slot {
+        uint32_t page = 0;
+        TlsfBlock block = TLSF_NONE;    // TLSF_NONE when the slot is free
+        size_t size = 0;
+        size_t alignment = 0;
+    };
+
+    uint32_t new_page(size_t size);
+    size_t compact_page(uint32_t page);
+
+    size_t page_size_;
+    std::vector<std::unique_ptr<Page>> pages_;      // null once released
+    std::vector<Slot> slots_;
+    std::vector<ArenaHandle> free_slots_;
+    uint32_t generation_ = 0;
+    uint64_t compactions_ = 0;
+    uint64_t moved_bytes_ = 0;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef ERROR_REPORTER_H
+#define ERROR_REPORTER_H
+
+#include <stdint.h>
+
+#include "gl_log.h"
+#include "gl_log_filter.h"
+
+// Storm protection in front of gl_log_error. Each report is keyed by a hash
+// of its format string (plus an optional detail value, e.g. a GLFW error
+// code). The first report of a key in a window is written; repeats inside
+// the window only bump a counter and are later collapsed into one
+// "repeated N times" line. Reports that pass deduplication still spend a
+// token from their category's bucket, so a burst of distinct errors is
+// capped too.
+
+struct ErrorReportConfig {
+    double window_seconds = 1.0;        // dedup window per message template
+    double tokens_per_second = 10.0;    // sustained reports per category
+    double burst = 20.0;                // bucket size per category
+};
+
+struct ErrorReportStats {
+    uint64_t emitted;                   // reports written
+    uint64_t repeats;                   // collapsed into summaries
+    uint64_t throttled;                 // dropped by a token bucket
+    uint64_t summaries;                 // "repeated"/"throttled" lines written
+};
+
+void error_reporter_configure(const ErrorReportConfig& config);
+
+// printf-style; returns true if the message was written now
+bool report_error(LogCategory category, const char* message, ...) GL_LOG_PRINTF(2, 3);
+bool report_error_detail(LogCategory category, uint64_t detail, const char* message, ...) GL_LOG_PRINTF(3, 4);
+
+// Writes summaries for windows that have closed. Cheap when nothing is due,
+// call once per frame.
+void error_reporter_tick();
+
+// Writes every pending summary, e.g. before shutdown
+void error_reporter_flush();
+
+ErrorReportStats error_reporter_stats();
+
+#endif
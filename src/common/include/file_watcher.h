@@ -0,0 +1,39 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <vector>
+
+// Reports files that were modified since the last poll(). On Linux this uses
+// inotify on each file's directory, which also catches editors that save by
+// writing a new file and renaming it over the old one. Elsewhere it falls
+// back to comparing modification times, at most every 250 ms.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Returns an id for path (the same one if already watched), or -1 if it
+    // cannot be watched
+    int watch(const char* path);
+
+    // Non-blocking; appends the ids of changed files, each at most once
+    void poll(std::vector<int>& changed);
+
+private:
+    struct WatchedFile {
+        std::string directory;
+        std::string name;
+        int directory_watch = -1;
+        long long modified = 0;
+    };
+
+    std::vector<WatchedFile> files_;
+    int inotify_fd_ = -1;
+    double next_scan_ = 0.0;
+};
+
+#endif
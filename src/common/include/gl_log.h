@@ -0,0 +1,82 @@
+#ifndef GL_LOG_H
+#define GL_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GL_LOG_FILE "gl.log"
+
+#ifdef __GNUC__
+#define GL_LOG_PRINTF(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define GL_LOG_PRINTF(fmt, args)
+#endif
+
+// When the background writer flushes the log file
+enum class LogFlushPolicy {
+    EVERY_BATCH,    // after every drained batch of records
+    INTERVAL,       // at most once every flush_interval_ms
+    ON_SHUTDOWN,    // only on gl_log_flush() and gl_log_shutdown()
+};
+
+// How records are stored in the log file
+enum class LogFormat {
+    TEXT,           // formatted with vsnprintf on the calling thread
+    BINARY,         // format id + raw arguments, see gl_log_binary.h
+};
+
+// Where the writer thread puts records
+enum class LogSink {
+    STDIO,          // one persistent FILE handle at path
+    MMAP,           // mapped, preallocated segments path.NNNNNN, see mmap_log_sink.h
+};                  // (BINARY segments each start with the header and definitions)
+
+// What a producer does when the ring buffer is full
+enum class LogOverflowPolicy {
+    DROP,           // discard the record and count it
+    BLOCK,          // spin/yield until the writer frees space
+};
+
+struct LogConfig {
+    const char* path = GL_LOG_FILE;
+    size_t capacity = 4096;         // ring cells, rounded up to a power of two
+    LogFlushPolicy flush_policy = LogFlushPolicy::INTERVAL;
+    unsigned flush_interval_ms = 100;
+    LogOverflowPolicy overflow_policy = LogOverflowPolicy::DROP;
+    LogFormat format = LogFormat::TEXT;
+    LogSink sink = LogSink::STDIO;
+    size_t segment_size = 4 * 1024 * 1024;     // MMAP only, at least 64 KiB (128 KiB BINARY)
+    unsigned max_segments = 4;                  // MMAP only, bounds disk usage
+};
+
+struct LogStats {
+    uint64_t enqueued;              // records accepted into the ring
+    uint64_t written;               // records handed to the file
+    uint64_t dropped;               // records lost to a full ring
+    uint64_t lost;                  // records the file or segment refused
+    uint64_t backpressure_waits;    // times a producer had to wait for space
+    uint64_t flushes;               // flushes issued by the writer
+    uint64_t rotations;             // MMAP segments filled and rotated
+};
+
+// Truncates the log file, writes the date header and starts the writer thread
+bool restart_gl_log();
+bool restart_gl_log(const LogConfig& config);
+
+// printf-style logging. In TEXT mode the message is formatted on the calling
+// thread; in BINARY mode only the arguments are copied, so the format must be
+// a string literal (its address identifies it).
+bool gl_log(const char* message, ...) GL_LOG_PRINTF(1, 2);
+
+// Same as gl_log but also echoes the message to stderr immediately
+bool gl_log_error(const char* message, ...) GL_LOG_PRINTF(1, 2);
+
+// Blocks until everything logged so far is written and flushed
+void gl_log_flush();
+
+// Drains the ring, closes the file and joins the writer thread
+void gl_log_shutdown();
+
+LogStats gl_log_stats();
+
+#endif
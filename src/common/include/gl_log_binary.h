@@ -0,0 +1,45 @@
+#ifndef GL_LOG_BINARY_H
+#define GL_LOG_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Binary log layout:
+//   file header: GL_LOG_BINARY_MAGIC (8 bytes) + uint32 version
+//   records:     uint32 id + uint16 payload length + payload
+// A record whose id has LOG_DEFINITION_BIT set carries the format string for
+// that id and always precedes the first event using it. Event payloads are
+// the raw printf arguments in the order the format consumes them.
+
+#define GL_LOG_BINARY_FILE "gl.bin"
+#define GL_LOG_BINARY_MAGIC "GLLOGBIN"
+
+const uint32_t GL_LOG_BINARY_VERSION = 1;
+const uint32_t LOG_DEFINITION_BIT = 0x80000000u;
+const uint32_t LOG_TEXT_ID = 0x7fffffffu;       // payload is preformatted text
+const size_t LOG_RECORD_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint16_t);
+
+// How an argument is stored in an event payload. Integers wider than int are
+// widened to 64 bits so logs decode the same on LP64 and LLP64 builds.
+enum class LogArgType : uint8_t {
+    INT,            // int32
+    LONG,           // int64
+    LONG_LONG,      // int64
+    SIZE,           // uint64
+    INTMAX,         // int64
+    PTRDIFF,        // int64
+    DOUBLE,         // float64
+    STRING,         // uint16 length + bytes
+    POINTER,        // uint64
+};
+
+// Collects the argument types a printf format consumes, including '*' widths.
+// Returns false for formats that cannot be deferred (%n, long double, ...).
+bool parse_log_format(const char* format, std::vector<LogArgType>& args);
+
+// Rebuilds the text of one event from its format string and payload
+bool format_log_event(const char* format, const uint8_t* payload, size_t length, std::string& out);
+
+#endif
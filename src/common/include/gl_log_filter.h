@@ -0,0 +1,100 @@
+#ifndef GL_LOG_FILTER_H
+#define GL_LOG_FILTER_H
+
+#include <atomic>
+#include <stdint.h>
+
+#include "gl_log.h"
+
+// Level and category front end for gl_log. Use the GL_LOG_* macros rather
+// than calling gl_log directly so that arguments are only evaluated when the
+// message is actually going to be written:
+//   - levels below GL_LOG_MIN_LEVEL, or categories missing from
+//     GL_LOG_CATEGORIES, are discarded by `if constexpr` and emit no code
+//   - everything else costs one relaxed load and a branch when disabled at
+//     runtime with gl_log_set_level
+
+enum class LogLevel : uint8_t {
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF,
+};
+
+enum class LogCategory : uint8_t {
+    GL,
+    GLFW,
+    SHADER,
+    FRAME,
+    ASSET,
+    COUNT,
+};
+
+// Compile-time filters, override with e.g. -DGL_LOG_MIN_LEVEL=2 (INFO)
+#ifndef GL_LOG_MIN_LEVEL
+#define GL_LOG_MIN_LEVEL 0
+#endif
+
+#ifndef GL_LOG_CATEGORIES
+#define GL_LOG_CATEGORIES 0xffffffffu
+#endif
+
+constexpr LogLevel LOG_MIN_LEVEL = (LogLevel)GL_LOG_MIN_LEVEL;
+constexpr uint32_t LOG_CATEGORIES = GL_LOG_CATEGORIES;
+
+constexpr uint32_t log_category_bit(LogCategory category){
+    return 1u << (uint32_t)category;
+}
+
+constexpr bool log_compiled_in(LogLevel level, LogCategory category){
+    return level >= LOG_MIN_LEVEL &&
+        level != LogLevel::OFF &&
+        (LOG_CATEGORIES & log_category_bit(category)) != 0;
+}
+
+// Runtime thresholds per category, INFO by default
+inline std::atomic<uint8_t> g_log_levels[(int)LogCategory::COUNT] = {
+    {(uint8_t)LogLevel::INFO},
+    {(uint8_t)LogLevel::INFO},
+    {(uint8_t)LogLevel::INFO},
+    {(uint8_t)LogLevel::INFO},
+    {(uint8_t)LogLevel::INFO},
+};
+
+inline bool log_enabled(LogLevel level, LogCategory category){
+    return (uint8_t)level >= g_log_levels[(int)category].load(std::memory_order_relaxed);
+}
+
+inline void gl_log_set_level(LogCategory category, LogLevel level){
+    g_log_levels[(int)category].store((uint8_t)level, std::memory_order_relaxed);
+}
+
+inline void gl_log_set_level(LogLevel level){
+    for(int i = 0; i < (int)LogCategory::COUNT; i++){
+        g_log_levels[i].store((uint8_t)level, std::memory_order_relaxed);
+    }
+}
+
+// ERROR goes through gl_log_error so it is also echoed to stderr
+#define GL_LOG(level, category, ...)                                        \
+    do {                                                                    \
+        if constexpr(log_compiled_in(level, category)){                     \
+            if(log_enabled(level, category)){                               \
+                if constexpr(level == LogLevel::ERROR){                     \
+                    gl_log_error(__VA_ARGS__);                              \
+                } else {                                                    \
+                    gl_log(__VA_ARGS__);                                    \
+                }                                                           \
+            }                                                               \
+        }                                                                   \
+    } while(0)
+
+#define GL_LOG_TRACE(category, ...) GL_LOG(LogLevel::TRACE, LogCategory::category, __VA_ARGS__)
+#define GL_LOG_DEBUG(category, ...) GL_LOG(LogLevel::DEBUG, LogCategory::category, __VA_ARGS__)
+#define GL_LOG_INFO(category, ...) GL_LOG(LogLevel::INFO, LogCategory::category, __VA_ARGS__)
+#define GL_LOG_WARN(category, ...) GL_LOG(LogLevel::WARN, LogCategory::category, __VA_ARGS__)
+#define GL_LOG_ERROR(category, ...) GL_LOG(LogLevel::ERROR, LogCategory::category, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+struct GlStateCounters {
+    uint64_t issued;                // calls passed on to GL
+    uint64_t filtered;              // calls dropped as redundant
+};
+
+// Shadow copy of the GL state the draw loops touch. Every setter compares
+// against the last value it passed on and only calls GL when the value
+// differs, counting both outcomes per frame.
+//
+// The shadow is only right if all changes to the tracked state go through
+// it; call invalidate() after code that talks to GL directly, and after
+// deleting a bound object whose name the driver may hand out again.
+// The element array buffer is VAO state, so binding a different VAO
+// forgets it.
+class GlState {
+public:
+    static const unsigned MAX_TEXTURE_UNITS = 16;
+
+    GlState() { invalidate(); }
+
+    // Forgets everything, the next call of each kind goes to GL
+    void invalidate();
+
+    void use_program(GLuint program);
+    void bind_vertex_array(GLuint vao);
+
+    // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER and
+    // GL_PIXEL_UNPACK_BUFFER are shadowed; other targets are passed straight
+    // through. The copy targets are left to uploaders such as StreamBuffer.
+    void bind_buffer(GLenum target, GLuint buffer);
+
+    void bind_texture(unsigned unit, GLenum target, GLuint texture);
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void clear_colour(float red, float green, float blue, float alpha);
+
+    // GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE and GL_SCISSOR_TEST are
+    // shadowed; other capabilities are passed straight through
+    void set_enabled(GLenum capability, bool enabled);
+    void depth_func(GLenum func);
+    void depth_mask(bool write);
+    void blend_func(GLenum source, GLenum destination);
+
+    // Closes the frame's counters
+    void end_frame();
+
+    GlStateCounters frame() const { return last_frame_; }
+    GlStateCounters total() const { return total_; }
+
+private:
+    enum BufferSlot {
+        ARRAY_BUFFER,
+        ELEMENT_BUFFER,
+        INDIRECT_BUFFER,
+        UNPACK_BUFFER,
+        BUFFER_SLOTS,
+    };
+
+    enum CapabilitySlot {
+        DEPTH_TEST,
+        BLEND,
+        CULL_FACE,
+        SCISSOR_TEST,
+        CAPABILITY_SLOTS,
+    };
+
+    static int buffer_slot(GLenum target);
+    static int capability_slot(GLenum capability);
+
+    // true when the call has to be issued
+    bool changed(bool differs){
+        if(differs){
+            frame_.issued++;
+        } else {
+            frame_.filtered++;
+        }
+        return differs;
+    }
+
+    GLuint program_;
+    GLuint vao_;
+    GLuint buffers_[BUFFER_SLOTS];
+    unsigned active_unit_;
+    GLenum texture_targets_[MAX_TEXTURE_UNITS];
+    GLuint textures_[MAX_TEXTURE_UNITS];
+    GLint viewport_[4];
+    float clear_colour_[4];
+    bool clear_colour_known_;
+    int8_t capabilities_[CAPABILITY_SLOTS];     // -1 unknown, 0 off, 1 on
+    GLenum depth_func_;
+    int8_t depth_mask_;
+    GLenum blend_source_;
+    GLenum blend_destination_;
+
+    GlStateCounters frame_ = {0, 0};
+    GlStateCounters last_frame_ = {0, 0};
+    GlStateCounters total_ = {0, 0};
+};
+
+#endif
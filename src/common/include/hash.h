@@ -0,0 +1,30 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 64-bit FNV-1a. constexpr so string keys can be hashed at compile time.
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+constexpr uint64_t fnv1a(const char* text, uint64_t hash = FNV_OFFSET_BASIS){
+    for(; *text; text++){
+        hash = (hash ^ (unsigned char)*text) * FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS){
+    const unsigned char* bytes = (const unsigned char*)data;
+    for(size_t i = 0; i < size; i++){
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t hash_combine(uint64_t hash, uint64_t value){
+    return fnv1a(&value, sizeof(value), hash);
+}
+
+#endif
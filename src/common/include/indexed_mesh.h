@@ -0,0 +1,85 @@
+#ifndef INDEXED_MESH_H
+#define INDEXED_MESH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "buffer_arena.h"
+#include "mesh_file.h"
+#include "vertex_format.h"
+
+class GlState;
+
+// Vertices and indices carved out of a BufferArena plus a VAO over them.
+// The VAO points at the start of the arena page, so meshes of one format
+// in the same page could share it; draws offset into the page with
+// base_vertex and first_index. Indices are stored as 16-bit when every
+// vertex fits, halving the index data.
+struct IndexedMesh {
+    GLuint vao = 0;
+    GLuint vbo = 0;                 // arena page buffers
+    GLuint ibo = 0;
+    GLsizei index_count = 0;
+    GLenum index_type = GL_UNSIGNED_INT;
+    GLint first_index = 0;
+    GLint base_vertex = 0;
+    size_t vertex_count = 0;
+    VertexFormat format;
+    BufferArena* arena = nullptr;
+    ArenaHandle vertices = ARENA_NONE;
+    ArenaHandle indices = ARENA_NONE;
+    uint32_t generation = 0;        // arena generation the offsets were read at
+};
+
+bool upload_indexed_mesh(
+    GlState& gl_state,
+    BufferArena& arena,
+    const VertexFormat& format,
+    const void* vertices,
+    size_t vertex_count,
+    const uint32_t* indices,
+    size_t index_count,
+    IndexedMesh& mesh
+);
+
+// Indices already in index_type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT),
+// uploaded as they are
+bool upload_indexed_mesh(
+    GlState& gl_state,
+    BufferArena& arena,
+    const VertexFormat& format,
+    const void* vertices,
+    size_t vertex_count,
+    const void* indices,
+    GLenum index_type,
+    size_t index_count,
+    IndexedMesh& mesh
+);
+
+// Reserves the arena ranges and fills in the mesh's layout without
+// uploading anything, for callers that stream the data in with
+// BufferArena::upload; finish with refresh_indexed_mesh and create_mesh_vao
+bool allocate_indexed_mesh(
+    BufferArena& arena,
+    const VertexFormat& format,
+    size_t vertex_count,
+    GLenum index_type,
+    size_t index_count,
+    IndexedMesh& mesh
+);
+
+// Uploads straight from the file's mapping; the whole index blob becomes
+// one range, submeshes draw at first_index/base_vertex relative to it
+bool upload_mesh_file(GlState& gl_state, BufferArena& arena, const MeshFile& file, IndexedMesh& mesh);
+
+// Re-reads the offsets after the arena was compacted; true if they moved
+bool refresh_indexed_mesh(IndexedMesh& mesh);
+
+// Another VAO over the mesh's buffers, e.g. one to add instance attributes to
+GLuint create_mesh_vao(GlState& gl_state, const IndexedMesh& mesh);
+
+void destroy_indexed_mesh(IndexedMesh& mesh);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef INSTANCING_H
+#define INSTANCING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+class GlState;
+class StreamBuffer;
+
+// Attribute locations the instanced shaders read per-instance data from
+const GLuint INSTANCE_TRANSFORM_LOCATION = 1;
+const GLuint INSTANCE_COLOUR_LOCATION = 2;
+
+struct InstanceData {
+    float transform[4];             // x, y, z offset and uniform scale
+    float colour[4];
+};
+
+// A mesh as drawn by the lessons: a VAO with its vertex attributes set up
+struct InstancedMesh {
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;              // vertices, or indices when index_type is set
+    GLenum index_type = 0;          // 0 for glDrawArraysInstanced
+    GLint first = 0;                // first vertex, or first index
+    GLint base_vertex = 0;
+};
+
+struct InstanceStats {
+    uint64_t instances;             // drawn last frame
+    uint64_t groups;                // distinct mesh/program pairs
+    uint64_t draw_calls;
+};
+
+// Collects instances for a frame and draws each mesh/program pair with one
+// glDraw*Instanced call. All instance data is written into one allocation
+// from a StreamBuffer; the mesh VAO gets divisor-1 attributes at
+// INSTANCE_TRANSFORM_LOCATION/INSTANCE_COLOUR_LOCATION pointing at its
+// group's slice. Groups that get no instances in a frame are dropped at
+// its submit().
+class InstanceRenderer {
+public:
+    explicit InstanceRenderer(StreamBuffer& stream) : stream_(stream){}
+
+    InstanceRenderer(const InstanceRenderer&) = delete;
+    InstanceRenderer& operator=(const InstanceRenderer&) = delete;
+
+    void add(GLuint program, const InstancedMesh& mesh, const InstanceData& instance);
+
+    // Uploads the frame's instances, draws every group and clears them
+    void submit(GlState& gl_state);
+
+    InstanceStats stats() const { return stats_; }
+
+private:
+    struct Group {
+        uint64_t key;               // in group_index_
+        GLuint program;
+        InstancedMesh mesh;
+        std::vector<InstanceData> instances;
+    };
+
+    void prepare_vao(GlState& gl_state, GLuint vao);
+    void prune();
+
+    std::vector<Group> groups_;
+    std::unordered_map<uint64_t, size_t> group_index_;      // program/VAO/range -> groups_
+    std::vector<GLuint> prepared_vaos_;
+    StreamBuffer& stream_;
+    InstanceStats stats_ = {0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef LZ4_BLOCK_H
+#define LZ4_BLOCK_H
+
+#include <stddef.h>
+
+// Raw LZ4 block format (no frame, no checksums), so data packed here can
+// also be read by the reference library. The compressor is the greedy
+// single-probe kind: fast, a ratio close to lz4's default level.
+
+// Largest compressed size of size input bytes
+size_t lz4_compress_bound(size_t size);
+
+// Largest decompressed size of size compressed bytes: a match length byte
+// of 255 is the most one input byte can expand to
+size_t lz4_decompress_bound(size_t size);
+
+// Returns the compressed size, or 0 if it does not fit in capacity
+size_t lz4_compress(const void* source, size_t size, void* destination, size_t capacity);
+
+// Decodes exactly size bytes; false for corrupt or truncated input, which
+// never reads or writes out of bounds
+bool lz4_decompress(const void* source, size_t source_size, void* destination, size_t size);
+
+#endif
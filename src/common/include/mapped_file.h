@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file. The contents are not NUL
+// terminated; pass data()/size() on together (e.g. to glShaderSource with an
+// explicit length). data() is never null, empty or failed opens give "".
+// The mapping is released when the object is destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char* path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Replaces any current mapping; false if the file cannot be opened
+    bool open(const char* path);
+    void close();
+
+    // True for successfully opened files, including empty ones
+    bool is_open() const { return open_; }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = "";
+    size_t size_ = 0;
+    bool open_ = false;
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "asset_archive.h"
+#include "vertex_format.h"
+
+// Binary mesh layout, little-endian, offsets from the start of the file:
+//   MeshFileHeader, with the vertex format inline
+//   vertex blob:  vertex_count * stride bytes, as uploaded
+//   index blob:   index_count 16- or 32-bit indices, as uploaded
+//   submesh table: submesh_count MeshFileSubmesh
+// Every blob starts on MESH_FILE_ALIGNMENT. Loading validates sizes and
+// offsets and hands the mapped blobs to GL; nothing is parsed or copied.
+
+#define MESH_FILE_EXTENSION ".mesh"
+
+const char MESH_FILE_MAGIC[4] = {'G', 'L', 'M', 'S'};
+const uint32_t MESH_FILE_VERSION = 1;
+const size_t MESH_FILE_ALIGNMENT = 64;
+
+struct MeshFileAttribute {
+    uint32_t location;
+    uint32_t components;
+    uint32_t type;                      // GLenum
+    uint32_t normalized;
+    uint32_t offset;
+};
+
+struct MeshFileSubmesh {
+    uint32_t first_index;               // into the index blob
+    uint32_t index_count;
+    int32_t base_vertex;
+    uint32_t material;                  // caller-defined
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t stride;
+    uint32_t attribute_count;
+    MeshFileAttribute attributes[VertexFormat::MAX_ATTRIBUTES];
+    uint32_t index_type;                // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t submesh_count;
+    uint64_t vertex_count;
+    uint64_t index_count;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+    uint64_t submesh_offset;
+    float bounds_min[3];
+    float bounds_max[3];
+    float position_decode[4];           // see CompressedVertices
+};
+
+// What write_mesh_file stores; indices are already index_type
+struct MeshFileData {
+    VertexFormat format;
+    const void* vertices = nullptr;
+    size_t vertex_count = 0;
+    const void* indices = nullptr;
+    size_t index_count = 0;
+    GLenum index_type = GL_UNSIGNED_INT;
+    const MeshFileSubmesh* submeshes = nullptr;
+    size_t submesh_count = 0;
+    float bounds_min[3] = {0.0f, 0.0f, 0.0f};
+    float bounds_max[3] = {0.0f, 0.0f, 0.0f};
+    float position_decode[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+};
+
+// Written to a temporary name and renamed, so readers never map a partial
+// file
+bool write_mesh_file(const char* path, const MeshFileData& data);
+
+// A mapped (or decompressed, from an archive) and validated mesh file. The
+// pointers stay valid while it is open.
+class MeshFile {
+public:
+    // false for a missing, truncated, foreign or other-version file; read
+    // from archive when it holds path
+    bool open(const char* path, const AssetArchive* archive = nullptr);
+    void close();
+
+    const MeshFileHeader& header() const { return *header_; }
+    VertexFormat format() const;
+
+    const void* vertices() const { return data_.data() + header_->vertex_offset; }
+    size_t vertex_bytes() const { return header_->vertex_count * header_->stride; }
+    const void* indices() const { return data_.data() + header_->index_offset; }
+    size_t index_bytes() const;
+    const MeshFileSubmesh* submeshes() const;
+    size_t size() const { return data_.size(); }
+
+private:
+    AssetBlob data_;
+    const MeshFileHeader* header_ = nullptr;
+};
+
+#endif
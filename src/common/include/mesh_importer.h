@@ -0,0 +1,66 @@
+#ifndef MESH_IMPORTER_H
+#define MESH_IMPORTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Indexed triangle mesh as separate, tightly packed float streams; feeds
+// VertexStreams (stride 0), optimize_mesh and upload_indexed_mesh
+struct ImportedMesh {
+    std::vector<float> positions;       // xyz
+    std::vector<float> normals;         // xyz, empty if the file has none
+    std::vector<float> uvs;             // uv, empty if the file has none
+    std::vector<uint32_t> indices;      // triangles; polygons are fanned
+
+    size_t vertex_count() const { return positions.size() / 3; }
+};
+
+struct MeshImportOptions {
+    unsigned threads = 0;               // 0 for one per core
+    size_t min_chunk_size = 256 * 1024; // bytes of text per parsing task
+};
+
+struct MeshImportStats {
+    size_t bytes;
+    unsigned threads;
+    size_t chunks;
+    double parse_ms;                    // tokenizing and number parsing
+    double build_ms;                    // merging chunks, welding OBJ corners
+};
+
+// Loads an OBJ (v, vt, vn, f; everything else ignored) or PLY (ascii or
+// binary, vertex x/y/z with optional nx/ny/nz and u/v or s/t, face vertex
+// index lists) by extension. The file is mapped, not read; the text is
+// cut at line ends into chunks parsed in parallel, then merged. OBJ
+// corners are welded into unique position/uv/normal vertices in parallel
+// shards. Numbers are parsed without strtod or locales.
+bool import_mesh(
+    const char* path,
+    ImportedMesh& mesh,
+    const MeshImportOptions& options = MeshImportOptions(),
+    MeshImportStats* stats = nullptr
+);
+
+bool import_obj(
+    const char* data,
+    size_t size,
+    ImportedMesh& mesh,
+    const MeshImportOptions& options = MeshImportOptions(),
+    MeshImportStats* stats = nullptr
+);
+
+bool import_ply(
+    const char* data,
+    size_t size,
+    ImportedMesh& mesh,
+    const MeshImportOptions& options = MeshImportOptions(),
+    MeshImportStats* stats = nullptr
+);
+
+// Decimal float at cursor, which is advanced past it; leading blanks are
+// skipped. Exact for up to 19 significant digits and small exponents,
+// within a unit in the last place of a double otherwise.
+bool parse_float(const char*& cursor, const char* end, float& value);
+
+#endif
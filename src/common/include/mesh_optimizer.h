@@ -0,0 +1,53 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// CPU-side mesh preparation, usable offline or at load time. Vertices are
+// opaque blobs of stride bytes; indices describe triangle lists.
+
+// Post-transform cache size the optimizer and ACMR model assume
+const size_t VERTEX_CACHE_SIZE = 32;
+
+struct MeshOptimizeReport {
+    size_t vertices_before;
+    size_t vertices_after;
+    float acmr_before;              // average cache misses per triangle
+    float acmr_after;
+};
+
+// Builds an index buffer over unique vertices (byte-wise equality).
+// Returns the unique vertex count.
+size_t deduplicate_vertices(
+    const void* vertices,
+    size_t vertex_count,
+    size_t stride,
+    std::vector<unsigned char>& unique,
+    std::vector<uint32_t>& indices
+);
+
+// Reorders triangles for the post-transform vertex cache (Forsyth's
+// linear-speed algorithm)
+void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+// Reorders vertices in the order the indices first use them and drops
+// unused ones, for vertex fetch locality. Returns the new vertex count.
+size_t optimize_vertex_fetch(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count);
+
+// Misses per triangle of a FIFO cache of cache_size; 0.5 is ideal for a
+// regular grid, 3.0 means no reuse at all
+float compute_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, size_t cache_size = VERTEX_CACHE_SIZE);
+
+// All of the above on an unindexed triangle list: dedup, cache order,
+// fetch order
+MeshOptimizeReport optimize_mesh(
+    const void* vertices,
+    size_t vertex_count,
+    size_t stride,
+    std::vector<unsigned char>& out_vertices,
+    std::vector<uint32_t>& out_indices
+);
+
+#endif
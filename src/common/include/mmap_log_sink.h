@@ -0,0 +1,80 @@
+#ifndef MMAP_LOG_SINK_H
+#define MMAP_LOG_SINK_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Size-bounded log sink. Each segment file is preallocated to segment_size
+// and mapped; writers reserve space with an atomic cursor and memcpy straight
+// into the mapping. When a segment fills up the sink moves to the next
+// numbered file (path.000000, path.000001, ...) and deletes the oldest so at
+// most max_segments files exist. Closed segments are trimmed to their data.
+// Every new segment starts with a copy of the preamble, so a format that
+// needs a header or definitions before its records still decodes after the
+// first segment is deleted.
+class MmapLogSink {
+public:
+    MmapLogSink() = default;
+    ~MmapLogSink();
+
+    MmapLogSink(const MmapLogSink&) = delete;
+    MmapLogSink& operator=(const MmapLogSink&) = delete;
+
+    // Removes old segments for path and maps the first one
+    bool open(const char* path, size_t segment_size, unsigned max_segments);
+
+    // Thread-safe; records larger than a segment (less its preamble) are
+    // rejected. If the next segment cannot be mapped the record is refused,
+    // the full one stays current and the next write tries again.
+    bool write(const void* data, size_t size);
+
+    // Adds to what each later segment starts with; the data is expected to
+    // be written to the current segment through write() as usual. A
+    // preamble over half a segment is no longer copied.
+    void append_preamble(const void* data, size_t size);
+
+    // Schedules write-back of the current segment (msync MS_ASYNC)
+    void flush();
+
+    // Unmaps and trims the current segment
+    void close();
+
+    uint64_t rotations() const { return rotations_.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment {
+        char* base = nullptr;
+        size_t size = 0;
+        int fd = -1;
+        uint64_t index = 0;
+        size_t start = 0;                   // preamble bytes
+        std::atomic<size_t> cursor{0};      // next reservation offset
+        std::atomic<size_t> end{0};         // end of the last record that fit
+        std::atomic<int> writers{0};        // writers currently copying
+    };
+
+    std::string segment_path(uint64_t index) const;
+    Segment* map_segment(uint64_t index);
+    void retire_segment(Segment* segment);
+    // false if the next segment could not be mapped
+    bool rotate(Segment* full);
+
+    std::string path_;
+    size_t segment_size_ = 0;
+    unsigned max_segments_ = 0;
+
+    std::atomic<Segment*> current_{nullptr};
+    std::mutex rotate_mutex_;
+    std::string preamble_;                  // guarded by rotate_mutex_
+    bool preamble_dropped_ = false;
+    bool map_failing_ = false;              // reported once until a map works
+    std::vector<std::unique_ptr<Segment>> segments_;
+    std::atomic<uint64_t> rotations_{0};
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SortEntry {
+    uint64_t key;
+    uint32_t index;             // payload, e.g. position in an item array
+};
+
+// Stable LSD radix sort on the 64-bit key, 11 bits per pass. All digit
+// histograms are built in one read of the input and passes whose digit is
+// the same for every key are skipped, so keys that only vary in a few
+// fields cost a few passes. scratch must hold count entries; the result
+// ends up in entries.
+void radix_sort(SortEntry* entries, SortEntry* scratch, size_t count);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "radix_sort.h"
+#include "uniform_ring.h"
+
+class GlState;
+
+// Sort key fields, most significant first. Items are drawn in ascending key
+// order: layer, then program, material and VAO so equal state is adjacent,
+// then depth. Fields wider than their bits are masked, which only costs
+// grouping, never correctness.
+const unsigned SORT_LAYER_BITS = 4;
+const unsigned SORT_PROGRAM_BITS = 12;
+const unsigned SORT_MATERIAL_BITS = 12;
+const unsigned SORT_VAO_BITS = 12;
+const unsigned SORT_DEPTH_BITS = 24;
+
+// depth in [0, 1]; pass 1 - depth for back-to-front layers
+inline uint64_t draw_sort_key(unsigned layer, GLuint program, unsigned material, GLuint vao, float depth){
+    depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+    uint64_t quantised = (uint64_t)(depth * (float)((1u << SORT_DEPTH_BITS) - 1));
+
+    uint64_t key = layer & ((1ull << SORT_LAYER_BITS) - 1);
+    key = (key << SORT_PROGRAM_BITS) | (program & ((1ull << SORT_PROGRAM_BITS) - 1));
+    key = (key << SORT_MATERIAL_BITS) | (material & ((1ull << SORT_MATERIAL_BITS) - 1));
+    key = (key << SORT_VAO_BITS) | (vao & ((1ull << SORT_VAO_BITS) - 1));
+    key = (key << SORT_DEPTH_BITS) | quantised;
+    return key;
+}
+
+struct DrawItem {
+    uint64_t key = 0;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint texture = 0;                 // unit 0, GL_TEXTURE_2D; 0 for none
+    GLenum mode = GL_TRIANGLES;
+    GLenum index_type = 0;              // 0 for glDrawArrays
+    GLint first = 0;                    // first vertex, or first index
+    GLint base_vertex = 0;              // added to every index
+    GLsizei count = 0;
+    size_t constants_offset = SIZE_MAX; // ObjectConstants range in the ring
+    size_t constants_size = 0;
+};
+
+struct RenderQueueStats {
+    uint64_t items;                     // submitted last frame
+    double sort_ms;                     // last sort
+    double submit_ms;                   // last submit, CPU side
+};
+
+// Draws collected for a frame, radix-sorted by key and submitted through
+// the state tracker so only real state changes reach GL.
+class RenderQueue {
+public:
+    void clear(){
+        items_.clear();
+        sorted_ = false;
+    }
+
+    void push(const DrawItem& item){
+        items_.push_back(item);
+        sorted_ = false;
+    }
+
+    size_t size() const { return items_.size(); }
+
+    // Orders the items by key; submit() sorts if this was not called
+    void sort();
+
+    // Issues the draws; object constants are bound to binding from ring
+    void submit(GlState& gl_state, UniformRing* ring = nullptr, GLuint binding = OBJECT_BLOCK_BINDING);
+
+    // Sorted order, valid after sort()
+    const SortEntry* order() const { return order_.data(); }
+
+    const DrawItem& item(size_t index) const { return items_[index]; }
+
+    RenderQueueStats stats() const { return stats_; }
+
+private:
+    std::vector<DrawItem> items_;
+    std::vector<SortEntry> order_;
+    std::vector<SortEntry> scratch_;
+    bool sorted_ = false;
+    RenderQueueStats stats_ = {0, 0.0, 0.0};
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+class ProgramBinaryCache;
+
+// One stage of a program; length -1 means source is NUL-terminated
+struct ShaderSource {
+    GLenum type;
+    const char* source;
+    GLint length;
+};
+
+GLuint compile_shader(GLenum type, const char* source, GLint length);
+
+// Links the shaders into a new program; retrievable sets the binary hint
+GLuint link_program(const GLuint* shaders, size_t count, bool retrievable);
+
+// Report compile/link failures with the GL info log; false on failure
+bool check_shader_for_errors(GLuint shader);
+bool check_program_for_errors(GLuint program);
+
+// Compiles and links sources, going through cache when one is given.
+// Returns 0 if any stage fails to compile or the program fails to link.
+GLuint build_program(const ShaderSource* sources, size_t count, ProgramBinaryCache* cache);
+
+#endif
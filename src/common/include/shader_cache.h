@@ -0,0 +1,51 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+#define SHADER_CACHE_DIR "shader_cache"
+
+struct ProgramCacheStats {
+    uint64_t hits;          // programs restored with glProgramBinary
+    uint64_t misses;        // no cache file for the key
+    uint64_t rejected;      // file present but stale, corrupt or refused by the driver
+    uint64_t stored;        // binaries written after a fresh link
+};
+
+// On-disk cache of linked program binaries. Keys hash every stage's type
+// and source together with GL_RENDERER and GL_VERSION, so a driver update
+// never feeds an old binary to glProgramBinary; if the driver still refuses
+// a binary the file is dropped and the caller compiles from source.
+// Construct after the GL context is current.
+class ProgramBinaryCache {
+public:
+    explicit ProgramBinaryCache(const char* directory = SHADER_CACHE_DIR);
+
+    // False when the context exposes no program binary formats
+    bool supported() const { return supported_; }
+
+    uint64_t key(const ShaderSource* sources, size_t count) const;
+
+    // Returns a linked program or 0 on a miss
+    GLuint load(uint64_t key);
+
+    bool store(uint64_t key, GLuint program);
+
+    ProgramCacheStats stats() const { return stats_; }
+
+private:
+    std::string path_for(uint64_t key) const;
+
+    std::string directory_;
+    uint64_t driver_hash_ = 0;
+    bool supported_ = false;
+    ProgramCacheStats stats_ = {0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "shader.h"
+
+class ProgramBinaryCache;
+
+typedef uint32_t ProgramHandle;
+
+enum class ProgramStatus {
+    PENDING,        // compiling/linking in the driver
+    READY,
+    FAILED,
+};
+
+struct ShaderCompilerStats {
+    uint64_t submitted;
+    uint64_t cache_hits;
+    uint64_t ready;
+    uint64_t failed;
+    uint64_t placeholder_uses;      // program() calls answered with the placeholder
+    uint64_t reloads;               // rebuilds that replaced a live program
+    uint64_t stages_requested;      // shader stages passed to submit/reload
+    uint64_t stages_compiled;       // glCompileShader calls after deduplication
+    uint64_t stages_deleted;        // shader objects no program uses any more
+};
+
+// Submits every shader and program up front and only looks at results when
+// a program is actually needed, so compiles overlap instead of each one
+// forcing a driver sync. With GL_ARB_parallel_shader_compile the driver
+// compiles on its own threads and poll()/program() check
+// GL_COMPLETION_STATUS_ARB without blocking; until then program() hands out
+// a flat placeholder. Without the extension, program() finalises on first
+// use, and reloads are compiled and linked on a worker thread with a
+// shared context (set_worker_context()) so the old program keeps drawing
+// and poll() only picks up finished ones.
+//
+// Shader objects are keyed by stage type and a hash of their (preprocessed)
+// source, so a source shared by several programs is compiled exactly once
+// per compiler. An object is kept while a build or a live program uses it
+// and deleted once a reload or failure leaves it unused.
+//
+// reload() rebuilds a program while the previous one stays in use; the
+// handle switches to the new program only once it links, and a failed
+// reload leaves the old program live.
+// Construct after the GL context is current and destroy() before it goes.
+class ShaderCompiler {
+public:
+    explicit ShaderCompiler(ProgramBinaryCache* cache = nullptr);
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+    bool parallel() const { return parallel_; }
+
+    // Makes a context that shares objects with the render context current
+    // on the calling thread (true), or releases it (false)
+    typedef std::function<void(bool)> ContextSwitch;
+
+    // Starts the reload worker; false, and unused, with parallel compile
+    bool set_worker_context(const ContextSwitch& make_current);
+
+    ProgramHandle submit(const ShaderSource* sources, size_t count);
+
+    // Starts a rebuild of handle from new sources, replacing any rebuild in flight
+    void reload(ProgramHandle handle, const ShaderSource* sources, size_t count);
+
+    // Finalises finished builds; call once per frame. Only without parallel
+    // compile or a worker context are pending reloads finalised here
+    // blocking, until budget_ms is spent; at least one per call.
+    void poll(double budget_ms = 2.0);
+
+    ProgramStatus status(ProgramHandle handle);
+
+    // The linked program, or the placeholder while pending or after failure
+    GLuint program(ProgramHandle handle);
+
+    // Blocks until the program is finished; 0 on failure
+    GLuint wait(ProgramHandle handle);
+
+    // Bumped every time handle switches to a newly linked program
+    uint32_t generation(ProgramHandle handle) const { return programs_[handle].generation; }
+
+    GLuint placeholder() const { return placeholder_; }
+
+    ShaderCompilerStats stats() const { return stats_; }
+
+    // Deletes every program and shader object and stops the worker;
+    // handles are invalid after
+    void destroy();
+
+private:
+    static const size_t MAX_STAGES = 8;
+
+    // A reload built on the worker from copies of its sources. Owned by
+    // its Build, or by the worker once cancelled while running.
+    struct Job {
+        GLenum types[MAX_STAGES];
+        std::string sources[MAX_STAGES];
+        GLuint shaders[MAX_STAGES];
+        size_t count = 0;
+        bool retrievable = false;
+        GLuint program = 0;
+        bool done = false;
+        bool cancelled = false;
+    };
+
+    struct Build {
+        GLuint program = 0;
+        GLuint shaders[MAX_STAGES];
+        uint64_t shader_keys[MAX_STAGES];
+        size_t shader_count = 0;
+        uint64_t cache_key = 0;
+        bool active = false;
+        std::unique_ptr<Job> job;       // set while on the worker
+    };
+
+    struct ProgramEntry {
+        GLuint program = 0;             // live program, 0 until the first link
+        ProgramStatus status = ProgramStatus::PENDING;
+        uint32_t generation = 0;
+        uint64_t shader_keys[MAX_STAGES];   // objects the live program was built from
+        size_t shader_count = 0;
+        Build build;
+    };
+
+    struct ShaderObject {
+        GLuint shader;
+        uint32_t references;
+    };
+
+    void start_build(ProgramEntry& entry, const ShaderSource* sources, size_t count);
+    void cancel_build(Build& build);
+    bool complete(const Build& build) const;
+    void finalize(ProgramEntry& entry);
+    void install(ProgramEntry& entry, GLuint program);
+    GLuint shader_object(const ShaderSource& source, uint64_t& key);
+    void release_shaders(const uint64_t* keys, size_t count);
+    void start_job(Build& build, const ShaderSource* sources, size_t count);
+    void take_job(Build& build);
+    void work();
+    void stop_worker();
+
+    ProgramBinaryCache* cache_;
+    bool parallel_ = false;
+    GLuint placeholder_ = 0;
+    std::vector<ProgramEntry> programs_;
+    std::unordered_map<uint64_t, ShaderObject> shader_objects_;
+    size_t pending_ = 0;
+    ShaderCompilerStats stats_ = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // Shared with the worker
+    ContextSwitch make_current_;
+    std::thread worker_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable finished_;
+    std::deque<Job*> queue_;
+    bool stopping_ = false;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class AssetArchive;
+
+struct ShaderDefine {
+    const char* name;
+    const char* value;
+};
+
+struct PreprocessedShader {
+    std::string source;
+    std::vector<std::string> files;     // every file read, top-level file first
+};
+
+// Expands #include "file" (relative to the including file, then to the
+// include root) and #pragma once, and injects #define lines right after
+// #version. Each file is given a process-wide index which is written as the
+// source-string number of #line directives, so driver messages such as
+// "3:12(5): error" can be mapped back with annotate_shader_log.
+// With an archive, files it contains are read from it rather than from disk.
+class ShaderPreprocessor {
+public:
+    explicit ShaderPreprocessor(const char* include_root = "shaders", const AssetArchive* archive = nullptr);
+
+    void set_archive(const AssetArchive* archive){ archive_ = archive; }
+
+    bool preprocess(const char* path, const ShaderDefine* defines, size_t define_count, PreprocessedShader& out);
+
+private:
+    bool process_file(const std::string& path, int depth, PreprocessedShader& out);
+    void append_defines(std::string& out) const;
+    std::string resolve(const std::string& including_file, const std::string& name) const;
+
+    std::string include_root_;
+    const AssetArchive* archive_ = nullptr;
+    const ShaderDefine* defines_ = nullptr;
+    size_t define_count_ = 0;
+    bool version_seen_ = false;
+    std::vector<std::string> stack_;
+    std::vector<std::string> once_;
+};
+
+// Path registered for a #line source-string number, or nullptr
+const char* shader_source_path(int index);
+
+// Rewrites "N:line" / "N(line)" locations in a GL info log to "path:line"
+std::string annotate_shader_log(const char* log);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SHADER_REFLECTION_H
+#define SHADER_REFLECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "hash.h"
+
+// Name hash forced to a compile-time constant, e.g. SHADER_NAME("inputColour")
+#define SHADER_NAME(name) std::integral_constant<uint64_t, fnv1a(name)>::value
+
+enum class ShaderVariableKind : uint8_t {
+    UNIFORM,
+    ATTRIBUTE,
+    BLOCK,
+};
+
+struct ShaderVariable {
+    uint64_t key = 0;               // name hash combined with kind, 0 when empty
+    ShaderVariableKind kind = ShaderVariableKind::UNIFORM;
+    GLint location = -1;            // uniform/attribute location or block index
+    GLenum type = 0;                // GL_FLOAT_VEC4 etc., 0 for blocks
+    GLint count = 0;                // array size, or block data size in bytes
+    uint32_t shadow = 0;            // offset of the last value set, uniforms only
+    bool known = false;             // shadow holds the value in the program
+};
+
+struct ReflectionStats {
+    uint64_t sets;                  // typed setter calls
+    uint64_t skipped;               // ... that matched the last value
+    uint64_t missing;               // ... for names the program does not use
+};
+
+// Active uniforms, attributes and uniform blocks of a linked program,
+// enumerated once and stored in a flat table with a perfect hash over the
+// name hashes, so a lookup is one multiply and one compare. Uniforms in the
+// default block get typed setters that remember the last value and skip
+// the glProgramUniform* call when it has not changed. Call reflect() again
+// whenever the program is relinked or replaced.
+class ProgramReflection {
+public:
+    bool reflect(GLuint program);
+
+    GLuint program() const { return program_; }
+
+    const ShaderVariable* find(uint64_t name, ShaderVariableKind kind) const;
+
+    // -1 / GL_INVALID_INDEX if the program does not use the name
+    GLint uniform_location(uint64_t name) const;
+    GLint attribute_location(uint64_t name) const;
+    GLuint block_index(uint64_t name) const;
+
+    // glUniformBlockBinding by name; false if the program has no such block
+    bool bind_block(uint64_t name, GLuint binding);
+
+    // Setters return false for unknown names or mismatched types
+    bool set_int(uint64_t name, GLint value);
+    bool set_float(uint64_t name, float value);
+    bool set_vec2(uint64_t name, const float* value);
+    bool set_vec3(uint64_t name, const float* value);
+    bool set_vec4(uint64_t name, const float* value);
+    bool set_vec4(uint64_t name, float x, float y, float z, float w);
+    bool set_mat3(uint64_t name, const float* value);
+    bool set_mat4(uint64_t name, const float* value);
+
+    ReflectionStats stats() const { return stats_; }
+
+private:
+    void add(uint64_t name, ShaderVariableKind kind, GLint location, GLenum type, GLint count);
+    bool build_table();
+    size_t slot(uint64_t key) const;
+
+    // False for unknown names or mismatched types; location is -1 when
+    // the value is unchanged and no GL call is needed
+    bool update(uint64_t name, GLenum type, const void* value, size_t size, GLint& location);
+
+    GLuint program_ = 0;
+    std::vector<ShaderVariable> variables_;     // collected by reflect()
+    std::vector<ShaderVariable> table_;
+    uint64_t seed_ = 0;
+    unsigned shift_ = 64;
+    std::vector<unsigned char> shadow_;
+    ReflectionStats stats_ = {0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "file_watcher.h"
+#include "shader_compiler.h"
+#include "shader_preprocessor.h"
+
+struct ShaderFile {
+    GLenum type;
+    const char* path;
+};
+
+// Loads programs from shader files and rebuilds them through
+// ShaderCompiler::reload when any of their files, or any file they
+// #include, change on disk.
+class ShaderReloader {
+public:
+    ShaderReloader(ShaderCompiler& compiler, ShaderPreprocessor& preprocessor);
+
+    // Preprocesses the files, submits the program and starts watching them
+    ProgramHandle load(const ShaderFile* files, size_t count, const ShaderDefine* defines = nullptr, size_t define_count = 0);
+
+    // Starts rebuilds for changed files; a few syscalls when nothing changed
+    void poll();
+
+private:
+    struct TrackedProgram {
+        ProgramHandle handle;
+        std::vector<GLenum> types;
+        std::vector<std::string> paths;
+        std::vector<std::string> define_names;
+        std::vector<std::string> define_values;
+    };
+
+    // Preprocesses every stage of tracked; false if any file could not be read
+    bool preprocess_sources(const TrackedProgram& tracked, std::vector<PreprocessedShader>& shaders, std::vector<ShaderSource>& sources);
+
+    // Watches the stage files and their includes for program index
+    void watch_files(size_t index, const std::vector<PreprocessedShader>& shaders);
+    void watch_file(size_t index, const std::string& path);
+
+    ShaderCompiler& compiler_;
+    ShaderPreprocessor& preprocessor_;
+    FileWatcher watcher_;
+    std::vector<TrackedProgram> programs_;
+    std::vector<std::vector<size_t>> watchers_;     // watch id -> programs using the file
+    std::vector<int> changed_;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "shader_compiler.h"
+#include "shader_reloader.h"
+
+// Bit i enables the i-th feature passed to ShaderVariants
+typedef uint64_t FeatureMask;
+
+struct ShaderVariantStats {
+    uint64_t lookups;               // program()/handle() calls
+    uint64_t requested;             // distinct feature sets asked for
+    uint64_t compiled;              // variants that went through glCompileShader
+    uint64_t cached;                // variants loaded from the binary cache
+    uint64_t prewarmed;             // variants submitted by prewarm()
+};
+
+// Permutations of one base program. Each feature bit becomes a
+// "#define <name> 1" for the preprocessor; a variant is submitted (and
+// watched for edits) the first time its feature set is used, so only the
+// permutations a scene actually needs get compiled. Feature sets map to
+// program handles through a small open-addressing table keyed by the mask.
+class ShaderVariants {
+public:
+    static const size_t MAX_FEATURES = 64;
+
+    ShaderVariants(
+        ShaderReloader& reloader,
+        ShaderCompiler& compiler,
+        const ShaderFile* files,
+        size_t count,
+        const char* const* features,
+        size_t feature_count
+    );
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // Submits the variant on first use
+    ProgramHandle handle(FeatureMask mask);
+
+    // The variant's program, or the compiler placeholder while it builds
+    GLuint program(FeatureMask mask) { return compiler_.program(handle(mask)); }
+
+    // Submits variants ahead of use, e.g. the hot list of a previous run
+    void prewarm(const FeatureMask* masks, size_t count);
+
+    // Up to max masks ordered by use count, most used first
+    size_t hottest(FeatureMask* masks, size_t max) const;
+
+    // Bit for a feature name, 0 if it is not one of ours
+    FeatureMask feature(const char* name) const;
+
+    ShaderVariantStats stats() const { return stats_; }
+
+private:
+    struct Slot {
+        FeatureMask mask = 0;
+        ProgramHandle handle = 0;
+        uint32_t uses = 0;          // 0 marks an empty slot
+    };
+
+    Slot& find_slot(FeatureMask mask);
+    void grow();
+    ProgramHandle submit(FeatureMask mask);
+
+    ShaderReloader& reloader_;
+    ShaderCompiler& compiler_;
+    std::vector<ShaderFile> files_;
+    std::vector<std::string> paths_;
+    std::vector<std::string> features_;
+    std::vector<Slot> slots_;
+    size_t used_ = 0;
+    ShaderVariantStats stats_ = {0, 0, 0, 0, 0};
+};
+
+#endif
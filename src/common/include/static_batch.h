@@ -0,0 +1,87 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "vertex_format.h"
+
+class GlState;
+class StreamBuffer;
+
+typedef uint32_t BatchMesh;
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+struct StaticBatchStats {
+    uint64_t commands;              // draws requested last frame
+    uint64_t driver_draws;          // draw calls issued for them
+};
+
+// Meshes sharing one vertex format, packed into a single VBO/IBO/VAO.
+// Each frame draw() appends an indirect command for a mesh and submit()
+// streams the commands through a StreamBuffer and issues all of them with
+// one glMultiDrawElementsIndirect. Without
+// ARB_multi_draw_indirect it falls back to one glDrawElements*BaseVertex
+// per command, which ignores base_instance. Indices are 32-bit and
+// relative to the mesh's vertices. The destructor does not touch GL;
+// destroy() before the context goes.
+class StaticBatch {
+public:
+    StaticBatch(const VertexFormat& format, StreamBuffer& stream) : format_(format), stream_(stream){}
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    // Copies the mesh into the staging arrays; call before upload()
+    BatchMesh add_mesh(const void* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count);
+
+    // Creates the GL buffers and VAO and drops the staging copy; binds
+    // through gl_state so its shadow stays right
+    bool upload(GlState& gl_state);
+
+    bool multi_draw() const { return multi_draw_; }
+
+    // Queues a draw of mesh for this frame
+    void draw(BatchMesh mesh, GLuint instance_count = 1, GLuint base_instance = 0);
+
+    // Issues the frame's draws with program and clears the list
+    void submit(GlState& gl_state, GLuint program);
+
+    StaticBatchStats stats() const { return stats_; }
+
+    // Deletes the buffers and VAO; GL context must be current
+    void destroy();
+
+private:
+    struct MeshRange {
+        GLuint first_index;
+        GLuint index_count;
+        GLint base_vertex;
+    };
+
+    VertexFormat format_;
+    std::vector<unsigned char> vertices_;
+    std::vector<uint32_t> indices_;
+    std::vector<MeshRange> meshes_;
+    std::vector<DrawElementsIndirectCommand> commands_;
+
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLuint ibo_ = 0;
+    StreamBuffer& stream_;
+    bool multi_draw_ = false;
+    StaticBatchStats stats_ = {0, 0};
+};
+
+#endif
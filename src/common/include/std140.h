@@ -0,0 +1,60 @@
+#ifndef STD140_H
+#define STD140_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Packs values into a byte buffer following the std140 rules, in the order
+// they are declared in the GLSL block:
+//   - float/int take 4 bytes at 4-byte alignment
+//   - vec2 takes 8 bytes at 8-byte alignment
+//   - vec3 and vec4 are aligned to 16 bytes (vec3 takes 12)
+//   - mat4 is four vec4 columns; mat3 is three vec4-padded columns
+// The block size is rounded up to 16 bytes like the driver's.
+class Std140Writer {
+public:
+    Std140Writer(void* data, size_t capacity) : data_((unsigned char*)data), capacity_(capacity){}
+
+    void write_float(float value) { put(&value, 4, 4); }
+    void write_int(int value) { put(&value, 4, 4); }
+    void write_vec2(const float* value) { put(value, 8, 8); }
+    void write_vec3(const float* value) { put(value, 12, 16); }
+    void write_vec4(const float* value) { put(value, 16, 16); }
+    void write_vec4(float x, float y, float z, float w){
+        float value[] = {x, y, z, w};
+        put(value, 16, 16);
+    }
+
+    // Column-major, as glUniformMatrix* with transpose GL_FALSE
+    void write_mat3(const float* value){
+        for(int column = 0; column < 3; column++){
+            put(value + column * 3, 12, 16);
+        }
+        offset_ = (offset_ + 15) & ~(size_t)15;
+    }
+    void write_mat4(const float* value) { put(value, 64, 16); }
+
+    // Bytes used so far, rounded to the block's 16-byte alignment
+    size_t size() const { return (offset_ + 15) & ~(size_t)15; }
+
+    // False if a write did not fit
+    bool ok() const { return ok_; }
+
+private:
+    void put(const void* value, size_t size, size_t alignment){
+        size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+        if(offset + size > capacity_){
+            ok_ = false;
+            return;
+        }
+        memcpy(data_ + offset, value, size);
+        offset_ = offset + size;
+    }
+
+    unsigned char* data_;
+    size_t capacity_;
+    size_t offset_ = 0;
+    bool ok_ = true;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+struct StreamAllocation {
+    void* data;                     // CPU pointer to write through, nullptr if full
+    size_t offset;                  // GPU offset into buffer()
+    size_t size;
+};
+
+struct StreamBufferStats {
+    uint64_t allocations;
+    uint64_t bytes;                 // allocated, including alignment padding
+    uint64_t waits;                 // begin_frame() calls that had to block on the GPU
+    uint64_t overflows;             // allocations that did not fit in the frame's region
+    uint64_t fallbacks;             // commits that fell back to glBufferSubData
+    size_t peak;                    // most bytes used in one frame
+};
+
+// Per-frame dynamic data (vertices, instances, constants, indirect
+// commands) in one buffer split into a region per frame in flight, each
+// guarded by a fence. allocate() bumps a cursor through the current region
+// and returns where to write on the CPU and the offset to bind or draw from
+// on the GPU, so streaming never waits on the driver.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistently and
+// coherently, and commit() does nothing. Without it allocations point into
+// a CPU copy and commit() copies them into the fenced region through an
+// unsynchronized glMapBufferRange, so neither side waits; glBufferSubData
+// is only used if the map fails.
+//
+// Uploads and creation bind GL_COPY_WRITE_BUFFER, which GlState leaves alone.
+// The destructor does not touch GL; destroy() before the context goes.
+class StreamBuffer {
+public:
+    StreamBuffer() = default;
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // region_size bytes per frame, frames regions; needs a current context
+    bool create(size_t region_size, unsigned frames = 3);
+    void destroy();
+
+    bool persistent() const { return mapped_ != nullptr; }
+    GLuint buffer() const { return buffer_; }
+    size_t region_size() const { return region_size_; }
+
+    // Moves to the next region, waiting for the GPU to finish with it
+    void begin_frame();
+
+    // Fences the region once the frame's draws have been issued
+    void end_frame();
+
+    // alignment must be a power of two
+    StreamAllocation allocate(size_t size, size_t alignment = 16);
+
+    // Makes the written allocation visible to GL; call before drawing from it
+    void commit(const StreamAllocation& allocation);
+
+    StreamBufferStats stats() const { return stats_; }
+
+private:
+    static const unsigned MAX_FRAMES = 4;
+
+    GLuint buffer_ = 0;
+    unsigned char* mapped_ = nullptr;
+    std::vector<unsigned char> staging_;    // CPU copy without buffer storage
+    size_t region_size_ = 0;
+    unsigned frames_ = 0;
+    unsigned frame_ = 0;
+    size_t cursor_ = 0;                     // offset within the current region
+    GLsync fences_[MAX_FRAMES] = {};
+    StreamBufferStats stats_ = {0, 0, 0, 0, 0, 0};
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+typedef uint32_t TlsfBlock;
+
+const TlsfBlock TLSF_NONE = 0xffffffffu;
+
+struct TlsfStats {
+    size_t capacity;
+    size_t used;                    // bytes in live blocks, padding included
+    size_t free;
+    size_t largest_free;
+    size_t allocations;
+    size_t free_blocks;
+};
+
+// Two-level segregated fit allocator over an offset range [0, capacity),
+// for carving GPU buffers. Sizes are kept in 16-byte granules; free blocks
+// sit in per-size-class lists found through two bitmaps, so allocate and
+// free are O(1), and neighbouring free blocks are merged on free. The
+// memory itself is never touched, only offsets are handed out.
+class TlsfAllocator {
+public:
+    static const size_t GRANULE = 16;
+
+    explicit TlsfAllocator(size_t capacity = 0);
+
+    // Forgets every allocation
+    void reset(size_t capacity);
+
+    // alignment need not be a power of two (e.g. a vertex stride);
+    // TLSF_NONE when no free block is large enough
+    TlsfBlock allocate(size_t size, size_t alignment = GRANULE);
+    void free(TlsfBlock block);
+
+    // Claims [offset, offset + size) out of a free block, TLSF_NONE if it
+    // is not free. Linear in the block count; meant for rebuilding a packed
+    // layout after compaction.
+    TlsfBlock allocate_at(size_t offset, size_t size);
+
+    // Alignment offsets are actually rounded to: a multiple of alignment
+    // and of GRANULE
+    static size_t alignment(size_t alignment);
+
+    // Smallest capacity whose fresh allocator satisfies allocate(size,
+    // alignment): the alignment slack, rounded up to the size class the
+    // search looks in
+    static size_t capacity_for(size_t size, size_t alignment = GRANULE);
+
+    size_t offset(TlsfBlock block) const { return blocks_[block].offset; }
+    size_t size(TlsfBlock block) const { return blocks_[block].size; }
+
+    // Live blocks in offset order
+    void live_blocks(std::vector<TlsfBlock>& out) const;
+
+    TlsfStats stats() const;
+
+private:
+    static const unsigned SL_BITS = 4;
+    static const unsigned SL_COUNT = 1u << SL_BITS;
+    static const unsigned FL_COUNT = 40;
+
+    struct Block {
+        size_t offset = 0;
+        size_t size = 0;
+        uint32_t prev_physical = TLSF_NONE;
+        uint32_t next_physical = TLSF_NONE;
+        uint32_t prev_free = TLSF_NONE;
+        uint32_t next_free = TLSF_NONE;
+        bool free = false;
+        bool in_use = false;        // record is live, not on the spare list
+    };
+
+    static void mapping(size_t units, unsigned& fl, unsigned& sl);
+    static size_t search_size(size_t size, size_t alignment);
+    static size_t search_units(size_t size);
+    uint32_t new_block();
+    void release_block(uint32_t block);
+    void insert_free(uint32_t block);
+    void remove_free(uint32_t block);
+    uint32_t find_free(size_t size);
+    uint32_t split(uint32_t block, size_t size);
+
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> spare_;                   // unused records in blocks_
+    uint32_t heads_[FL_COUNT][SL_COUNT];
+    uint64_t fl_bitmap_ = 0;
+    uint32_t sl_bitmap_[FL_COUNT];
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    size_t allocations_ = 0;
+};
+
+#endif
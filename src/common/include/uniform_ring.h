@@ -0,0 +1,64 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "stream_buffer.h"
+
+// Uniform block binding points shared by the lessons' shaders
+const GLuint FRAME_BLOCK_BINDING = 0;
+const GLuint OBJECT_BLOCK_BINDING = 1;
+
+struct UniformRingStats {
+    uint64_t pushes;                // blocks written
+    uint64_t bytes;                 // ... including alignment padding
+    uint64_t binds;                 // glBindBufferRange calls
+    uint64_t waits;                 // begin_frame() calls that had to block on the GPU
+    uint64_t overflows;             // pushes that did not fit in the frame's region
+};
+
+// Constant blocks (std140, see std140.h) streamed through a StreamBuffer
+// and bound with glBindBufferRange, so many objects share one buffer and
+// no glUniform* calls are made. Blocks start on the driver's
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+class UniformRing {
+public:
+    UniformRing() = default;
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // region_size bytes per frame, frames regions; needs a current context
+    bool create(size_t region_size, unsigned frames = 3);
+    void destroy();
+
+    bool persistent() const { return stream_.persistent(); }
+
+    // Moves to the next region, waiting for the GPU to finish with it
+    void begin_frame() { stream_.begin_frame(); }
+
+    // Fences the region once the frame's draws have been issued
+    void end_frame() { stream_.end_frame(); }
+
+    // Copies a block into the frame's region; returns its offset, or
+    // SIZE_MAX if the region is full
+    size_t push(const void* data, size_t size);
+
+    // Binds size bytes at offset to a uniform block binding point
+    void bind(GLuint binding, size_t offset, size_t size);
+
+    // push() and bind() in one; false if the block did not fit
+    bool push_and_bind(GLuint binding, const void* data, size_t size);
+
+    UniformRingStats stats() const;
+
+private:
+    StreamBuffer stream_;
+    size_t alignment_ = 256;
+    uint64_t binds_ = 0;
+};
+
+#endif
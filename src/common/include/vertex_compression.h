@@ -0,0 +1,70 @@
+#ifndef VERTEX_COMPRESSION_H
+#define VERTEX_COMPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "vertex_format.h"
+
+// Attribute locations compressed meshes are set up with
+const GLuint VERTEX_POSITION_LOCATION = 0;
+const GLuint VERTEX_NORMAL_LOCATION = 3;
+const GLuint VERTEX_UV_LOCATION = 4;
+
+// Float vertex data to compress. Streams share stride, in bytes, or are
+// tightly packed when it is 0; normals and uvs are optional.
+struct VertexStreams {
+    const float* positions = nullptr;   // xyz
+    const float* normals = nullptr;     // xyz, unit length
+    const float* uvs = nullptr;         // uv
+    size_t stride = 0;
+    size_t count = 0;
+};
+
+// Which attributes to pack; the others stay 32-bit floats
+struct VertexCompression {
+    bool positions = true;              // 16-bit unorm within the mesh bounds
+    bool normals = true;                // octahedral, 2 x 16-bit snorm
+    bool uvs = true;                    // 2 x half float
+};
+
+// Interleaved vertices ready for upload, with the VertexFormat that reads
+// them. Positions are quantized with one scale for all axes so that decode
+// is a uniform scale and offset, which folds into any transform:
+//   position = vertex_position * position_decode.w + position_decode.xyz
+// Normals arrive as a vec2 and are decoded in the shader:
+//   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//   if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+//   n = normalize(n);
+struct CompressedVertices {
+    std::vector<unsigned char> data;
+    VertexFormat format;
+    size_t vertex_count = 0;
+    size_t position_offset = SIZE_MAX;  // byte offsets in a vertex, SIZE_MAX if absent
+    size_t normal_offset = SIZE_MAX;
+    size_t uv_offset = SIZE_MAX;
+    float position_decode[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+};
+
+struct VertexCompressionError {
+    double max_position;                // in mesh units
+    double rms_position;
+    double max_normal_degrees;
+    double max_uv;
+};
+
+bool compress_vertices(const VertexStreams& streams, const VertexCompression& options, CompressedVertices& out);
+
+// Decodes vertex index on the CPU as the shader would; null outputs skipped
+void decompress_vertex(const CompressedVertices& vertices, size_t index, float* position, float* normal, float* uv);
+
+// Compares the decoded vertices against the originals
+VertexCompressionError measure_compression_error(const VertexStreams& streams, const CompressedVertices& vertices);
+
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t half);
+
+#endif
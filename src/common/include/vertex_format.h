@@ -0,0 +1,50 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+struct VertexAttribute {
+    GLuint location;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;                  // bytes from the start of the vertex
+};
+
+// Interleaved layout of one vertex buffer
+struct VertexFormat {
+    static const size_t MAX_ATTRIBUTES = 8;
+
+    explicit VertexFormat(GLsizei vertex_stride = 0) : stride(vertex_stride){}
+
+    VertexAttribute attributes[MAX_ATTRIBUTES];
+    size_t attribute_count = 0;
+    GLsizei stride;
+
+    VertexFormat& add(GLuint location, GLint components, GLenum type, GLboolean normalized, GLuint offset){
+        if(attribute_count < MAX_ATTRIBUTES){
+            attributes[attribute_count++] = {location, components, type, normalized, offset};
+        }
+        return *this;
+    }
+};
+
+// Enables and points every attribute of format at the bound GL_ARRAY_BUFFER
+inline void apply_vertex_format(const VertexFormat& format){
+    for(size_t i = 0; i < format.attribute_count; i++){
+        const VertexAttribute& attribute = format.attributes[i];
+        glEnableVertexAttribArray(attribute.location);
+        glVertexAttribPointer(
+            attribute.location,
+            attribute.components,
+            attribute.type,
+            attribute.normalized,
+            format.stride,
+            (const void*)(size_t)attribute.offset
+        );
+    }
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include "indexed_mesh.h"
+
+#include <vector>
+
+#include "gl_state.h"
+
+bool upload_indexed_mesh(
+    GlState& gl_state,
+    BufferArena& arena,
+    const VertexFormat& format,
+    const void* vertices,
+    size_t vertex_count,
+    const uint32_t* indices,
+    size_t index_count,
+    IndexedMesh& mesh
+){
+    if(vertex_count <= 0xffff){
+        std::vector<uint16_t> short_indices(indices, indices + index_count);
+        return upload_indexed_mesh(
+            gl_state,
+            arena,
+            format,
+            vertices,
+            vertex_count,
+            short_indices.data(),
+            GL_UNSIGNED_SHORT,
+            index_count,
+            mesh
+        );
+    }
+    return upload_indexed_mesh(gl_state, arena, format, vertices, vertex_count, indices, GL_UNSIGNED_INT, index_count, mesh);
+}
+
+bool upload_indexed_mesh(
+    GlState& gl_state,
+    BufferArena& arena,
+    const VertexFormat& format,
+    const void* vertices,
+    size_t vertex_count,
+    const void* indices,
+    GLenum index_type,
+    size_t index_count,
+    IndexedMesh& mesh
+){
+    if(!allocate_indexed_mesh(arena, format, vertex_count, index_type, index_count, mesh)){
+        return false;
+    }
+    size_t index_size = index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+    if(!arena.upload(mesh.vertices, vertices, vertex_count * format.stride) ||
+       !arena.upload(mesh.indices, indices, index_count * index_size)){
+        destroy_indexed_mesh(mesh);
+        return false;
+    }
+
+    refresh_indexed_mesh(mesh);
+    mesh.vao = create_mesh_vao(gl_state, mesh);
+    return true;
+}
+
+bool allocate_indexed_mesh(
+    BufferArena& arena,
+    const VertexFormat& format,
+    size_t vertex_count,
+    GLenum index_type,
+    size_t index_count,
+    IndexedMesh& mesh
+){
+    if(vertex_count == 0 || index_count == 0){
+        return false;
+    }
+    mesh.format = format;
+    mesh.vertex_count = vertex_count;
+    mesh.index_count = (GLsizei)index_count;
+    mesh.index_type = index_type;
+    mesh.arena = &arena;
+
+    // Vertices aligned to the stride so their offset is a whole base vertex
+    mesh.vertices = arena.allocate(vertex_count * format.stride, format.stride);
+    size_t index_size = index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+    mesh.indices = arena.allocate(index_count * index_size, index_size);
+    if(mesh.vertices == ARENA_NONE || mesh.indices == ARENA_NONE){
+        destroy_indexed_mesh(mesh);
+        return false;
+    }
+    return true;
+}
+
+bool upload_mesh_file(GlState& gl_state, BufferArena& arena, const MeshFile& file, IndexedMesh& mesh){
+    const MeshFileHeader& header = file.header();
+    return upload_indexed_mesh(
+        gl_state,
+        arena,
+        file.format(),
+        file.vertices(),
+        header.vertex_count,
+        file.indices(),
+        header.index_type,
+        header.index_count,
+        mesh
+    );
+}
+
+bool refresh_indexed_mesh(IndexedMesh& mesh){
+    ArenaAllocation vertices = mesh.arena->get(mesh.vertices);
+    ArenaAllocation indices = mesh.arena->get(mesh.indices);
+    size_t index_size = mesh.index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+    GLint base_vertex = (GLint)(vertices.offset / mesh.format.stride);
+    GLint first_index = (GLint)(indices.offset / index_size);
+
+    bool moved = base_vertex != mesh.base_vertex || first_index != mesh.first_index;
+    mesh.vbo = vertices.buffer;
+    mesh.ibo = indices.buffer;
+    mesh.base_vertex = base_vertex;
+    mesh.first_index = first_index;
+    mesh.generation = mesh.arena->generation();
+    return moved;
+}
+
+GLuint create_mesh_vao(GlState& gl_state, const IndexedMesh& mesh){
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    gl_state.bind_vertex_array(vao);
+    gl_state.bind_buffer(GL_ARRAY_BUFFER, mesh.vbo);
+    apply_vertex_format(mesh.format);
+    gl_state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+    return vao;
+}
+
+void destroy_indexed_mesh(IndexedMesh& mesh){
+    glDeleteVertexArrays(1, &mesh.vao);
+    if(mesh.arena){
+        mesh.arena->free(mesh.vertices);
+        mesh.arena->free(mesh.indices);
+    }
+    mesh.vao = mesh.vbo = mesh.ibo = 0;
+    mesh.vertices = mesh.indices = ARENA_NONE;
+}
@@ -0,0 +1,124 @@
+#include "instancing.h"
+
+#include <algorithm>
+#include <string.h>
+#include <utility>
+
+#include "gl_state.h"
+#include "hash.h"
+#include "stream_buffer.h"
+
+void InstanceRenderer::add(GLuint program, const InstancedMesh& mesh, const InstanceData& instance){
+    // Meshes sharing an arena VAO differ only in their ranges
+    uint64_t key = ((uint64_t)program << 32) | mesh.vao;
+    if(mesh.first || mesh.base_vertex){
+        key = hash_combine(key, ((uint64_t)(uint32_t)mesh.first << 32) | (uint32_t)mesh.base_vertex);
+    }
+    std::unordered_map<uint64_t, size_t>::iterator found = group_index_.find(key);
+    if(found == group_index_.end()){
+        found = group_index_.emplace(key, groups_.size()).first;
+        groups_.push_back({key, program, mesh, std::vector<InstanceData>()});
+    }
+    groups_[found->second].instances.push_back(instance);
+}
+
+void InstanceRenderer::prepare_vao(GlState& gl_state, GLuint vao){
+    gl_state.bind_vertex_array(vao);
+    if(std::find(prepared_vaos_.begin(), prepared_vaos_.end(), vao) != prepared_vaos_.end()){
+        return;
+    }
+    glEnableVertexAttribArray(INSTANCE_TRANSFORM_LOCATION);
+    glEnableVertexAttribArray(INSTANCE_COLOUR_LOCATION);
+    glVertexAttribDivisor(INSTANCE_TRANSFORM_LOCATION, 1);
+    glVertexAttribDivisor(INSTANCE_COLOUR_LOCATION, 1);
+    prepared_vaos_.push_back(vao);
+}
+
+void InstanceRenderer::prune(){
+    // Groups with no instances this frame are dropped; the rest move down
+    // and keep their vectors' capacity for the next frame
+    size_t kept = 0;
+    for(size_t i = 0; i < groups_.size(); i++){
+        if(groups_[i].instances.empty()){
+            group_index_.erase(groups_[i].key);
+            continue;
+        }
+        if(kept != i){
+            groups_[kept] = std::move(groups_[i]);
+            group_index_[groups_[kept].key] = kept;
+        }
+        kept++;
+    }
+    groups_.resize(kept);
+}
+
+void InstanceRenderer::submit(GlState& gl_state){
+    stats_ = {0, 0, 0};
+    prune();
+    size_t total = 0;
+    for(const Group& group : groups_){
+        total += group.instances.size();
+    }
+    if(total == 0){
+        return;
+    }
+
+    // One allocation for the frame's instances, no driver round trip
+    StreamAllocation allocation = stream_.allocate(total * sizeof(InstanceData), sizeof(float) * 4);
+    if(!allocation.data){
+        for(Group& group : groups_){
+            group.instances.clear();
+        }
+        return;
+    }
+    unsigned char* data = (unsigned char*)allocation.data;
+    size_t offset = 0;
+    for(const Group& group : groups_){
+        size_t bytes = group.instances.size() * sizeof(InstanceData);
+        memcpy(data + offset, group.instances.data(), bytes);
+        offset += bytes;
+    }
+    stream_.commit(allocation);
+
+    // One instanced draw per group, the instance attributes point at its slice
+    offset = allocation.offset;
+    for(Group& group : groups_){
+        GLsizei count = (GLsizei)group.instances.size();
+        if(count == 0){
+            continue;
+        }
+        gl_state.use_program(group.program);
+        prepare_vao(gl_state, group.mesh.vao);
+        gl_state.bind_buffer(GL_ARRAY_BUFFER, stream_.buffer());
+        glVertexAttribPointer(INSTANCE_TRANSFORM_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)offset);
+        glVertexAttribPointer(
+            INSTANCE_COLOUR_LOCATION,
+            4,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(InstanceData),
+            (const void*)(offset + offsetof(InstanceData, colour))
+        );
+
+        const InstancedMesh& mesh = group.mesh;
+        if(mesh.index_type){
+            size_t index_size = mesh.index_type == GL_UNSIGNED_INT ? 4 : (mesh.index_type == GL_UNSIGNED_SHORT ? 2 : 1);
+            glDrawElementsInstancedBaseVertex(
+                mesh.mode,
+                mesh.count,
+                mesh.index_type,
+                (const void*)((size_t)mesh.first * index_size),
+                count,
+                mesh.base_vertex
+            );
+        } else {
+            glDrawArraysInstanced(mesh.mode, mesh.first, mesh.count, count);
+        }
+
+        offset += count * sizeof(InstanceData);
+        stats_.instances += count;
+        stats_.groups++;
+        stats_.draw_calls++;
+        group.instances.clear();
+    }
+}
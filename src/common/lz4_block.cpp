@@ -0,0 +1,201 @@
+#include "lz4_block.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+const unsigned LZ4_HASH_BITS = 12;
+const size_t LZ4_MIN_MATCH = 4;
+const size_t LZ4_LAST_LITERALS = 5;         // the block always ends in literals
+const size_t LZ4_MATCH_FIND_LIMIT = 12;     // no match may start after end - 12
+const size_t LZ4_MAX_OFFSET = 65535;
+
+uint32_t read32(const unsigned char* p){
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hash_sequence(uint32_t sequence){
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// Length beyond the 4-bit token field, as a run of 255s and a remainder
+bool write_length(unsigned char*& out, unsigned char* end, size_t length){
+    for(; length >= 255; length -= 255){
+        if(out >= end){
+            return false;
+        }
+        *out++ = 255;
+    }
+    if(out >= end){
+        return false;
+    }
+    *out++ = (unsigned char)length;
+    return true;
+}
+
+bool read_length(const unsigned char*& in, const unsigned char* end, size_t& length){
+    unsigned char byte;
+    do {
+        if(in >= end){
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    } while(byte == 255);
+    return true;
+}
+
+bool write_sequence(
+    unsigned char*& out,
+    unsigned char* end,
+    const unsigned char* literals,
+    size_t literal_length,
+    size_t offset,
+    size_t match_length
+){
+    if(out >= end){
+        return false;
+    }
+    unsigned char* token = out++;
+    *token = (unsigned char)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if(literal_length >= 15 && !write_length(out, end, literal_length - 15)){
+        return false;
+    }
+    if((size_t)(end - out) < literal_length){
+        return false;
+    }
+    memcpy(out, literals, literal_length);
+    out += literal_length;
+
+    // The last sequence has literals only
+    if(match_length == 0){
+        return true;
+    }
+    if(end - out < 2){
+        return false;
+    }
+    *out++ = (unsigned char)(offset & 0xff);
+    *out++ = (unsigned char)(offset >> 8);
+    match_length -= LZ4_MIN_MATCH;
+    *token |= (unsigned char)(match_length >= 15 ? 15 : match_length);
+    return match_length < 15 || write_length(out, end, match_length - 15);
+}
+
+}
+
+size_t lz4_compress_bound(size_t size){
+    return size + size / 255 + 16;
+}
+
+size_t lz4_decompress_bound(size_t size){
+    return size > SIZE_MAX / 255 ? SIZE_MAX : size * 255;
+}
+
+size_t lz4_compress(const void* source, size_t size, void* destination, size_t capacity){
+    const unsigned char* in = (const unsigned char*)source;
+    const unsigned char* in_end = in + size;
+    unsigned char* out = (unsigned char*)destination;
+    unsigned char* out_end = out + capacity;
+    const unsigned char* anchor = in;
+
+    if(size > LZ4_MATCH_FIND_LIMIT){
+        std::vector<uint32_t> table(1u << LZ4_HASH_BITS, 0);
+        const unsigned char* match_find_end = in_end - LZ4_MATCH_FIND_LIMIT;
+        const unsigned char* match_end = in_end - LZ4_LAST_LITERALS;
+        const unsigned char* cursor = in + 1;
+
+        while(cursor < match_find_end){
+            uint32_t sequence = read32(cursor);
+            uint32_t& slot = table[hash_sequence(sequence)];
+            const unsigned char* candidate = in + slot;
+            slot = (uint32_t)(cursor - in);
+
+            if(candidate >= cursor || (size_t)(cursor - candidate) > LZ4_MAX_OFFSET || read32(candidate) != sequence){
+                // Step faster through data that keeps missing
+                cursor += 1 + ((cursor - anchor) >> 6);
+                continue;
+            }
+
+            // Extend backwards into pending literals, then forwards
+            while(cursor > anchor && candidate > in && cursor[-1] == candidate[-1]){
+                cursor--;
+                candidate--;
+            }
+            const unsigned char* match = cursor + LZ4_MIN_MATCH;
+            const unsigned char* reference = candidate + LZ4_MIN_MATCH;
+            while(match < match_end && *match == *reference){
+                match++;
+                reference++;
+            }
+
+            if(!write_sequence(out, out_end, anchor, cursor - anchor, cursor - candidate, match - cursor)){
+                return 0;
+            }
+            cursor = match;
+            anchor = cursor;
+        }
+    }
+
+    if(!write_sequence(out, out_end, anchor, in_end - anchor, 0, 0)){
+        return 0;
+    }
+    return out - (unsigned char*)destination;
+}
+
+bool lz4_decompress(const void* source, size_t source_size, void* destination, size_t size){
+    const unsigned char* in = (const unsigned char*)source;
+    const unsigned char* in_end = in + source_size;
+    unsigned char* out = (unsigned char*)destination;
+    unsigned char* out_begin = out;
+    unsigned char* out_end = out + size;
+
+    while(in < in_end){
+        unsigned char token = *in++;
+        size_t literal_length = token >> 4;
+        if(literal_length == 15 && !read_length(in, in_end, literal_length)){
+            return false;
+        }
+        if(literal_length > (size_t)(in_end - in) || literal_length > (size_t)(out_end - out)){
+            return false;
+        }
+        memcpy(out, in, literal_length);
+        in += literal_length;
+        out += literal_length;
+        if(in == in_end){
+            break;
+        }
+
+        if(in_end - in < 2){
+            return false;
+        }
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        if(offset == 0 || offset > (size_t)(out - out_begin)){
+            return false;
+        }
+        size_t match_length = token & 15;
+        if(match_length == 15 && !read_length(in, in_end, match_length)){
+            return false;
+        }
+        match_length += LZ4_MIN_MATCH;
+        if(match_length > (size_t)(out_end - out)){
+            return false;
+        }
+
+        // Overlapping matches repeat the last offset bytes
+        const unsigned char* reference = out - offset;
+        if(offset >= match_length){
+            memcpy(out, reference, match_length);
+            out += match_length;
+        } else {
+            for(size_t i = 0; i < match_length; i++){
+                *out++ = reference[i];
+            }
+        }
+    }
+    return out == out_end;
+}
@@ -0,0 +1,80 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "error_reporter.h"
+
+MappedFile::MappedFile(const char* path){
+    open(path);
+}
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_), size_(other.size_), open_(other.open_){
+    other.data_ = "";
+    other.size_ = 0;
+    other.open_ = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept{
+    if(this != &other){
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        open_ = other.open_;
+        other.data_ = "";
+        other.size_ = 0;
+        other.open_ = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const char* path){
+    close();
+
+    // Handle IO
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0){
+        report_error(LogCategory::GL, "ERROR: could not open %s for reading\n", path);
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        ::close(fd);
+        report_error(LogCategory::GL, "ERROR: could not stat %s\n", path);
+        return false;
+    }
+
+    // mmap rejects zero-length mappings, an empty file is simply empty
+    size_t size = (size_t)info.st_size;
+    if(size > 0){
+        void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED){
+            ::close(fd);
+            report_error(LogCategory::GL, "ERROR: could not map %s\n", path);
+            return false;
+        }
+        data_ = (const char*)data;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    size_ = size;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close(){
+    if(size_ > 0){
+        munmap((void*)data_, size_);
+    }
+    data_ = "";
+    size_ = 0;
+    open_ = false;
+}
@@ -0,0 +1,150 @@
+#include "mesh_file.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "error_reporter.h"
+
+// The header is the on-disk layout; it must not pick up padding
+static_assert(sizeof(MeshFileHeader) == 264, "mesh file header layout changed");
+static_assert(sizeof(MeshFileSubmesh) == 40, "mesh file submesh layout changed");
+
+namespace {
+
+size_t align_offset(size_t offset){
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+size_t index_size(uint32_t index_type){
+    return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+bool write_padded(FILE* file, const void* data, size_t size, size_t& offset){
+    static const char PADDING[MESH_FILE_ALIGNMENT] = {};
+    size_t aligned = align_offset(offset);
+    if(fwrite(PADDING, 1, aligned - offset, file) != aligned - offset){
+        return false;
+    }
+    offset = aligned + size;
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+}
+
+bool write_mesh_file(const char* path, const MeshFileData& data){
+    if(data.index_type != GL_UNSIGNED_SHORT && data.index_type != GL_UNSIGNED_INT){
+        report_error(LogCategory::ASSET, "ERROR: mesh file %s: unsupported index type %#x\n", path, data.index_type);
+        return false;
+    }
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+    header.version = MESH_FILE_VERSION;
+    header.stride = (uint32_t)data.format.stride;
+    header.attribute_count = (uint32_t)data.format.attribute_count;
+    for(size_t i = 0; i < data.format.attribute_count; i++){
+        const VertexAttribute& attribute = data.format.attributes[i];
+        header.attributes[i] = {
+            attribute.location,
+            (uint32_t)attribute.components,
+            attribute.type,
+            attribute.normalized,
+            attribute.offset,
+        };
+    }
+    header.index_type = data.index_type;
+    header.submesh_count = (uint32_t)data.submesh_count;
+    header.vertex_count = data.vertex_count;
+    header.index_count = data.index_count;
+    memcpy(header.bounds_min, data.bounds_min, sizeof(header.bounds_min));
+    memcpy(header.bounds_max, data.bounds_max, sizeof(header.bounds_max));
+    memcpy(header.position_decode, data.position_decode, sizeof(header.position_decode));
+
+    size_t vertex_bytes = data.vertex_count * data.format.stride;
+    size_t index_bytes = data.index_count * index_size(data.index_type);
+    header.vertex_offset = align_offset(sizeof(header));
+    header.index_offset = align_offset(header.vertex_offset + vertex_bytes);
+    header.submesh_offset = align_offset(header.index_offset + index_bytes);
+
+    // Handle IO
+    std::string temporary = std::string(path) + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(!file){
+        report_error(LogCategory::ASSET, "ERROR: could not open %s for writing\n", temporary.c_str());
+        return false;
+    }
+    size_t offset = 0;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    offset = sizeof(header);
+    written = written && write_padded(file, data.vertices, vertex_bytes, offset);
+    written = written && write_padded(file, data.indices, index_bytes, offset);
+    written = written && write_padded(file, data.submeshes, data.submesh_count * sizeof(MeshFileSubmesh), offset);
+    written = fclose(file) == 0 && written;
+
+    if(!written || rename(temporary.c_str(), path) != 0){
+        report_error(LogCategory::ASSET, "ERROR: could not write mesh file %s\n", path);
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::open(const char* path, const AssetArchive* archive){
+    close();
+    if(!read_asset(archive, path, data_)){
+        return false;
+    }
+
+    // Only the header is read; the blobs are checked to lie inside the file
+    const MeshFileHeader* header = (const MeshFileHeader*)data_.data();
+    size_t size = data_.size();
+    bool valid = size >= sizeof(MeshFileHeader) &&
+        memcmp(header->magic, MESH_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == MESH_FILE_VERSION;
+    valid = valid &&
+        header->attribute_count <= VertexFormat::MAX_ATTRIBUTES &&
+        header->stride > 0 &&
+        (header->index_type == GL_UNSIGNED_SHORT || header->index_type == GL_UNSIGNED_INT);
+    valid = valid &&
+        header->vertex_offset % MESH_FILE_ALIGNMENT == 0 &&
+        header->index_offset % MESH_FILE_ALIGNMENT == 0 &&
+        header->submesh_offset % MESH_FILE_ALIGNMENT == 0;
+    valid = valid &&
+        header->vertex_count <= size / header->stride &&
+        header->vertex_offset <= size - header->vertex_count * header->stride &&
+        header->index_count <= size / index_size(header->index_type) &&
+        header->index_offset <= size - header->index_count * index_size(header->index_type) &&
+        header->submesh_count <= size / sizeof(MeshFileSubmesh) &&
+        header->submesh_offset <= size - header->submesh_count * sizeof(MeshFileSubmesh);
+    if(!valid){
+        report_error(LogCategory::ASSET, "ERROR: %s is not a version %u mesh file\n", path, MESH_FILE_VERSION);
+        data_.clear();
+        return false;
+    }
+    header_ = header;
+    return true;
+}
+
+void MeshFile::close(){
+    data_.clear();
+    header_ = nullptr;
+}
+
+VertexFormat MeshFile::format() const{
+    VertexFormat format((GLsizei)header_->stride);
+    for(uint32_t i = 0; i < header_->attribute_count; i++){
+        const MeshFileAttribute& attribute = header_->attributes[i];
+        format.add(attribute.location, (GLint)attribute.components, attribute.type, (GLboolean)attribute.normalized, attribute.offset);
+    }
+    return format;
+}
+
+size_t MeshFile::index_bytes() const{
+    return header_->index_count * index_size(header_->index_type);
+}
+
+const MeshFileSubmesh* MeshFile::submeshes() const{
+    return (const MeshFileSubmesh*)(data_.data() + header_->submesh_offset);
+}
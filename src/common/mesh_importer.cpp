@@ -0,0 +1,1064 @@
+#include "mesh_importer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <thread>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+#include "mapped_file.h"
+
+namespace {
+
+const uint32_t NO_INDEX = 0xffffffffu;
+
+const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+struct TextRange {
+    const char* begin;
+    const char* end;
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned thread_count(const MeshImportOptions& options){
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+// Runs task(i) for every i in [0, count) on up to threads threads
+template <typename Task>
+void parallel_for(unsigned threads, size_t count, const Task& task){
+    std::atomic<size_t> next(0);
+    auto worker = [&](){
+        for(size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)){
+            task(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < threads && i < count; i++){
+        pool.emplace_back(worker);
+    }
+    worker();
+    for(std::thread& thread : pool){
+        thread.join();
+    }
+}
+
+// Cuts the text into about count ranges, each ending after a newline
+std::vector<TextRange> split_lines(const char* begin, const char* end, size_t count){
+    std::vector<TextRange> ranges;
+    size_t step = (size_t)(end - begin) / (count > 0 ? count : 1) + 1;
+    const char* cursor = begin;
+    while(cursor < end){
+        const char* cut = end - cursor > (ptrdiff_t)step ? cursor + step : end;
+        if(cut < end){
+            const char* newline = (const char*)memchr(cut, '\n', end - cut);
+            cut = newline ? newline + 1 : end;
+        }
+        ranges.push_back({cursor, cut});
+        cursor = cut;
+    }
+    return ranges;
+}
+
+size_t chunk_count(size_t size, unsigned threads, const MeshImportOptions& options){
+    // A few chunks per thread so uneven ones balance out
+    size_t by_size = size / (options.min_chunk_size > 0 ? options.min_chunk_size : 1) + 1;
+    return std::min(by_size, (size_t)threads * 4);
+}
+
+bool is_blank(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+void skip_blanks(const char*& cursor, const char* end){
+    while(cursor < end && is_blank(*cursor)){
+        cursor++;
+    }
+}
+
+const char* next_line(const char* cursor, const char* end){
+    const char* newline = (const char*)memchr(cursor, '\n', end - cursor);
+    return newline ? newline + 1 : end;
+}
+
+bool parse_int(const char*& cursor, const char* end, int64_t& value){
+    const char* p = cursor;
+    skip_blanks(p, end);
+    bool negative = p < end && *p == '-';
+    if(p < end && (*p == '-' || *p == '+')){
+        p++;
+    }
+    if(p >= end || *p < '0' || *p > '9'){
+        return false;
+    }
+    int64_t result = 0;
+    while(p < end && *p >= '0' && *p <= '9'){
+        result = result * 10 + (*p++ - '0');
+    }
+    value = negative ? -result : result;
+    cursor = p;
+    return true;
+}
+
+uint64_t hash_key(uint32_t position, uint32_t uv, uint32_t normal){
+    uint64_t hash = position * 0x9e3779b97f4a7c15ull;
+    hash ^= (uv + 0x632be59bd9b4e019ull) * 0xc2b2ae3d27d4eb4full;
+    hash ^= (normal + 0x165667b19e3779f9ull) * 0x27d4eb2f165667c5ull;
+    return hash ^ (hash >> 29);
+}
+
+// OBJ
+
+struct ObjCorner {
+    int32_t index[3];               // position, uv, normal
+    uint8_t present;                // bit per index given in the file
+    uint8_t relative;               // bit per index counted from the chunk start
+};
+
+struct ObjChunk {
+    TextRange text;
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners; // three per triangle
+    size_t bad_lines = 0;
+    size_t first_corner = 0;        // into the merged corner list
+    size_t bases[3] = {0, 0, 0};    // attributes in earlier chunks
+};
+
+bool parse_floats(const char* cursor, const char* end, size_t count, std::vector<float>& out){
+    float values[3];
+    for(size_t i = 0; i < count; i++){
+        if(!parse_float(cursor, end, values[i])){
+            return false;
+        }
+    }
+    out.insert(out.end(), values, values + count);
+    return true;
+}
+
+// One v, v/vt, v//vn or v/vt/vn group
+bool parse_corner(const char*& cursor, const char* end, const ObjChunk& chunk, ObjCorner& corner){
+    const size_t counts[3] = {chunk.positions.size() / 3, chunk.uvs.size() / 2, chunk.normals.size() / 3};
+    corner = {{0, 0, 0}, 0, 0};
+    for(int slot = 0; slot < 3; slot++){
+        int64_t value = 0;
+        if(slot > 0){
+            if(cursor >= end || *cursor != '/'){
+                break;
+            }
+            cursor++;
+            if(cursor < end && *cursor == '/'){
+                continue;
+            }
+        }
+        if(!parse_int(cursor, end, value) || value == 0){
+            return false;
+        }
+
+        // Negative indices count back from the latest attribute; resolve
+        // them against this chunk, its base is only known after the merge
+        if(value < 0){
+            value = (int64_t)counts[slot] + value;
+            corner.relative |= 1 << slot;
+        }
+        corner.index[slot] = (int32_t)value;
+        corner.present |= 1 << slot;
+    }
+    return true;
+}
+
+bool parse_face(const char* cursor, const char* end, ObjChunk& chunk){
+    ObjCorner first = {}, previous = {}, corner = {};
+    size_t corners = 0;
+    for(;;){
+        skip_blanks(cursor, end);
+        if(cursor >= end || *cursor == '\n' || *cursor == '#'){
+            break;
+        }
+        if(!parse_corner(cursor, end, chunk, corner)){
+            return false;
+        }
+        if(corners == 0){
+            first = corner;
+        } else if(corners >= 2){
+            chunk.corners.push_back(first);
+            chunk.corners.push_back(previous);
+            chunk.corners.push_back(corner);
+        }
+        previous = corner;
+        corners++;
+    }
+    return corners >= 3;
+}
+
+void parse_obj_chunk(ObjChunk& chunk){
+    const char* cursor = chunk.text.begin;
+    const char* end = chunk.text.end;
+    while(cursor < end){
+        const char* line_end = next_line(cursor, end);
+        skip_blanks(cursor, line_end);
+
+        bool parsed = true;
+        if(line_end - cursor > 2 && cursor[0] == 'v'){
+            if(is_blank(cursor[1])){
+                parsed = parse_floats(cursor + 1, line_end, 3, chunk.positions);
+            } else if(cursor[1] == 't' && is_blank(cursor[2])){
+                parsed = parse_floats(cursor + 2, line_end, 2, chunk.uvs);
+            } else if(cursor[1] == 'n' && is_blank(cursor[2])){
+                parsed = parse_floats(cursor + 2, line_end, 3, chunk.normals);
+            }
+        } else if(line_end - cursor > 1 && cursor[0] == 'f' && is_blank(cursor[1])){
+            parsed = parse_face(cursor + 1, line_end, chunk);
+        }
+        chunk.bad_lines += parsed ? 0 : 1;
+        cursor = line_end;
+    }
+}
+
+// Hash table from a position/uv/normal triple to a vertex of one shard
+class WeldTable {
+public:
+    uint32_t insert(uint32_t position, uint32_t uv, uint32_t normal, uint64_t hash){
+        if((keys_.size() + 1) * 2 > slots_.size()){
+            grow();
+        }
+        size_t mask = slots_.size() - 1;
+        for(size_t slot = (hash >> 32) & mask;; slot = (slot + 1) & mask){
+            uint32_t vertex = slots_[slot];
+            if(vertex == NO_INDEX){
+                slots_[slot] = (uint32_t)keys_.size();
+                keys_.push_back({position, uv, normal});
+                return slots_[slot];
+            }
+            const Key& key = keys_[vertex];
+            if(key.position == position && key.uv == uv && key.normal == normal){
+                return vertex;
+            }
+        }
+    }
+
+    struct Key {
+        uint32_t position;
+        uint32_t uv;
+        uint32_t normal;
+    };
+
+    const std::vector<Key>& keys() const { return keys_; }
+
+private:
+    void grow(){
+        std::vector<uint32_t> slots(std::max((size_t)1024, slots_.size() * 2), NO_INDEX);
+        size_t mask = slots.size() - 1;
+        for(uint32_t vertex = 0; vertex < keys_.size(); vertex++){
+            const Key& key = keys_[vertex];
+            size_t slot = (hash_key(key.position, key.uv, key.normal) >> 32) & mask;
+            while(slots[slot] != NO_INDEX){
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = vertex;
+        }
+        slots_.swap(slots);
+    }
+
+    std::vector<uint32_t> slots_;
+    std::vector<Key> keys_;
+};
+
+bool build_obj_mesh(std::vector<ObjChunk>& chunks, unsigned threads, ImportedMesh& mesh){
+    // Offsets of every chunk's attributes and corners in the merged lists
+    size_t totals[3] = {0, 0, 0};
+    size_t corner_count = 0;
+    for(ObjChunk& chunk : chunks){
+        memcpy(chunk.bases, totals, sizeof(totals));
+        chunk.first_corner = corner_count;
+        totals[0] += chunk.positions.size() / 3;
+        totals[1] += chunk.uvs.size() / 2;
+        totals[2] += chunk.normals.size() / 3;
+        corner_count += chunk.corners.size();
+    }
+    if(totals[0] == 0 || corner_count == 0){
+        return false;
+    }
+
+    std::vector<float> positions(totals[0] * 3);
+    std::vector<float> uvs(totals[1] * 2);
+    std::vector<float> normals(totals[2] * 3);
+    std::vector<uint32_t> keys(corner_count * 3);
+    std::atomic<bool> valid(true);
+
+    // Corners are welded unless positions are all there is; each is hashed
+    // once here and counted towards its shard, per chunk
+    bool weld = totals[1] > 0 || totals[2] > 0;
+    size_t shard_count = threads;
+    std::vector<uint64_t> hashes(weld ? corner_count : 0);
+    std::vector<size_t> shard_offsets(weld ? chunks.size() * shard_count : 0, 0);
+    parallel_for(threads, chunks.size(), [&](size_t i){
+        ObjChunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.bases[0] * 3);
+        std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.bases[1] * 2);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.bases[2] * 3);
+
+        // Resolve to 0-based indices into the merged attributes
+        uint32_t* key = &keys[chunk.first_corner * 3];
+        uint64_t* hash = weld ? &hashes[chunk.first_corner] : nullptr;
+        for(const ObjCorner& corner : chunk.corners){
+            for(int slot = 0; slot < 3; slot++, key++){
+                int64_t index = corner.index[slot];
+                if(!(corner.present & (1 << slot))){
+                    *key = NO_INDEX;
+                    continue;
+                }
+                index = (corner.relative & (1 << slot)) ? (int64_t)chunk.bases[slot] + index : index - 1;
+                if(index < 0 || index >= (int64_t)totals[slot]){
+                    valid = false;
+                    index = 0;
+                }
+                *key = (uint32_t)index;
+            }
+            if(weld){
+                *hash = hash_key(key[-3], key[-2], key[-1]);
+                shard_offsets[i * shard_count + *hash++ % shard_count]++;
+            }
+        }
+        std::vector<ObjCorner>().swap(chunk.corners);
+    });
+    if(!valid){
+        report_error(LogCategory::ASSET, "ERROR: OBJ face refers to a missing vertex\n");
+        return false;
+    }
+
+    mesh.indices.resize(corner_count);
+    bool has_uvs = totals[1] > 0;
+    bool has_normals = totals[2] > 0;
+
+    // Positions only: they are the vertices already
+    if(!weld){
+        mesh.positions.swap(positions);
+        mesh.normals.clear();
+        mesh.uvs.clear();
+        for(size_t i = 0; i < corner_count; i++){
+            mesh.indices[i] = keys[i * 3];
+        }
+        return true;
+    }
+
+    // Bucket the corners by shard, each bucket in corner order; one shard
+    // takes every corner as it is
+    std::vector<size_t> shard_corners(shard_count + 1, 0);
+    size_t offset = 0;
+    for(size_t shard = 0; shard < shard_count; shard++){
+        shard_corners[shard] = offset;
+        for(size_t i = 0; i < chunks.size(); i++){
+            size_t count = shard_offsets[i * shard_count + shard];
+            shard_offsets[i * shard_count + shard] = offset;
+            offset += count;
+        }
+    }
+    shard_corners[shard_count] = offset;
+    std::vector<uint32_t> order(shard_count > 1 ? corner_count : 0);
+    parallel_for(threads, shard_count > 1 ? chunks.size() : 0, [&](size_t i){
+        size_t begin = chunks[i].first_corner;
+        size_t end = i + 1 < chunks.size() ? chunks[i + 1].first_corner : corner_count;
+        size_t* offsets = &shard_offsets[i * shard_count];
+        for(size_t corner = begin; corner < end; corner++){
+            order[offsets[hashes[corner] % shard_count]++] = (uint32_t)corner;
+        }
+    });
+
+    // Weld equal corners into vertices; each shard owns the keys whose
+    // hash falls to it and walks only those, so shards need no locks
+    std::vector<WeldTable> shards(shard_count);
+    std::vector<uint32_t> local(corner_count);
+    parallel_for(threads, shard_count, [&](size_t shard){
+        for(size_t i = shard_corners[shard]; i < shard_corners[shard + 1]; i++){
+            uint32_t corner = shard_count > 1 ? order[i] : (uint32_t)i;
+            const uint32_t* key = &keys[corner * 3];
+            local[corner] = shards[shard].insert(key[0], key[1], key[2], hashes[corner]);
+        }
+    });
+
+    std::vector<size_t> shard_bases(shard_count + 1, 0);
+    for(size_t shard = 0; shard < shard_count; shard++){
+        shard_bases[shard + 1] = shard_bases[shard] + shards[shard].keys().size();
+    }
+    size_t vertex_count = shard_bases[shard_count];
+    mesh.positions.assign(vertex_count * 3, 0.0f);
+    mesh.uvs.assign(has_uvs ? vertex_count * 2 : 0, 0.0f);
+    mesh.normals.assign(has_normals ? vertex_count * 3 : 0, 0.0f);
+
+    parallel_for(threads, shard_count, [&](size_t shard){
+        size_t vertex = shard_bases[shard];
+        for(const WeldTable::Key& key : shards[shard].keys()){
+            std::copy(&positions[key.position * 3], &positions[key.position * 3] + 3, &mesh.positions[vertex * 3]);
+            if(has_uvs && key.uv != NO_INDEX){
+                std::copy(&uvs[key.uv * 2], &uvs[key.uv * 2] + 2, &mesh.uvs[vertex * 2]);
+            }
+            if(has_normals && key.normal != NO_INDEX){
+                std::copy(&normals[key.normal * 3], &normals[key.normal * 3] + 3, &mesh.normals[vertex * 3]);
+            }
+            vertex++;
+        }
+    });
+
+    parallel_for(threads, chunks.size(), [&](size_t i){
+        size_t begin = chunks[i].first_corner;
+        size_t end = i + 1 < chunks.size() ? chunks[i + 1].first_corner : corner_count;
+        for(size_t corner = begin; corner < end; corner++){
+            size_t shard = hashes[corner] % shard_count;
+            mesh.indices[corner] = (uint32_t)(shard_bases[shard] + local[corner]);
+        }
+    });
+    return true;
+}
+
+// PLY
+
+enum class PlyType : uint8_t {
+    INT8,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    FLOAT32,
+    FLOAT64,
+    INVALID,
+};
+
+enum class PlyFormat : uint8_t {
+    ASCII,
+    BINARY_LITTLE_ENDIAN,
+    BINARY_BIG_ENDIAN,
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type = PlyType::INVALID;        // item type for lists
+    PlyType count_type = PlyType::INVALID;  // INVALID unless a list
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count = 0;
+    std::vector<PlyProperty> properties;
+};
+
+size_t ply_type_size(PlyType type){
+    const size_t SIZES[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+    return SIZES[(int)type];
+}
+
+PlyType ply_type(const std::string& name){
+    const char* NAMES[][2] = {
+        {"char", "int8"},
+        {"uchar", "uint8"},
+        {"short", "int16"},
+        {"ushort", "uint16"},
+        {"int", "int32"},
+        {"uint", "uint32"},
+        {"float", "float32"},
+        {"double", "float64"},
+    };
+    for(int i = 0; i < 8; i++){
+        if(name == NAMES[i][0] || name == NAMES[i][1]){
+            return (PlyType)i;
+        }
+    }
+    return PlyType::INVALID;
+}
+
+double read_ply_value(const unsigned char* data, PlyType type, bool swap){
+    unsigned char bytes[8];
+    size_t size = ply_type_size(type);
+    for(size_t i = 0; i < size; i++){
+        bytes[i] = swap ? data[size - 1 - i] : data[i];
+    }
+    switch(type){
+        case PlyType::INT8: { int8_t v; memcpy(&v, bytes, 1); return v; }
+        case PlyType::UINT8: return bytes[0];
+        case PlyType::INT16: { int16_t v; memcpy(&v, bytes, 2); return v; }
+        case PlyType::UINT16: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+        case PlyType::INT32: { int32_t v; memcpy(&v, bytes, 4); return v; }
+        case PlyType::UINT32: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+        case PlyType::FLOAT32: { float v; memcpy(&v, bytes, 4); return v; }
+        case PlyType::FLOAT64: { double v; memcpy(&v, bytes, 8); return v; }
+        default: return 0.0;
+    }
+}
+
+struct PlyHeader {
+    PlyFormat format = PlyFormat::ASCII;
+    std::vector<PlyElement> elements;
+    const char* body = nullptr;
+};
+
+bool parse_ply_header(const char* data, size_t size, PlyHeader& header){
+    const char* end = data + size;
+    if(size < 4 || memcmp(data, "ply", 3) != 0){
+        return false;
+    }
+    bool has_format = false;
+    const char* cursor = next_line(data, end);
+    while(cursor < end){
+        const char* line_end = next_line(cursor, end);
+        std::vector<std::string> words;
+        const char* word = cursor;
+        while(word < line_end){
+            skip_blanks(word, line_end);
+            const char* stop = word;
+            while(stop < line_end && !is_blank(*stop) && *stop != '\n'){
+                stop++;
+            }
+            if(stop > word){
+                words.emplace_back(word, stop);
+            }
+            word = stop < line_end ? stop + 1 : line_end;
+        }
+        cursor = line_end;
+
+        if(words.empty() || words[0] == "comment" || words[0] == "obj_info"){
+            continue;
+        }
+        if(words[0] == "end_header"){
+            header.body = cursor;
+            return has_format;
+        }
+        if(words[0] == "format" && words.size() >= 2){
+            has_format = true;
+            if(words[1] == "ascii"){
+                header.format = PlyFormat::ASCII;
+            } else if(words[1] == "binary_little_endian"){
+                header.format = PlyFormat::BINARY_LITTLE_ENDIAN;
+            } else if(words[1] == "binary_big_endian"){
+                header.format = PlyFormat::BINARY_BIG_ENDIAN;
+            } else {
+                return false;
+            }
+        } else if(words[0] == "element" && words.size() >= 3){
+            PlyElement element;
+            element.name = words[1];
+            element.count = strtoull(words[2].c_str(), nullptr, 10);
+            header.elements.push_back(element);
+        } else if(words[0] == "property" && !header.elements.empty()){
+            PlyProperty property;
+            if(words.size() >= 5 && words[1] == "list"){
+                property.count_type = ply_type(words[2]);
+                property.type = ply_type(words[3]);
+                property.name = words[4];
+                if(property.count_type == PlyType::INVALID){
+                    return false;
+                }
+            } else if(words.size() >= 3){
+                property.type = ply_type(words[1]);
+                property.name = words[2];
+            }
+            if(property.type == PlyType::INVALID){
+                return false;
+            }
+            header.elements.back().properties.push_back(property);
+        }
+    }
+    return false;
+}
+
+// Which vertex properties land in which output stream
+struct PlyVertexLayout {
+    int position[3] = {-1, -1, -1};
+    int normal[3] = {-1, -1, -1};
+    int uv[2] = {-1, -1};
+};
+
+PlyVertexLayout ply_vertex_layout(const PlyElement& element){
+    PlyVertexLayout layout;
+    for(int i = 0; i < (int)element.properties.size(); i++){
+        const std::string& name = element.properties[i].name;
+        if(element.properties[i].count_type != PlyType::INVALID){
+            continue;
+        }
+        if(name == "x" || name == "y" || name == "z"){
+            layout.position[name[0] - 'x'] = i;
+        } else if(name == "nx" || name == "ny" || name == "nz"){
+            layout.normal[name[1] - 'x'] = i;
+        } else if(name == "u" || name == "s" || name == "texture_u" || name == "texture_s"){
+            layout.uv[0] = i;
+        } else if(name == "v" || name == "t" || name == "texture_v" || name == "texture_t"){
+            layout.uv[1] = i;
+        }
+    }
+    return layout;
+}
+
+void store_ply_vertex(const PlyVertexLayout& layout, const double* values, size_t vertex, ImportedMesh& mesh){
+    for(int axis = 0; axis < 3; axis++){
+        mesh.positions[vertex * 3 + axis] = layout.position[axis] >= 0 ? (float)values[layout.position[axis]] : 0.0f;
+    }
+    if(!mesh.normals.empty()){
+        for(int axis = 0; axis < 3; axis++){
+            mesh.normals[vertex * 3 + axis] = layout.normal[axis] >= 0 ? (float)values[layout.normal[axis]] : 0.0f;
+        }
+    }
+    if(!mesh.uvs.empty()){
+        for(int axis = 0; axis < 2; axis++){
+            mesh.uvs[vertex * 2 + axis] = layout.uv[axis] >= 0 ? (float)values[layout.uv[axis]] : 0.0f;
+        }
+    }
+}
+
+int face_index_property(const PlyElement& element){
+    for(int i = 0; i < (int)element.properties.size(); i++){
+        const PlyProperty& property = element.properties[i];
+        if(property.count_type != PlyType::INVALID && (property.name == "vertex_indices" || property.name == "vertex_index")){
+            return i;
+        }
+    }
+    return -1;
+}
+
+void fan(const uint32_t* polygon, size_t count, std::vector<uint32_t>& indices){
+    for(size_t i = 2; i < count; i++){
+        indices.push_back(polygon[0]);
+        indices.push_back(polygon[i - 1]);
+        indices.push_back(polygon[i]);
+    }
+}
+
+// Size of one record, or 0 if it holds lists and must be walked
+size_t ply_fixed_size(const PlyElement& element){
+    size_t size = 0;
+    for(const PlyProperty& property : element.properties){
+        if(property.count_type != PlyType::INVALID){
+            return 0;
+        }
+        size += ply_type_size(property.type);
+    }
+    return size;
+}
+
+// Walks one binary record, returning its end; collects the scalar
+// values and the face polygon
+const unsigned char* walk_ply_record(
+    const unsigned char* cursor,
+    const unsigned char* end,
+    const PlyElement& element,
+    int index_property,
+    bool swap,
+    std::vector<double>& values,
+    std::vector<uint32_t>& polygon
+){
+    values.assign(element.properties.size(), 0.0);
+    for(int i = 0; i < (int)element.properties.size(); i++){
+        const PlyProperty& property = element.properties[i];
+        if(property.count_type == PlyType::INVALID){
+            if(cursor + ply_type_size(property.type) > end){
+                return nullptr;
+            }
+            values[i] = read_ply_value(cursor, property.type, swap);
+            cursor += ply_type_size(property.type);
+            continue;
+        }
+        if(cursor + ply_type_size(property.count_type) > end){
+            return nullptr;
+        }
+        size_t count = (size_t)read_ply_value(cursor, property.count_type, swap);
+        cursor += ply_type_size(property.count_type);
+        size_t item = ply_type_size(property.type);
+        if(cursor + count * item > end){
+            return nullptr;
+        }
+        if(i == index_property){
+            polygon.resize(count);
+            for(size_t j = 0; j < count; j++){
+                polygon[j] = (uint32_t)read_ply_value(cursor + j * item, property.type, swap);
+            }
+        }
+        cursor += count * item;
+    }
+    return cursor <= end ? cursor : nullptr;
+}
+
+bool import_binary_ply(
+    const PlyHeader& header,
+    const char* end,
+    unsigned threads,
+    size_t chunks,
+    ImportedMesh& mesh
+){
+    bool swap = header.format == PlyFormat::BINARY_BIG_ENDIAN;
+    const unsigned char* cursor = (const unsigned char*)header.body;
+    const unsigned char* limit = (const unsigned char*)end;
+    std::vector<double> values;
+    std::vector<uint32_t> polygon;
+
+    for(const PlyElement& element : header.elements){
+        size_t record = ply_fixed_size(element);
+        int index_property = face_index_property(element);
+        PlyVertexLayout layout = ply_vertex_layout(element);
+
+        if(element.name == "vertex" && record > 0){
+            if(cursor + element.count * record > limit){
+                return false;
+            }
+            size_t per_chunk = element.count / chunks + 1;
+            const unsigned char* vertices = cursor;
+            parallel_for(threads, chunks, [&](size_t chunk){
+                std::vector<double> values(element.properties.size());
+                size_t first = chunk * per_chunk;
+                size_t last = std::min(element.count, first + per_chunk);
+                for(size_t vertex = first; vertex < last; vertex++){
+                    const unsigned char* p = vertices + vertex * record;
+                    for(size_t i = 0; i < element.properties.size(); i++){
+                        values[i] = read_ply_value(p, element.properties[i].type, swap);
+                        p += ply_type_size(element.properties[i].type);
+                    }
+                    store_ply_vertex(layout, values.data(), vertex, mesh);
+                }
+            });
+            cursor += element.count * record;
+            continue;
+        }
+
+        if(element.name == "face" && index_property >= 0 && element.properties.size() == 1){
+            // Triangle-only faces have a fixed size; read them in parallel
+            // and fall back to a walk if any record is not a triangle
+            const PlyProperty& property = element.properties[0];
+            size_t count_size = ply_type_size(property.count_type);
+            size_t item = ply_type_size(property.type);
+            size_t triangle = count_size + 3 * item;
+            if(cursor + element.count * triangle <= limit){
+                size_t start = mesh.indices.size();
+                mesh.indices.resize(start + element.count * 3);
+                std::atomic<bool> triangles(true);
+                size_t per_chunk = element.count / chunks + 1;
+                const unsigned char* faces = cursor;
+                parallel_for(threads, chunks, [&](size_t chunk){
+                    size_t first = chunk * per_chunk;
+                    size_t last = std::min(element.count, first + per_chunk);
+                    for(size_t face = first; face < last && triangles; face++){
+                        const unsigned char* p = faces + face * triangle;
+                        if(read_ply_value(p, property.count_type, swap) != 3.0){
+                            triangles = false;
+                            break;
+                        }
+                        for(size_t j = 0; j < 3; j++){
+                            mesh.indices[start + face * 3 + j] = (uint32_t)read_ply_value(p + count_size + j * item, property.type, swap);
+                        }
+                    }
+                });
+                if(triangles){
+                    cursor += element.count * triangle;
+                    continue;
+                }
+                mesh.indices.resize(start);
+            }
+        }
+
+        // Anything else is walked record by record
+        for(size_t i = 0; i < element.count; i++){
+            cursor = walk_ply_record(cursor, limit, element, index_property, swap, values, polygon);
+            if(!cursor){
+                return false;
+            }
+            if(element.name == "vertex"){
+                store_ply_vertex(layout, values.data(), i, mesh);
+            } else if(element.name == "face" && index_property >= 0){
+                fan(polygon.data(), polygon.size(), mesh.indices);
+            }
+        }
+    }
+    return true;
+}
+
+bool import_ascii_ply(
+    const PlyHeader& header,
+    const char* end,
+    unsigned threads,
+    size_t chunk_total,
+    ImportedMesh& mesh
+){
+    // Lines per chunk first, so every chunk knows which records it holds
+    std::vector<TextRange> chunks = split_lines(header.body, end, chunk_total);
+    std::vector<size_t> first_line(chunks.size() + 1, 0);
+    parallel_for(threads, chunks.size(), [&](size_t i){
+        size_t lines = std::count(chunks[i].begin, chunks[i].end, '\n');
+        if(chunks[i].end == end && chunks[i].end > chunks[i].begin && chunks[i].end[-1] != '\n'){
+            lines++;
+        }
+        first_line[i + 1] = lines;
+    });
+    for(size_t i = 0; i < chunks.size(); i++){
+        first_line[i + 1] += first_line[i];
+    }
+
+    // Line ranges of each element
+    std::vector<size_t> element_lines(header.elements.size() + 1, 0);
+    for(size_t i = 0; i < header.elements.size(); i++){
+        element_lines[i + 1] = element_lines[i] + header.elements[i].count;
+    }
+    if(first_line.back() < element_lines.back()){
+        return false;
+    }
+
+    std::vector<PlyVertexLayout> layouts;
+    std::vector<int> index_properties;
+    for(const PlyElement& element : header.elements){
+        layouts.push_back(ply_vertex_layout(element));
+        index_properties.push_back(face_index_property(element));
+    }
+
+    std::vector<std::vector<uint32_t>> chunk_indices(chunks.size());
+    std::atomic<bool> valid(true);
+    parallel_for(threads, chunks.size(), [&](size_t chunk){
+        std::vector<double> values;
+        std::vector<uint32_t> polygon;
+        size_t line = first_line[chunk];
+        size_t element = 0;
+        for(const char* cursor = chunks[chunk].begin; cursor < chunks[chunk].end; line++){
+            const char* line_end = next_line(cursor, chunks[chunk].end);
+            while(element < header.elements.size() && line >= element_lines[element + 1]){
+                element++;
+            }
+            if(element >= header.elements.size()){
+                break;
+            }
+
+            const PlyElement& info = header.elements[element];
+            bool is_vertex = info.name == "vertex";
+            bool is_face = info.name == "face";
+            if(is_vertex || (is_face && index_properties[element] >= 0)){
+                bool ok = true;
+                values.assign(info.properties.size(), 0.0);
+                for(int i = 0; i < (int)info.properties.size() && ok; i++){
+                    const PlyProperty& property = info.properties[i];
+                    float value = 0.0f;
+                    if(property.count_type == PlyType::INVALID){
+                        ok = parse_float(cursor, line_end, value);
+                        values[i] = value;
+                        continue;
+                    }
+                    int64_t count = 0;
+                    ok = parse_int(cursor, line_end, count) && count >= 0;
+                    bool indices = i == index_properties[element];
+                    if(indices){
+                        polygon.clear();
+                    }
+                    for(int64_t j = 0; j < count && ok; j++){
+                        int64_t index = 0;
+                        if(indices){
+                            ok = parse_int(cursor, line_end, index) && index >= 0;
+                            polygon.push_back((uint32_t)index);
+                        } else {
+                            ok = parse_float(cursor, line_end, value);
+                        }
+                    }
+                }
+                if(!ok){
+                    valid = false;
+                }
+                if(is_vertex){
+                    store_ply_vertex(layouts[element], values.data(), line - element_lines[element], mesh);
+                } else {
+                    fan(polygon.data(), polygon.size(), chunk_indices[chunk]);
+                }
+            }
+            cursor = line_end;
+        }
+    });
+
+    for(const std::vector<uint32_t>& indices : chunk_indices){
+        mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+    }
+    return valid;
+}
+
+bool has_extension(const char* path, const char* extension){
+    size_t length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return length >= extension_length && strcasecmp(path + length - extension_length, extension) == 0;
+}
+
+}
+
+bool parse_float(const char*& cursor, const char* end, float& value){
+    const char* p = cursor;
+    skip_blanks(p, end);
+    bool negative = p < end && *p == '-';
+    if(p < end && (*p == '-' || *p == '+')){
+        p++;
+    }
+
+    // Up to 19 significant digits in an integer, the rest only scale
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for(; p < end && *p >= '0' && *p <= '9'; p++, any = true){
+        if(digits < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+        }
+    }
+    if(p < end && *p == '.'){
+        for(p++; p < end && *p >= '0' && *p <= '9'; p++, any = true){
+            if(digits < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if(!any){
+        return false;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+        const char* e = p + 1;
+        bool negative_exponent = e < end && *e == '-';
+        if(e < end && (*e == '-' || *e == '+')){
+            e++;
+        }
+        if(e < end && *e >= '0' && *e <= '9'){
+            int power = 0;
+            for(; e < end && *e >= '0' && *e <= '9'; e++){
+                power = power < 10000 ? power * 10 + (*e - '0') : power;
+            }
+            exponent += negative_exponent ? -power : power;
+            p = e;
+        }
+    }
+
+    // Exact when both the mantissa and the power of ten are exact doubles
+    double result = (double)mantissa;
+    if(mantissa != 0){
+        while(exponent > 22){
+            result *= 1e22;
+            exponent -= 22;
+        }
+        while(exponent < -22){
+            result /= 1e22;
+            exponent += 22;
+        }
+        result = exponent >= 0 ? result * POWERS_OF_TEN[exponent] : result / POWERS_OF_TEN[-exponent];
+    }
+    value = (float)(negative ? -result : result);
+    cursor = p;
+    return true;
+}
+
+bool import_obj(const char* data, size_t size, ImportedMesh& mesh, const MeshImportOptions& options, MeshImportStats* stats){
+    unsigned threads = thread_count(options);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<TextRange> ranges = split_lines(data, data + size, chunk_count(size, threads, options));
+    std::vector<ObjChunk> chunks(ranges.size());
+    for(size_t i = 0; i < ranges.size(); i++){
+        chunks[i].text = ranges[i];
+    }
+    parallel_for(threads, chunks.size(), [&](size_t i){
+        parse_obj_chunk(chunks[i]);
+    });
+    double parse_ms = elapsed_ms(start);
+
+    size_t bad_lines = 0;
+    for(const ObjChunk& chunk : chunks){
+        bad_lines += chunk.bad_lines;
+    }
+    if(bad_lines > 0){
+        report_error(LogCategory::ASSET, "ERROR: skipped %zu malformed OBJ lines\n", bad_lines);
+    }
+
+    start = std::chrono::steady_clock::now();
+    bool built = build_obj_mesh(chunks, threads, mesh);
+    if(stats){
+        *stats = {size, threads, chunks.size(), parse_ms, elapsed_ms(start)};
+    }
+    return built;
+}
+
+bool import_ply(const char* data, size_t size, ImportedMesh& mesh, const MeshImportOptions& options, MeshImportStats* stats){
+    unsigned threads = thread_count(options);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    PlyHeader header;
+    if(!parse_ply_header(data, size, header)){
+        report_error(LogCategory::ASSET, "ERROR: not a PLY file or unsupported header\n");
+        return false;
+    }
+    const PlyElement* vertices = nullptr;
+    for(const PlyElement& element : header.elements){
+        vertices = element.name == "vertex" ? &element : vertices;
+    }
+    if(!vertices || vertices->count == 0){
+        report_error(LogCategory::ASSET, "ERROR: PLY file has no vertices\n");
+        return false;
+    }
+
+    PlyVertexLayout layout = ply_vertex_layout(*vertices);
+    mesh.positions.assign(vertices->count * 3, 0.0f);
+    mesh.normals.assign(layout.normal[0] >= 0 ? vertices->count * 3 : 0, 0.0f);
+    mesh.uvs.assign(layout.uv[0] >= 0 ? vertices->count * 2 : 0, 0.0f);
+    mesh.indices.clear();
+
+    size_t body = (size_t)(data + size - header.body);
+    size_t chunks = chunk_count(body, threads, options);
+    bool parsed = header.format == PlyFormat::ASCII
+        ? import_ascii_ply(header, data + size, threads, chunks, mesh)
+        : import_binary_ply(header, data + size, threads, chunks, mesh);
+    if(!parsed){
+        report_error(LogCategory::ASSET, "ERROR: PLY body is truncated or malformed\n");
+        return false;
+    }
+
+    for(uint32_t index : mesh.indices){
+        if(index >= vertices->count){
+            report_error(LogCategory::ASSET, "ERROR: PLY face refers to a missing vertex\n");
+            return false;
+        }
+    }
+    if(stats){
+        *stats = {size, threads, chunks, elapsed_ms(start), 0.0};
+    }
+    return !mesh.indices.empty();
+}
+
+bool import_mesh(const char* path, ImportedMesh& mesh, const MeshImportOptions& options, MeshImportStats* stats){
+    MappedFile file;
+    if(!file.open(path)){
+        return false;
+    }
+
+    bool imported;
+    if(has_extension(path, ".obj")){
+        imported = import_obj(file.data(), file.size(), mesh, options, stats);
+    } else if(has_extension(path, ".ply")){
+        imported = import_ply(file.data(), file.size(), mesh, options, stats);
+    } else {
+        report_error(LogCategory::ASSET, "ERROR: %s is not an OBJ or PLY file\n", path);
+        return false;
+    }
+
+    if(imported){
+        GL_LOG_INFO(
+            ASSET,
+            "mesh %s: %zu vertices, %zu triangles\n",
+            path,
+            mesh.vertex_count(),
+            mesh.indices.size() / 3
+        );
+    } else {
+        report_error(LogCategory::ASSET, "ERROR: could not import mesh %s\n", path);
+    }
+    return imported;
+}
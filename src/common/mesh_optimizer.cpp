@@ -0,0 +1,261 @@
+#include "mesh_optimizer.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "hash.h"
+
+namespace {
+
+const uint32_t NO_INDEX = 0xffffffffu;
+
+// Forsyth's scoring constants
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+struct VertexState {
+    int cache_position = -1;
+    float score = 0.0f;
+    uint32_t remaining = 0;         // triangles not yet emitted
+    uint32_t first_triangle = 0;    // into the adjacency list
+};
+
+float vertex_score(const VertexState& vertex){
+    if(vertex.remaining == 0){
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if(vertex.cache_position >= 0){
+        // The last triangle's vertices get a fixed score so the next
+        // triangle does not simply reuse the same edge
+        if(vertex.cache_position < 3){
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scale = 1.0f / (VERTEX_CACHE_SIZE - 3);
+            score = powf(1.0f - (vertex.cache_position - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    // Favour vertices with few triangles left, to finish them off
+    score += VALENCE_BOOST_SCALE * powf((float)vertex.remaining, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+}
+
+size_t deduplicate_vertices(
+    const void* vertices,
+    size_t vertex_count,
+    size_t stride,
+    std::vector<unsigned char>& unique,
+    std::vector<uint32_t>& indices
+){
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    unique.clear();
+    indices.resize(vertex_count);
+
+    // Open addressing over unique vertex numbers, keyed by content hash
+    size_t table_size = 16;
+    while(table_size < vertex_count * 2){
+        table_size *= 2;
+    }
+    std::vector<uint32_t> table(table_size, NO_INDEX);
+    size_t unique_count = 0;
+
+    for(size_t i = 0; i < vertex_count; i++){
+        const unsigned char* vertex = bytes + i * stride;
+        size_t slot = fnv1a(vertex, stride) & (table_size - 1);
+        for(;; slot = (slot + 1) & (table_size - 1)){
+            uint32_t candidate = table[slot];
+            if(candidate == NO_INDEX){
+                table[slot] = (uint32_t)unique_count;
+                unique.insert(unique.end(), vertex, vertex + stride);
+                indices[i] = (uint32_t)unique_count++;
+                break;
+            }
+            if(memcmp(unique.data() + candidate * stride, vertex, stride) == 0){
+                indices[i] = candidate;
+                break;
+            }
+        }
+    }
+    return unique_count;
+}
+
+void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count){
+    size_t triangle_count = index_count / 3;
+    if(triangle_count == 0){
+        return;
+    }
+
+    // Vertex -> triangles adjacency, flattened
+    std::vector<VertexState> vertices(vertex_count);
+    for(size_t i = 0; i < triangle_count * 3; i++){
+        vertices[indices[i]].remaining++;
+    }
+    uint32_t offset = 0;
+    for(VertexState& vertex : vertices){
+        vertex.first_triangle = offset;
+        offset += vertex.remaining;
+    }
+    std::vector<uint32_t> adjacency(offset);
+    std::vector<uint32_t> fill(vertex_count, 0);
+    for(size_t triangle = 0; triangle < triangle_count; triangle++){
+        for(int corner = 0; corner < 3; corner++){
+            uint32_t vertex = indices[triangle * 3 + corner];
+            adjacency[vertices[vertex].first_triangle + fill[vertex]++] = (uint32_t)triangle;
+        }
+    }
+
+    for(VertexState& vertex : vertices){
+        vertex.score = vertex_score(vertex);
+    }
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for(size_t triangle = 0; triangle < triangle_count; triangle++){
+        triangle_scores[triangle] =
+            vertices[indices[triangle * 3]].score +
+            vertices[indices[triangle * 3 + 1]].score +
+            vertices[indices[triangle * 3 + 2]].score;
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(triangle_count * 3);
+    uint32_t cache[VERTEX_CACHE_SIZE + 3];
+    size_t cache_count = 0;
+    size_t scan = 0;                // next candidate when the cache has none
+    uint32_t best = NO_INDEX;
+
+    while(output.size() < triangle_count * 3){
+        // Cache dried up: fall back to the best unemitted triangle in order
+        if(best == NO_INDEX){
+            while(emitted[scan]){
+                scan++;
+            }
+            best = (uint32_t)scan;
+        }
+
+        emitted[best] = true;
+        uint32_t corners[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+        output.insert(output.end(), corners, corners + 3);
+
+        // Drop the triangle from its vertices' adjacency lists
+        for(uint32_t vertex : corners){
+            VertexState& state = vertices[vertex];
+            uint32_t* list = adjacency.data() + state.first_triangle;
+            for(uint32_t i = 0; i < state.remaining; i++){
+                if(list[i] == best){
+                    list[i] = list[state.remaining - 1];
+                    break;
+                }
+            }
+            state.remaining--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        uint32_t next_cache[VERTEX_CACHE_SIZE + 3];
+        size_t next_count = 0;
+        for(uint32_t vertex : corners){
+            next_cache[next_count++] = vertex;
+        }
+        for(size_t i = 0; i < cache_count; i++){
+            uint32_t vertex = cache[i];
+            if(vertex != corners[0] && vertex != corners[1] && vertex != corners[2]){
+                next_cache[next_count++] = vertex;
+            }
+        }
+
+        // Rescore everything that was or is cached, then pick the best
+        // triangle around the cache once all deltas are in
+        for(size_t i = 0; i < next_count; i++){
+            VertexState& state = vertices[next_cache[i]];
+            state.cache_position = i < VERTEX_CACHE_SIZE ? (int)i : -1;
+            float score = vertex_score(state);
+            float delta = score - state.score;
+            state.score = score;
+
+            const uint32_t* list = adjacency.data() + state.first_triangle;
+            for(uint32_t j = 0; j < state.remaining; j++){
+                triangle_scores[list[j]] += delta;
+            }
+        }
+        best = NO_INDEX;
+        float best_score = -1.0f;
+        for(size_t i = 0; i < next_count && i < VERTEX_CACHE_SIZE; i++){
+            const VertexState& state = vertices[next_cache[i]];
+            const uint32_t* list = adjacency.data() + state.first_triangle;
+            for(uint32_t j = 0; j < state.remaining; j++){
+                if(triangle_scores[list[j]] > best_score){
+                    best_score = triangle_scores[list[j]];
+                    best = list[j];
+                }
+            }
+        }
+
+        cache_count = next_count < VERTEX_CACHE_SIZE ? next_count : VERTEX_CACHE_SIZE;
+        memcpy(cache, next_cache, cache_count * sizeof(uint32_t));
+    }
+
+    memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t optimize_vertex_fetch(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count){
+    std::vector<uint32_t> remap(vertex_count, NO_INDEX);
+    std::vector<unsigned char> reordered(vertex_count * stride);
+    const unsigned char* source = (const unsigned char*)vertices;
+    uint32_t next = 0;
+
+    for(size_t i = 0; i < index_count; i++){
+        uint32_t vertex = indices[i];
+        if(remap[vertex] == NO_INDEX){
+            memcpy(reordered.data() + next * stride, source + vertex * stride, stride);
+            remap[vertex] = next++;
+        }
+        indices[i] = remap[vertex];
+    }
+
+    memcpy(vertices, reordered.data(), next * stride);
+    return next;
+}
+
+float compute_acmr(const uint32_t* indices, size_t index_count, size_t vertex_count, size_t cache_size){
+    size_t triangle_count = index_count / 3;
+    if(triangle_count == 0){
+        return 0.0f;
+    }
+
+    // FIFO: a vertex is a hit while fewer than cache_size misses came after it
+    std::vector<size_t> inserted(vertex_count, 0);
+    size_t misses = 0;
+    for(size_t i = 0; i < triangle_count * 3; i++){
+        uint32_t vertex = indices[i];
+        if(inserted[vertex] == 0 || misses - inserted[vertex] + 1 > cache_size){
+            misses++;
+            inserted[vertex] = misses;
+        }
+    }
+    return (float)misses / triangle_count;
+}
+
+MeshOptimizeReport optimize_mesh(
+    const void* vertices,
+    size_t vertex_count,
+    size_t stride,
+    std::vector<unsigned char>& out_vertices,
+    std::vector<uint32_t>& out_indices
+){
+    MeshOptimizeReport report;
+    report.vertices_before = vertex_count;
+
+    size_t unique = deduplicate_vertices(vertices, vertex_count, stride, out_vertices, out_indices);
+    report.acmr_before = compute_acmr(out_indices.data(), out_indices.size(), unique);
+
+    optimize_vertex_cache(out_indices.data(), out_indices.size(), unique);
+    report.vertices_after = optimize_vertex_fetch(out_vertices.data(), unique, stride, out_indices.data(), out_indices.size());
+    out_vertices.resize(report.vertices_after * stride);
+    report.acmr_after = compute_acmr(out_indices.data(), out_indices.size(), report.vertices_after);
+    return report;
+}
@@ -0,0 +1,240 @@
+#include "mmap_log_sink.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// Retired segment headers kept alive so a writer that loaded the old pointer
+// just before a rotation can still safely see that it is no longer current
+const size_t MMAP_RETIRED_SEGMENTS = 8;
+
+bool is_segment_name(const char* name, const std::string& base){
+    if(strncmp(name, base.c_str(), base.size()) != 0 || name[base.size()] != '.'){
+        return false;
+    }
+    const char* digits = name + base.size() + 1;
+    if(strlen(digits) != 6){
+        return false;
+    }
+    for(const char* p = digits; *p; p++){
+        if(*p < '0' || *p > '9'){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Deletes every path.NNNNNN left behind by a previous run
+void remove_old_segments(const std::string& path){
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+    std::string base = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    DIR* dir = opendir(directory.c_str());
+    if(!dir){
+        return;
+    }
+    while(dirent* entry = readdir(dir)){
+        if(is_segment_name(entry->d_name, base)){
+            unlink((directory + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+}
+
+}
+
+MmapLogSink::~MmapLogSink(){
+    close();
+}
+
+bool MmapLogSink::open(const char* path, size_t segment_size, unsigned max_segments){
+    close();
+
+    // Segments are whole pages so the mapping has no partial tail
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    path_ = path;
+    segment_size_ = (segment_size + page - 1) / page * page;
+    max_segments_ = max_segments > 0 ? max_segments : 1;
+    rotations_.store(0, std::memory_order_relaxed);
+
+    preamble_.clear();
+    preamble_dropped_ = false;
+    map_failing_ = false;
+    remove_old_segments(path_);
+    Segment* first = map_segment(0);
+    current_.store(first);
+    return first != nullptr;
+}
+
+bool MmapLogSink::write(const void* data, size_t size){
+    if(size > segment_size_){
+        return false;
+    }
+
+    for(;;){
+        Segment* segment = current_.load();
+        if(!segment){
+            return false;
+        }
+
+        // Register as a writer, then make sure the segment was not retired
+        // in the meantime; rotate() swaps current_ before waiting on writers
+        segment->writers.fetch_add(1);
+        if(current_.load() != segment){
+            segment->writers.fetch_sub(1);
+            continue;
+        }
+        if(size > segment->size - segment->start){
+            segment->writers.fetch_sub(1);
+            return false;
+        }
+
+        size_t offset = segment->cursor.fetch_add(size, std::memory_order_relaxed);
+        if(offset + size <= segment->size){
+            memcpy(segment->base + offset, data, size);
+            size_t end = segment->end.load(std::memory_order_relaxed);
+            while(end < offset + size &&
+                  !segment->end.compare_exchange_weak(end, offset + size, std::memory_order_relaxed)){
+            }
+            segment->writers.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+
+        // Segment is full
+        segment->writers.fetch_sub(1, std::memory_order_release);
+        if(!rotate(segment)){
+            return false;
+        }
+    }
+}
+
+void MmapLogSink::append_preamble(const void* data, size_t size){
+    std::lock_guard<std::mutex> lock(rotate_mutex_);
+    preamble_.append((const char*)data, size);
+}
+
+void MmapLogSink::flush(){
+    std::lock_guard<std::mutex> lock(rotate_mutex_);
+    Segment* segment = current_.load();
+    if(segment){
+        msync(segment->base, segment->end.load(std::memory_order_relaxed), MS_ASYNC);
+    }
+}
+
+void MmapLogSink::close(){
+    std::lock_guard<std::mutex> lock(rotate_mutex_);
+    Segment* segment = current_.exchange(nullptr);
+    if(segment){
+        retire_segment(segment);
+    }
+    segments_.clear();
+}
+
+std::string MmapLogSink::segment_path(uint64_t index) const{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%06llu", (unsigned long long)(index % 1000000));
+    return path_ + suffix;
+}
+
+MmapLogSink::Segment* MmapLogSink::map_segment(uint64_t index){
+    std::string path = segment_path(index);
+
+    // Handle IO
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        if(!map_failing_){
+            fprintf(stderr, "ERROR: could not open log segment %s for writing\n", path.c_str());
+        }
+        map_failing_ = true;
+        return nullptr;
+    }
+
+    // Preallocate so the segment is not extended (and fragmented) page by page
+#ifdef __linux__
+    bool sized = posix_fallocate(fd, 0, segment_size_) == 0;
+#else
+    bool sized = ftruncate(fd, segment_size_) == 0;
+#endif
+    void* base = sized ? mmap(NULL, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if(base == MAP_FAILED){
+        if(!map_failing_){
+            fprintf(stderr, "ERROR: could not map %zu byte log segment %s\n", segment_size_, path.c_str());
+        }
+        map_failing_ = true;
+        ::close(fd);
+        unlink(path.c_str());
+        return nullptr;
+    }
+    map_failing_ = false;
+
+    std::unique_ptr<Segment> segment(new Segment());
+    segment->base = (char*)base;
+    segment->size = segment_size_;
+    segment->fd = fd;
+    segment->index = index;
+
+    // The segment is not visible to writers yet, so the preamble goes first
+    if(index > 0 && preamble_.size() <= segment_size_ / 2){
+        memcpy(segment->base, preamble_.data(), preamble_.size());
+        segment->start = preamble_.size();
+        segment->cursor.store(preamble_.size(), std::memory_order_relaxed);
+        segment->end.store(preamble_.size(), std::memory_order_relaxed);
+    } else if(index > 0 && !preamble_dropped_){
+        fprintf(stderr, "ERROR: %zu byte log preamble does not fit in %s\n", preamble_.size(), path.c_str());
+        preamble_dropped_ = true;
+    }
+    segments_.push_back(std::move(segment));
+    return segments_.back().get();
+}
+
+void MmapLogSink::retire_segment(Segment* segment){
+    // Wait for in-flight copies before unmapping
+    while(segment->writers.load(std::memory_order_acquire) != 0){
+        std::this_thread::yield();
+    }
+
+    // IO cleanup; trim the preallocated tail so the file ends at the last record
+    munmap(segment->base, segment->size);
+    if(ftruncate(segment->fd, segment->end.load(std::memory_order_relaxed)) != 0){
+        fprintf(stderr, "ERROR: could not trim log segment %s\n", segment_path(segment->index).c_str());
+    }
+    ::close(segment->fd);
+    segment->base = nullptr;
+    segment->fd = -1;
+
+    if(segments_.size() > MMAP_RETIRED_SEGMENTS){
+        segments_.erase(segments_.begin());
+    }
+}
+
+bool MmapLogSink::rotate(Segment* full){
+    std::lock_guard<std::mutex> lock(rotate_mutex_);
+    if(current_.load() != full){
+        return true;
+    }
+
+    // Keep the full segment current until its successor maps, so a failed
+    // open or fallocate costs this record and not every later one
+    Segment* next = map_segment(full->index + 1);
+    if(!next){
+        return false;
+    }
+
+    // Swap first so new writers go to the next segment, then retire the old one
+    current_.store(next);
+    retire_segment(full);
+    rotations_.fetch_add(1, std::memory_order_relaxed);
+
+    // Bound disk usage to max_segments files
+    if(full->index + 1 >= max_segments_){
+        unlink(segment_path(full->index + 1 - max_segments_).c_str());
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#include "radix_sort.h"
+
+#include <string.h>
+#include <utility>
+
+namespace {
+
+const unsigned RADIX_BITS = 11;
+const unsigned RADIX_SIZE = 1u << RADIX_BITS;
+const uint64_t RADIX_MASK = RADIX_SIZE - 1;
+const unsigned RADIX_PASSES = (64 + RADIX_BITS - 1) / RADIX_BITS;
+
+// Below this a pass costs more in histogram clearing than insertion sort
+const size_t INSERTION_SORT_LIMIT = 64;
+
+void insertion_sort(SortEntry* entries, size_t count){
+    for(size_t i = 1; i < count; i++){
+        SortEntry entry = entries[i];
+        size_t j = i;
+        for(; j > 0 && entries[j - 1].key > entry.key; j--){
+            entries[j] = entries[j - 1];
+        }
+        entries[j] = entry;
+    }
+}
+
+}
+
+void radix_sort(SortEntry* entries, SortEntry* scratch, size_t count){
+    if(count <= INSERTION_SORT_LIMIT){
+        insertion_sort(entries, count);
+        return;
+    }
+
+    // One read for every pass's histogram
+    static thread_local uint32_t histograms[RADIX_PASSES][RADIX_SIZE];
+    memset(histograms, 0, sizeof(histograms));
+    for(size_t i = 0; i < count; i++){
+        uint64_t key = entries[i].key;
+        for(unsigned pass = 0; pass < RADIX_PASSES; pass++){
+            histograms[pass][(key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+        }
+    }
+
+    SortEntry* source = entries;
+    SortEntry* destination = scratch;
+    for(unsigned pass = 0; pass < RADIX_PASSES; pass++){
+        uint32_t* histogram = histograms[pass];
+        unsigned shift = pass * RADIX_BITS;
+
+        // Every key has the same digit, order is unchanged
+        if(histogram[(source[0].key >> shift) & RADIX_MASK] == count){
+            continue;
+        }
+
+        // Counts to starting offsets
+        uint32_t offset = 0;
+        for(unsigned digit = 0; digit < RADIX_SIZE; digit++){
+            uint32_t digit_count = histogram[digit];
+            histogram[digit] = offset;
+            offset += digit_count;
+        }
+
+        for(size_t i = 0; i < count; i++){
+            const SortEntry& entry = source[i];
+            destination[histogram[(entry.key >> shift) & RADIX_MASK]++] = entry;
+        }
+        std::swap(source, destination);
+    }
+
+    if(source != entries){
+        memcpy(entries, source, count * sizeof(SortEntry));
+    }
+}
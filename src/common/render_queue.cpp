@@ -0,0 +1,66 @@
+#include "render_queue.h"
+
+#include <chrono>
+
+#include "gl_state.h"
+
+namespace {
+
+double elapsed_ms(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+void RenderQueue::sort(){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Sort small key/index pairs rather than moving whole items
+    size_t count = items_.size();
+    order_.resize(count);
+    scratch_.resize(count);
+    for(size_t i = 0; i < count; i++){
+        order_[i].key = items_[i].key;
+        order_[i].index = (uint32_t)i;
+    }
+    radix_sort(order_.data(), scratch_.data(), count);
+
+    sorted_ = true;
+    stats_.sort_ms = elapsed_ms(start);
+}
+
+void RenderQueue::submit(GlState& gl_state, UniformRing* ring, GLuint binding){
+    if(!sorted_){
+        sort();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(const SortEntry& entry : order_){
+        const DrawItem& item = items_[entry.index];
+        gl_state.use_program(item.program);
+        gl_state.bind_vertex_array(item.vao);
+        if(item.texture){
+            gl_state.bind_texture(0, GL_TEXTURE_2D, item.texture);
+        }
+        if(ring && item.constants_offset != SIZE_MAX){
+            ring->bind(binding, item.constants_offset, item.constants_size);
+        }
+
+        if(item.index_type){
+            size_t index_size = item.index_type == GL_UNSIGNED_INT ? 4 : (item.index_type == GL_UNSIGNED_SHORT ? 2 : 1);
+            const void* offset = (const void*)((size_t)item.first * index_size);
+            if(item.base_vertex){
+                glDrawElementsBaseVertex(item.mode, item.count, item.index_type, offset, item.base_vertex);
+            } else {
+                glDrawElements(item.mode, item.count, item.index_type, offset);
+            }
+        } else {
+            glDrawArrays(item.mode, item.first, item.count);
+        }
+    }
+
+    stats_.items = items_.size();
+    stats_.submit_ms = elapsed_ms(start);
+    items_.clear();
+    sorted_ = false;
+}
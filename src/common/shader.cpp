@@ -0,0 +1,133 @@
+#include "shader.h"
+
+#include <string>
+
+#include "error_reporter.h"
+#include "shader_cache.h"
+#include "shader_preprocessor.h"
+
+void _print_shader_info_log(GLuint shader){
+    int max_length = 2048;
+    int actual_length = 0;
+    char log[2048];
+
+    // Point locations at the files the preprocessor read
+    glGetShaderInfoLog(shader, max_length, &actual_length, log);
+    std::string annotated = annotate_shader_log(log);
+    report_error_detail(LogCategory::SHADER, shader, "Shader info log GL index %u:\n%s\n", shader, annotated.c_str());
+}
+
+void _print_program_info_log(GLuint program){
+    int max_length = 2048;
+    int actual_length = 0;
+    char log[2048];
+
+    glGetProgramInfoLog(program, max_length, &actual_length, log);
+    report_error_detail(LogCategory::SHADER, program, "Program info log GL index %u:\n%s\n", program, log);
+}
+
+GLuint compile_shader(GLenum type, const char* source, GLint length){
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, &length);
+    glCompileShader(shader);
+    return shader;
+}
+
+GLuint link_program(const GLuint* shaders, size_t count, bool retrievable){
+    GLuint program = glCreateProgram();
+    for(size_t i = 0; i < count; i++){
+        glAttachShader(program, shaders[i]);
+    }
+    if(retrievable){
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+bool check_shader_for_errors(GLuint shader){
+    int params = -1;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &params);
+
+    if(GL_TRUE != params){
+        report_error_detail(
+            LogCategory::SHADER,
+            shader,
+            "ERROR: Gl shader index %i did not compile\n",
+            shader
+        );
+
+        _print_shader_info_log(shader);
+        return false;
+    }
+
+    return true;
+}
+
+bool check_program_for_errors(GLuint program){
+    int params = -1;
+    glGetProgramiv(program, GL_LINK_STATUS, &params);
+
+    if(GL_TRUE != params){
+        report_error_detail(
+            LogCategory::SHADER,
+            program,
+            "ERROR: could not link shader program GL index %u\n",
+            program
+        );
+
+        _print_program_info_log(program);
+        return false;
+    }
+
+    return true;
+}
+
+GLuint build_program(const ShaderSource* sources, size_t count, ProgramBinaryCache* cache){
+    // Try the binary cache first
+    uint64_t key = 0;
+    if(cache && cache->supported()){
+        key = cache->key(sources, count);
+        GLuint program = cache->load(key);
+        if(program){
+            return program;
+        }
+    }
+
+    // Compile every stage
+    const size_t MAX_STAGES = 8;
+    if(count == 0){
+        report_error(LogCategory::SHADER, "ERROR: program with no stages\n");
+        return 0;
+    }
+    if(count > MAX_STAGES){
+        report_error(LogCategory::SHADER, "ERROR: program with %zu stages, at most %zu supported\n", count, MAX_STAGES);
+        return 0;
+    }
+    GLuint shaders[MAX_STAGES] = {};
+    for(size_t i = 0; i < count; i++){
+        shaders[i] = compile_shader(sources[i].type, sources[i].source, sources[i].length);
+    }
+    bool compiled = true;
+    for(size_t i = 0; i < count; i++){
+        compiled = check_shader_for_errors(shaders[i]) && compiled;
+    }
+
+    // Combine Shaders into Shader Program
+    GLuint program = 0;
+    if(compiled){
+        program = link_program(shaders, count, key != 0);
+        if(!check_program_for_errors(program)){
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    for(size_t i = 0; i < count; i++){
+        glDeleteShader(shaders[i]);
+    }
+
+    if(program && key){
+        cache->store(key, program);
+    }
+    return program;
+}
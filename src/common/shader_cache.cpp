@@ -0,0 +1,161 @@
+#include "shader_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include "gl_log_filter.h"
+#include "hash.h"
+
+namespace {
+
+const char PROGRAM_CACHE_MAGIC[4] = {'G', 'L', 'P', 'B'};
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t driver_hash;
+    uint32_t binary_format;
+    uint32_t length;
+};
+
+uint64_t hash_gl_string(GLenum name, uint64_t hash){
+    const char* value = (const char*)glGetString(name);
+    return fnv1a(value ? value : "", hash);
+}
+
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const char* directory) : directory_(directory){
+    // Driver identity goes into every key
+    driver_hash_ = hash_gl_string(GL_RENDERER, FNV_OFFSET_BASIS);
+    driver_hash_ = hash_gl_string(GL_VERSION, driver_hash_);
+    driver_hash_ = hash_gl_string(GL_VENDOR, driver_hash_);
+
+    GLint formats = 0;
+    if(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary){
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    supported_ = formats > 0;
+    if(!supported_){
+        GL_LOG_INFO(SHADER, "shader cache: driver exposes no program binary formats, caching disabled\n");
+        return;
+    }
+
+    if(mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST){
+        GL_LOG_WARN(SHADER, "shader cache: could not create %s, caching disabled\n", directory_.c_str());
+        supported_ = false;
+    }
+}
+
+uint64_t ProgramBinaryCache::key(const ShaderSource* sources, size_t count) const{
+    uint64_t hash = driver_hash_;
+    for(size_t i = 0; i < count; i++){
+        size_t length = sources[i].length < 0 ? strlen(sources[i].source) : (size_t)sources[i].length;
+        hash = hash_combine(hash, sources[i].type);
+        hash = hash_combine(hash, length);
+        hash = fnv1a(sources[i].source, length, hash);
+    }
+    return hash;
+}
+
+std::string ProgramBinaryCache::path_for(uint64_t key) const{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)key);
+    return directory_ + name;
+}
+
+GLuint ProgramBinaryCache::load(uint64_t key){
+    std::string path = path_for(key);
+
+    // Handle IO
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file){
+        stats_.misses++;
+        return 0;
+    }
+
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == PROGRAM_CACHE_VERSION &&
+        header.key == key &&
+        header.driver_hash == driver_hash_;
+    // The length comes from disk; a truncated or corrupt file must not
+    // size the buffer
+    struct stat info;
+    valid = valid &&
+        fstat(fileno(file), &info) == 0 &&
+        header.length > 0 &&
+        header.length <= (uint64_t)info.st_size - sizeof(header);
+    if(valid){
+        binary.resize(header.length);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    // The driver has the final say on whether the binary is still usable
+    GLuint program = 0;
+    if(valid){
+        program = glCreateProgram();
+        glProgramBinary(program, header.binary_format, binary.data(), (GLsizei)binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if(linked != GL_TRUE){
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if(!program){
+        GL_LOG_INFO(SHADER, "shader cache: rejected %s, recompiling\n", path.c_str());
+        remove(path.c_str());
+        stats_.rejected++;
+        return 0;
+    }
+    stats_.hits++;
+    return program;
+}
+
+bool ProgramBinaryCache::store(uint64_t key, GLuint program){
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0){
+        return false;
+    }
+
+    ProgramCacheHeader header;
+    memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+    header.version = PROGRAM_CACHE_VERSION;
+    header.key = key;
+    header.driver_hash = driver_hash_;
+
+    std::vector<char> binary(length);
+    GLenum binary_format = 0;
+    glGetProgramBinary(program, length, &length, &binary_format, binary.data());
+    header.binary_format = binary_format;
+    header.length = (uint32_t)length;
+
+    // Write to a temporary name and rename so readers never see a partial file
+    std::string path = path_for(key);
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if(!file){
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(binary.data(), 1, header.length, file) == header.length;
+    written = fclose(file) == 0 && written;
+    if(!written || rename(temporary.c_str(), path.c_str()) != 0){
+        remove(temporary.c_str());
+        return false;
+    }
+
+    stats_.stored++;
+    return true;
+}
@@ -0,0 +1,429 @@
+#include "shader_compiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <utility>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+#include "hash.h"
+#include "shader_cache.h"
+
+namespace {
+
+// Flat magenta, takes the position from attribute 0 like the lesson shaders
+const char* PLACEHOLDER_VERTEX =
+    "#version 330 core\n"
+    "layout(location = 0) in vec3 vertex_position;\n"
+    "void main(){\n"
+    "    gl_Position = vec4(vertex_position, 1.0);\n"
+    "}\n";
+
+const char* PLACEHOLDER_FRAGMENT =
+    "#version 330 core\n"
+    "out vec4 fragColour;\n"
+    "void main(){\n"
+    "    fragColour = vec4(1.0, 0.0, 1.0, 1.0);\n"
+    "}\n";
+
+}
+
+ShaderCompiler::ShaderCompiler(ProgramBinaryCache* cache) : cache_(cache){
+    // Let the driver use as many compiler threads as it likes
+    parallel_ = GLEW_ARB_parallel_shader_compile;
+    if(parallel_){
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+    }
+    GL_LOG_INFO(SHADER, "shader compiler: parallel compile %s\n", parallel_ ? "enabled" : "unavailable");
+
+    // The placeholder is built synchronously, it is needed on the first frame
+    ShaderSource sources[] = {
+        {GL_VERTEX_SHADER, PLACEHOLDER_VERTEX, -1},
+        {GL_FRAGMENT_SHADER, PLACEHOLDER_FRAGMENT, -1},
+    };
+    placeholder_ = build_program(sources, 2, nullptr);
+}
+
+ShaderCompiler::~ShaderCompiler(){
+    stop_worker();
+}
+
+bool ShaderCompiler::set_worker_context(const ContextSwitch& make_current){
+    if(parallel_ || worker_.joinable()){
+        return false;
+    }
+    make_current_ = make_current;
+    stopping_ = false;
+    worker_ = std::thread(&ShaderCompiler::work, this);
+    GL_LOG_INFO(SHADER, "shader compiler: reloads build on a worker context\n");
+    return true;
+}
+
+ProgramHandle ShaderCompiler::submit(const ShaderSource* sources, size_t count){
+    ProgramHandle handle = (ProgramHandle)programs_.size();
+    programs_.push_back(ProgramEntry());
+    stats_.submitted++;
+    start_build(programs_.back(), sources, count);
+    return handle;
+}
+
+void ShaderCompiler::reload(ProgramHandle handle, const ShaderSource* sources, size_t count){
+    ProgramEntry& entry = programs_[handle];
+    cancel_build(entry.build);
+    start_build(entry, sources, count);
+}
+
+void ShaderCompiler::start_build(ProgramEntry& entry, const ShaderSource* sources, size_t count){
+    Build& build = entry.build;
+    if(count > MAX_STAGES){
+        report_error(LogCategory::SHADER, "ERROR: program with %zu stages, at most %zu supported\n", count, MAX_STAGES);
+        if(!entry.program){
+            entry.status = ProgramStatus::FAILED;
+            stats_.failed++;
+        }
+        return;
+    }
+
+    // A cached binary skips compilation entirely
+    build.cache_key = 0;
+    if(cache_ && cache_->supported()){
+        build.cache_key = cache_->key(sources, count);
+        GLuint program = cache_->load(build.cache_key);
+        if(program){
+            stats_.cache_hits++;
+            install(entry, program);
+            return;
+        }
+    }
+
+    // A reload without parallel compile goes to the worker, the live
+    // program draws until it is done
+    if(entry.program && worker_.joinable()){
+        start_job(build, sources, count);
+        return;
+    }
+
+    // Issue compile and link back to back without querying any status
+    for(size_t i = 0; i < count; i++){
+        build.shaders[i] = shader_object(sources[i], build.shader_keys[i]);
+    }
+    build.shader_count = count;
+    build.program = link_program(build.shaders, count, build.cache_key != 0);
+    build.active = true;
+    pending_++;
+
+    // Retrying a program that never linked goes back to pending
+    if(!entry.program){
+        entry.status = ProgramStatus::PENDING;
+    }
+}
+
+void ShaderCompiler::start_job(Build& build, const ShaderSource* sources, size_t count){
+    std::unique_ptr<Job> job(new Job());
+    for(size_t i = 0; i < count; i++){
+        size_t length = sources[i].length < 0 ? strlen(sources[i].source) : (size_t)sources[i].length;
+        job->types[i] = sources[i].type;
+        job->sources[i].assign(sources[i].source, length);
+    }
+    job->count = count;
+    job->retrievable = build.cache_key != 0;
+    stats_.stages_requested += count;
+    stats_.stages_compiled += count;
+
+    build.shader_count = 0;
+    build.active = true;
+    pending_++;
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(job.get());
+    build.job = std::move(job);
+    wake_.notify_one();
+}
+
+// Moves a finished job's objects into the build
+void ShaderCompiler::take_job(Build& build){
+    Job& job = *build.job;
+    build.program = job.program;
+    std::copy(job.shaders, job.shaders + job.count, build.shaders);
+    build.shader_count = job.count;
+    build.job.reset();
+}
+
+void ShaderCompiler::work(){
+    make_current_(true);
+    for(;;){
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]{ return stopping_ || !queue_.empty(); });
+            if(queue_.empty()){
+                break;
+            }
+            job = queue_.front();
+            queue_.pop_front();
+            if(job->cancelled){
+                delete job;
+                continue;
+            }
+        }
+
+        // Asking for the link status waits for the driver here, and
+        // glFinish makes the objects complete for the render context
+        for(size_t i = 0; i < job->count; i++){
+            job->shaders[i] = compile_shader(job->types[i], job->sources[i].c_str(), (GLint)job->sources[i].size());
+        }
+        job->program = link_program(job->shaders, job->count, job->retrievable);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(job->program, GL_LINK_STATUS, &linked);
+        glFinish();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(job->cancelled){
+            glDeleteProgram(job->program);
+            for(size_t i = 0; i < job->count; i++){
+                glDeleteShader(job->shaders[i]);
+            }
+            delete job;
+            continue;
+        }
+        job->done = true;
+        finished_.notify_all();
+    }
+    make_current_(false);
+}
+
+void ShaderCompiler::stop_worker(){
+    if(!worker_.joinable()){
+        return;
+    }
+    {
+        // Jobs not started yet have no GL objects; cancelled ones are ours
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(Job* job : queue_){
+            if(job->cancelled){
+                delete job;
+            }
+        }
+        queue_.clear();
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+void ShaderCompiler::cancel_build(Build& build){
+    if(!build.active){
+        return;
+    }
+    if(build.job){
+        // A running job is handed to the worker, which deletes it when done
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(!build.job->done){
+            build.job->cancelled = true;
+            build.job.release();
+            build.active = false;
+            pending_--;
+            return;
+        }
+    }
+    if(build.job){
+        take_job(build);
+        for(size_t i = 0; i < build.shader_count; i++){
+            glDeleteShader(build.shaders[i]);
+        }
+        build.shader_count = 0;
+    }
+    glDeleteProgram(build.program);
+    release_shaders(build.shader_keys, build.shader_count);
+    build.program = 0;
+    build.shader_count = 0;
+    build.active = false;
+    pending_--;
+}
+
+GLuint ShaderCompiler::shader_object(const ShaderSource& source, uint64_t& key){
+    size_t length = source.length < 0 ? strlen(source.source) : (size_t)source.length;
+    key = hash_combine(fnv1a((const void*)source.source, length), source.type);
+    stats_.stages_requested++;
+
+    std::unordered_map<uint64_t, ShaderObject>::iterator found = shader_objects_.find(key);
+    if(found != shader_objects_.end()){
+        found->second.references++;
+        return found->second.shader;
+    }
+    GLuint shader = compile_shader(source.type, source.source, (GLint)length);
+    shader_objects_[key] = {shader, 1};
+    stats_.stages_compiled++;
+    return shader;
+}
+
+void ShaderCompiler::release_shaders(const uint64_t* keys, size_t count){
+    for(size_t i = 0; i < count; i++){
+        std::unordered_map<uint64_t, ShaderObject>::iterator found = shader_objects_.find(keys[i]);
+        if(found == shader_objects_.end() || --found->second.references > 0){
+            continue;
+        }
+        // Programs it is attached to keep it alive until they go
+        glDeleteShader(found->second.shader);
+        shader_objects_.erase(found);
+        stats_.stages_deleted++;
+    }
+}
+
+bool ShaderCompiler::complete(const Build& build) const{
+    if(build.job){
+        std::lock_guard<std::mutex> lock(mutex_);
+        return build.job->done;
+    }
+    if(!parallel_){
+        return true;
+    }
+    GLint done = GL_FALSE;
+    glGetProgramiv(build.program, GL_COMPLETION_STATUS_ARB, &done);
+    return done == GL_TRUE;
+}
+
+void ShaderCompiler::install(ProgramEntry& entry, GLuint program){
+    if(entry.program){
+        glDeleteProgram(entry.program);
+        stats_.reloads++;
+    }
+    release_shaders(entry.shader_keys, entry.shader_count);
+    entry.shader_count = 0;
+    entry.program = program;
+    entry.status = ProgramStatus::READY;
+    entry.generation++;
+    stats_.ready++;
+}
+
+void ShaderCompiler::finalize(ProgramEntry& entry){
+    Build& build = entry.build;
+    bool worker_built = build.job != nullptr;
+    if(worker_built){
+        take_job(build);
+    }
+
+    // Compile errors explain link errors, so report those first
+    GLint linked = GL_FALSE;
+    glGetProgramiv(build.program, GL_LINK_STATUS, &linked);
+    if(linked != GL_TRUE){
+        for(size_t i = 0; i < build.shader_count; i++){
+            check_shader_for_errors(build.shaders[i]);
+        }
+        check_program_for_errors(build.program);
+    }
+
+    // The worker's objects are not in the shared table; the program keeps
+    // what it needs
+    if(worker_built){
+        for(size_t i = 0; i < build.shader_count; i++){
+            glDeleteShader(build.shaders[i]);
+        }
+        build.shader_count = 0;
+    }
+
+    // Shader objects stay with the compiler for other programs to reuse
+    // while the live program holds them
+    size_t shader_count = build.shader_count;
+    build.shader_count = 0;
+    build.active = false;
+    pending_--;
+
+    // A failed reload keeps the previous program
+    if(linked != GL_TRUE){
+        release_shaders(build.shader_keys, shader_count);
+        glDeleteProgram(build.program);
+        build.program = 0;
+        if(!entry.program){
+            entry.status = ProgramStatus::FAILED;
+        }
+        stats_.failed++;
+        return;
+    }
+
+    if(build.cache_key){
+        cache_->store(build.cache_key, build.program);
+    }
+    install(entry, build.program);
+    std::copy(build.shader_keys, build.shader_keys + shader_count, entry.shader_keys);
+    entry.shader_count = shader_count;
+    build.program = 0;
+}
+
+void ShaderCompiler::poll(double budget_ms){
+    if(pending_ == 0){
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(ProgramEntry& entry : programs_){
+        if(!entry.build.active){
+            continue;
+        }
+
+        // Without parallel compile only reloads are finished here, first
+        // builds are finished lazily by program()
+        if(parallel_ || entry.build.job){
+            if(complete(entry.build)){
+                finalize(entry);
+            }
+            continue;
+        }
+        if(entry.program){
+            finalize(entry);
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(elapsed >= budget_ms){
+                return;
+            }
+        }
+    }
+}
+
+ProgramStatus ShaderCompiler::status(ProgramHandle handle){
+    ProgramEntry& entry = programs_[handle];
+    if(entry.status == ProgramStatus::PENDING && parallel_ && complete(entry.build)){
+        finalize(entry);
+    }
+    return entry.status;
+}
+
+GLuint ShaderCompiler::program(ProgramHandle handle){
+    ProgramEntry& entry = programs_[handle];
+    if(entry.status == ProgramStatus::PENDING && complete(entry.build)){
+        finalize(entry);
+    }
+    if(entry.status != ProgramStatus::READY){
+        stats_.placeholder_uses++;
+        return placeholder_;
+    }
+    return entry.program;
+}
+
+GLuint ShaderCompiler::wait(ProgramHandle handle){
+    ProgramEntry& entry = programs_[handle];
+    if(entry.build.job){
+        std::unique_lock<std::mutex> lock(mutex_);
+        Job* job = entry.build.job.get();
+        finished_.wait(lock, [job]{ return job->done; });
+    }
+    if(entry.build.active){
+        finalize(entry);
+    }
+    return entry.program;
+}
+
+void ShaderCompiler::destroy(){
+    for(ProgramEntry& entry : programs_){
+        cancel_build(entry.build);
+        glDeleteProgram(entry.program);
+    }
+    stop_worker();
+    for(const std::pair<const uint64_t, ShaderObject>& object : shader_objects_){
+        glDeleteShader(object.second.shader);
+    }
+    glDeleteProgram(placeholder_);
+    programs_.clear();
+    shader_objects_.clear();
+    placeholder_ = 0;
+    pending_ = 0;
+}
@@ -0,0 +1,266 @@
+#include "shader_preprocessor.h"
+
+#include <algorithm>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#include "asset_archive.h"
+#include "error_reporter.h"
+
+namespace {
+
+const int SHADER_INCLUDE_DEPTH = 32;
+
+// Process-wide source-string numbers for #line
+std::mutex g_paths_mutex;
+std::vector<std::string> g_paths;
+
+int register_path(const std::string& path){
+    std::lock_guard<std::mutex> lock(g_paths_mutex);
+    std::vector<std::string>::iterator found = std::find(g_paths.begin(), g_paths.end(), path);
+    if(found != g_paths.end()){
+        return (int)(found - g_paths.begin());
+    }
+    g_paths.push_back(path);
+    return (int)g_paths.size() - 1;
+}
+
+bool is_word_char(char c){
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '.';
+}
+
+bool file_exists(const std::string& path){
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file){
+        fclose(file);
+    }
+    return file != nullptr;
+}
+
+std::string directory_of(const std::string& path){
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+void append_line_directive(std::string& out, int line, int index){
+    char directive[48];
+    snprintf(directive, sizeof(directive), "#line %d %d\n", line, index);
+    out += directive;
+}
+
+// Matches "#<spaces>keyword" and returns the text after the keyword
+bool directive(const char* begin, const char* end, const char* keyword, const char*& rest){
+    const char* p = begin;
+    while(p < end && (*p == ' ' || *p == '\t')){
+        p++;
+    }
+    if(p == end || *p != '#'){
+        return false;
+    }
+    p++;
+    while(p < end && (*p == ' ' || *p == '\t')){
+        p++;
+    }
+    size_t length = strlen(keyword);
+    if((size_t)(end - p) < length || strncmp(p, keyword, length) != 0){
+        return false;
+    }
+    p += length;
+    if(p < end && *p != ' ' && *p != '\t' && *p != '\r'){
+        return false;
+    }
+    rest = p;
+    return true;
+}
+
+// The rest of a #pragma line is exactly "once", optionally followed by a
+// comment
+bool pragma_once(const char* rest, const char* end){
+    while(rest < end && (*rest == ' ' || *rest == '\t')){
+        rest++;
+    }
+    if(end - rest < 4 || strncmp(rest, "once", 4) != 0){
+        return false;
+    }
+    rest += 4;
+    while(rest < end && (*rest == ' ' || *rest == '\t' || *rest == '\r')){
+        rest++;
+    }
+    return rest == end || (end - rest >= 2 && rest[0] == '/' && (rest[1] == '/' || rest[1] == '*'));
+}
+
+}
+
+ShaderPreprocessor::ShaderPreprocessor(const char* include_root, const AssetArchive* archive) : include_root_(include_root), archive_(archive){
+}
+
+bool ShaderPreprocessor::preprocess(const char* path, const ShaderDefine* defines, size_t define_count, PreprocessedShader& out){
+    out.source.clear();
+    out.files.clear();
+    defines_ = defines;
+    define_count_ = define_count;
+    version_seen_ = false;
+    stack_.clear();
+    once_.clear();
+
+    return process_file(path, 0, out);
+}
+
+void ShaderPreprocessor::append_defines(std::string& out) const{
+    for(size_t i = 0; i < define_count_; i++){
+        out += "#define ";
+        out += defines_[i].name;
+        if(defines_[i].value){
+            out += " ";
+            out += defines_[i].value;
+        }
+        out += "\n";
+    }
+}
+
+std::string ShaderPreprocessor::resolve(const std::string& including_file, const std::string& name) const{
+    std::string relative = directory_of(including_file) + name;
+    if((archive_ && archive_->contains(relative.c_str())) || file_exists(relative)){
+        return relative;
+    }
+    return include_root_ + "/" + name;
+}
+
+bool ShaderPreprocessor::process_file(const std::string& path, int depth, PreprocessedShader& out){
+    AssetBlob file;
+    if(!read_asset(archive_, path.c_str(), file)){
+        return false;
+    }
+    if(std::find(out.files.begin(), out.files.end(), path) == out.files.end()){
+        out.files.push_back(path);
+    }
+    int index = register_path(path);
+    stack_.push_back(path);
+
+    // Files without #version get the defines up front
+    if(depth == 0 && !version_seen_ && define_count_ > 0){
+        bool has_version = false;
+        for(const char* p = file.data(); p < file.data() + file.size();){
+            const char* end = (const char*)memchr(p, '\n', file.data() + file.size() - p);
+            end = end ? end : file.data() + file.size();
+            const char* rest;
+            if(directive(p, end, "version", rest)){
+                has_version = true;
+                break;
+            }
+            p = end + 1;
+        }
+        if(!has_version){
+            append_defines(out.source);
+            append_line_directive(out.source, 1, index);
+        }
+    }
+
+    bool result = true;
+    int line = 0;
+    const char* data = file.data();
+    const char* data_end = data + file.size();
+    for(const char* p = data; p < data_end;){
+        const char* end = (const char*)memchr(p, '\n', data_end - p);
+        end = end ? end : data_end;
+        line++;
+        const char* rest = nullptr;
+
+        if(directive(p, end, "version", rest)){
+            // Only the top-level #version survives, defines go right after it
+            if(depth == 0 && !version_seen_){
+                out.source.append(p, end);
+                out.source += "\n";
+                append_defines(out.source);
+                append_line_directive(out.source, line + 1, index);
+            } else {
+                out.source += "\n";
+            }
+            version_seen_ = true;
+        } else if(directive(p, end, "pragma", rest) && pragma_once(rest, end)){
+            once_.push_back(path);
+            out.source += "\n";
+        } else if(directive(p, end, "include", rest)){
+            // Parse "name" or <name>
+            const char* open = rest;
+            while(open < end && *open != '"' && *open != '<'){
+                open++;
+            }
+            const char* close = open < end ? (const char*)memchr(open + 1, *open == '<' ? '>' : '"', end - open - 1) : nullptr;
+            if(!close){
+                report_error(LogCategory::SHADER, "ERROR: %s:%d: malformed #include\n", path.c_str(), line);
+                result = false;
+                out.source += "\n";
+            } else {
+                std::string child = resolve(path, std::string(open + 1, close));
+                bool skip = std::find(once_.begin(), once_.end(), child) != once_.end();
+                if(!skip && (depth >= SHADER_INCLUDE_DEPTH || std::find(stack_.begin(), stack_.end(), child) != stack_.end())){
+                    report_error(LogCategory::SHADER, "ERROR: %s:%d: recursive #include of %s\n", path.c_str(), line, child.c_str());
+                    result = false;
+                    skip = true;
+                }
+                if(skip){
+                    out.source += "\n";
+                } else {
+                    append_line_directive(out.source, 1, register_path(child));
+                    if(!process_file(child, depth + 1, out)){
+                        report_error(LogCategory::SHADER, "ERROR: %s:%d: could not include %s\n", path.c_str(), line, child.c_str());
+                        result = false;
+                    }
+                    append_line_directive(out.source, line + 1, index);
+                }
+            }
+        } else {
+            out.source.append(p, end);
+            out.source += "\n";
+        }
+        p = end + 1;
+    }
+
+    stack_.pop_back();
+    return result;
+}
+
+const char* shader_source_path(int index){
+    std::lock_guard<std::mutex> lock(g_paths_mutex);
+    if(index < 0 || (size_t)index >= g_paths.size()){
+        return nullptr;
+    }
+    return g_paths[index].c_str();
+}
+
+std::string annotate_shader_log(const char* log){
+    std::string out;
+    const char* p = log;
+    while(*p){
+        // Look for <digits>[:(]<digit> and swap the first number for a path
+        if(*p >= '0' && *p <= '9' && (p == log || !is_word_char(p[-1]))){
+            const char* q = p;
+            int index = 0;
+            while(*q >= '0' && *q <= '9'){
+                index = index * 10 + (*q - '0');
+                q++;
+            }
+            const char* path = (*q == ':' || *q == '(') && q[1] >= '0' && q[1] <= '9' ? shader_source_path(index) : nullptr;
+            if(path){
+                out += path;
+                out += ':';
+                q++;
+                while(*q >= '0' && *q <= '9'){
+                    out += *q++;
+                }
+                if(*q == ')'){
+                    q++;
+                }
+                p = q;
+                continue;
+            }
+            out.append(p, q);
+            p = q;
+            continue;
+        }
+        out += *p++;
+    }
+    return out;
+}
@@ -0,0 +1,313 @@
+#include "shader_reflection.h"
+
+#include <string.h>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+
+namespace {
+
+const size_t REFLECTION_NAME_SIZE = 256;
+const unsigned REFLECTION_SEED_TRIES = 64;
+
+uint64_t variable_key(uint64_t name, ShaderVariableKind kind){
+    uint64_t key = hash_combine(name, (uint64_t)kind);
+    return key ? key : 1;
+}
+
+// Array uniforms are reported as "name[0]", look them up by "name"
+uint64_t name_hash(char* name){
+    size_t length = strlen(name);
+    if(length > 3 && strcmp(name + length - 3, "[0]") == 0){
+        name[length - 3] = '\0';
+    }
+    return fnv1a(name);
+}
+
+// Bytes of shadow storage for one value of type, 0 if no setter handles it
+size_t value_size(GLenum type){
+    switch(type){
+        case GL_FLOAT: return 4;
+        case GL_FLOAT_VEC2: return 8;
+        case GL_FLOAT_VEC3: return 12;
+        case GL_FLOAT_VEC4: return 16;
+        case GL_FLOAT_MAT3: return 36;
+        case GL_FLOAT_MAT4: return 64;
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_BUFFER:
+            return 4;
+        default: return 0;
+    }
+}
+
+// set_int also drives bools and sampler units
+bool type_matches(GLenum actual, GLenum wanted){
+    if(actual == wanted){
+        return true;
+    }
+    return wanted == GL_INT && value_size(actual) == 4 && actual != GL_FLOAT;
+}
+
+}
+
+bool ProgramReflection::reflect(GLuint program){
+    program_ = program;
+    variables_.clear();
+    shadow_.clear();
+    char name[REFLECTION_NAME_SIZE];
+
+    // Uniforms in the default block; block members have no location
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    for(GLint i = 0; i < count; i++){
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetUniformLocation(program, name);
+        if(location >= 0){
+            add(name_hash(name), ShaderVariableKind::UNIFORM, location, type, size);
+        }
+    }
+
+    // Attributes
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    for(GLint i = 0; i < count; i++){
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, (GLuint)i, sizeof(name), NULL, &size, &type, name);
+        GLint location = glGetAttribLocation(program, name);
+        if(location >= 0){
+            add(name_hash(name), ShaderVariableKind::ATTRIBUTE, location, type, size);
+        }
+    }
+
+    // Uniform blocks
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    for(GLint i = 0; i < count; i++){
+        GLint size = 0;
+        glGetActiveUniformBlockName(program, (GLuint)i, sizeof(name), NULL, name);
+        glGetActiveUniformBlockiv(program, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        add(fnv1a(name), ShaderVariableKind::BLOCK, i, 0, size);
+    }
+
+    // build_table() releases the list once the table is built
+    size_t variable_count = variables_.size();
+    if(!build_table()){
+        report_error(LogCategory::SHADER, "ERROR: could not build reflection table for program %u\n", program);
+        return false;
+    }
+    GL_LOG_DEBUG(
+        SHADER,
+        "reflected program %u: %zu variables in %zu slots\n",
+        program,
+        variable_count,
+        table_.size()
+    );
+    return true;
+}
+
+void ProgramReflection::add(uint64_t name, ShaderVariableKind kind, GLint location, GLenum type, GLint count){
+    ShaderVariable variable;
+    variable.key = variable_key(name, kind);
+    variable.kind = kind;
+    variable.location = location;
+    variable.type = type;
+    variable.count = count;
+    if(kind == ShaderVariableKind::UNIFORM){
+        variable.shadow = (uint32_t)shadow_.size();
+        shadow_.resize(shadow_.size() + value_size(type));
+    }
+    variables_.push_back(variable);
+}
+
+size_t ProgramReflection::slot(uint64_t key) const{
+    return (size_t)(((key ^ seed_) * 0x9e3779b97f4a7c15ull) >> shift_);
+}
+
+bool ProgramReflection::build_table(){
+    // Search for a seed that maps every key to its own slot, growing the
+    // table when a size has no such seed. Programs have a handful of
+    // variables, so this is cheap and happens once per link.
+    unsigned bits = 3;
+    while(((size_t)1 << bits) < variables_.size() * 2){
+        bits++;
+    }
+    for(; bits < 20; bits++){
+        shift_ = 64 - bits;
+        for(unsigned attempt = 0; attempt < REFLECTION_SEED_TRIES; attempt++){
+            seed_ = fnv1a(&attempt, sizeof(attempt));
+            table_.assign((size_t)1 << bits, ShaderVariable());
+
+            bool collided = false;
+            for(const ShaderVariable& variable : variables_){
+                ShaderVariable& entry = table_[slot(variable.key)];
+                if(entry.key != 0){
+                    collided = true;
+                    break;
+                }
+                entry = variable;
+            }
+            if(!collided){
+                variables_.clear();
+                return true;
+            }
+        }
+    }
+    table_.clear();
+    return false;
+}
+
+const ShaderVariable* ProgramReflection::find(uint64_t name, ShaderVariableKind kind) const{
+    if(table_.empty()){
+        return nullptr;
+    }
+    uint64_t key = variable_key(name, kind);
+    const ShaderVariable& entry = table_[slot(key)];
+    return entry.key == key ? &entry : nullptr;
+}
+
+GLint ProgramReflection::uniform_location(uint64_t name) const{
+    const ShaderVariable* variable = find(name, ShaderVariableKind::UNIFORM);
+    return variable ? variable->location : -1;
+}
+
+GLint ProgramReflection::attribute_location(uint64_t name) const{
+    const ShaderVariable* variable = find(name, ShaderVariableKind::ATTRIBUTE);
+    return variable ? variable->location : -1;
+}
+
+GLuint ProgramReflection::block_index(uint64_t name) const{
+    const ShaderVariable* variable = find(name, ShaderVariableKind::BLOCK);
+    return variable ? (GLuint)variable->location : GL_INVALID_INDEX;
+}
+
+bool ProgramReflection::bind_block(uint64_t name, GLuint binding){
+    GLuint index = block_index(name);
+    if(index == GL_INVALID_INDEX){
+        return false;
+    }
+    glUniformBlockBinding(program_, index, binding);
+    return true;
+}
+
+bool ProgramReflection::update(uint64_t name, GLenum type, const void* value, size_t size, GLint& location){
+    stats_.sets++;
+    location = -1;
+    uint64_t key = variable_key(name, ShaderVariableKind::UNIFORM);
+    ShaderVariable* variable = table_.empty() ? nullptr : &table_[slot(key)];
+    if(!variable || variable->key != key){
+        stats_.missing++;
+        return false;
+    }
+    if(!type_matches(variable->type, type)){
+        report_error_detail(
+            LogCategory::SHADER,
+            name,
+            "ERROR: uniform type mismatch in program %u (have 0x%x, set as 0x%x)\n",
+            program_,
+            variable->type,
+            type
+        );
+        return false;
+    }
+
+    // Unchanged values never reach the driver
+    unsigned char* shadow = shadow_.data() + variable->shadow;
+    if(variable->known && memcmp(shadow, value, size) == 0){
+        stats_.skipped++;
+        return true;
+    }
+    memcpy(shadow, value, size);
+    variable->known = true;
+    location = variable->location;
+    return true;
+}
+
+bool ProgramReflection::set_int(uint64_t name, GLint value){
+    GLint location;
+    if(!update(name, GL_INT, &value, sizeof(value), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniform1i(program_, location, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_float(uint64_t name, float value){
+    GLint location;
+    if(!update(name, GL_FLOAT, &value, sizeof(value), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniform1f(program_, location, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_vec2(uint64_t name, const float* value){
+    GLint location;
+    if(!update(name, GL_FLOAT_VEC2, value, 2 * sizeof(float), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniform2fv(program_, location, 1, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_vec3(uint64_t name, const float* value){
+    GLint location;
+    if(!update(name, GL_FLOAT_VEC3, value, 3 * sizeof(float), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniform3fv(program_, location, 1, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_vec4(uint64_t name, const float* value){
+    GLint location;
+    if(!update(name, GL_FLOAT_VEC4, value, 4 * sizeof(float), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniform4fv(program_, location, 1, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_vec4(uint64_t name, float x, float y, float z, float w){
+    float value[] = {x, y, z, w};
+    return set_vec4(name, value);
+}
+
+bool ProgramReflection::set_mat3(uint64_t name, const float* value){
+    GLint location;
+    if(!update(name, GL_FLOAT_MAT3, value, 9 * sizeof(float), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniformMatrix3fv(program_, location, 1, GL_FALSE, value);
+    }
+    return true;
+}
+
+bool ProgramReflection::set_mat4(uint64_t name, const float* value){
+    GLint location;
+    if(!update(name, GL_FLOAT_MAT4, value, 16 * sizeof(float), location)){
+        return false;
+    }
+    if(location >= 0){
+        glProgramUniformMatrix4fv(program_, location, 1, GL_FALSE, value);
+    }
+    return true;
+}
@@ -0,0 +1,111 @@
+#include "shader_reloader.h"
+
+#include <algorithm>
+
+#include "gl_log_filter.h"
+
+ShaderReloader::ShaderReloader(ShaderCompiler& compiler, ShaderPreprocessor& preprocessor)
+    : compiler_(compiler), preprocessor_(preprocessor){
+}
+
+ProgramHandle ShaderReloader::load(const ShaderFile* files, size_t count, const ShaderDefine* defines, size_t define_count){
+    TrackedProgram tracked;
+    for(size_t i = 0; i < count; i++){
+        tracked.types.push_back(files[i].type);
+        tracked.paths.push_back(files[i].path);
+    }
+    for(size_t i = 0; i < define_count; i++){
+        tracked.define_names.push_back(defines[i].name);
+        tracked.define_values.push_back(defines[i].value ? defines[i].value : "");
+    }
+
+    // Load Shaders and submit the program; a missing file shows up as a
+    // compile error and can be fixed on disk
+    std::vector<PreprocessedShader> shaders;
+    std::vector<ShaderSource> sources;
+    preprocess_sources(tracked, shaders, sources);
+    tracked.handle = compiler_.submit(sources.data(), sources.size());
+
+    size_t index = programs_.size();
+    programs_.push_back(tracked);
+    watch_files(index, shaders);
+    return tracked.handle;
+}
+
+bool ShaderReloader::preprocess_sources(const TrackedProgram& tracked, std::vector<PreprocessedShader>& shaders, std::vector<ShaderSource>& sources){
+    std::vector<ShaderDefine> defines(tracked.define_names.size());
+    for(size_t i = 0; i < defines.size(); i++){
+        defines[i].name = tracked.define_names[i].c_str();
+        defines[i].value = tracked.define_values[i].c_str();
+    }
+
+    // glShaderSource copies the text, so the expanded sources only live for the submit
+    bool read = true;
+    shaders.resize(tracked.paths.size());
+    sources.resize(tracked.paths.size());
+    for(size_t i = 0; i < shaders.size(); i++){
+        read = preprocessor_.preprocess(tracked.paths[i].c_str(), defines.data(), defines.size(), shaders[i]) && read;
+        sources[i].type = tracked.types[i];
+        sources[i].source = shaders[i].source.c_str();
+        sources[i].length = (GLint)shaders[i].source.size();
+    }
+    return read;
+}
+
+void ShaderReloader::watch_files(size_t index, const std::vector<PreprocessedShader>& shaders){
+    // The stage files are watched even if they could not be read yet
+    for(const std::string& path : programs_[index].paths){
+        watch_file(index, path);
+    }
+    for(const PreprocessedShader& shader : shaders){
+        for(const std::string& path : shader.files){
+            watch_file(index, path);
+        }
+    }
+}
+
+void ShaderReloader::watch_file(size_t index, const std::string& path){
+    // FileWatcher hands out the same id for a path it already watches
+    int id = watcher_.watch(path.c_str());
+    if(id < 0){
+        return;
+    }
+    if((size_t)id >= watchers_.size()){
+        watchers_.resize(id + 1);
+    }
+    if(std::find(watchers_[id].begin(), watchers_[id].end(), index) == watchers_[id].end()){
+        watchers_[id].push_back(index);
+    }
+}
+
+void ShaderReloader::poll(){
+    changed_.clear();
+    watcher_.poll(changed_);
+    if(changed_.empty()){
+        return;
+    }
+
+    // Rebuild each affected program once, however many of its files changed
+    std::vector<size_t> affected;
+    for(int id : changed_){
+        for(size_t index : watchers_[id]){
+            if(std::find(affected.begin(), affected.end(), index) == affected.end()){
+                affected.push_back(index);
+            }
+        }
+    }
+    for(size_t index : affected){
+        const TrackedProgram& tracked = programs_[index];
+        GL_LOG_INFO(SHADER, "Reloading shader program %u (%s)\n", tracked.handle, tracked.paths[0].c_str());
+
+        // A file missing mid-save keeps the current program; an edit may
+        // have added includes, so those get watched too
+        std::vector<PreprocessedShader> shaders;
+        std::vector<ShaderSource> sources;
+        bool read = preprocess_sources(tracked, shaders, sources);
+        watch_files(index, shaders);
+        if(read){
+            compiler_.reload(tracked.handle, sources.data(), sources.size());
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#include "shader_variants.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+
+namespace {
+
+const size_t VARIANT_TABLE_INITIAL = 16;
+
+// Masks are mostly low bits, so mix before taking the slot index
+uint64_t mix_mask(FeatureMask mask){
+    mask ^= mask >> 33;
+    mask *= 0xff51afd7ed558ccdull;
+    mask ^= mask >> 33;
+    return mask;
+}
+
+}
+
+ShaderVariants::ShaderVariants(
+    ShaderReloader& reloader,
+    ShaderCompiler& compiler,
+    const ShaderFile* files,
+    size_t count,
+    const char* const* features,
+    size_t feature_count
+) : reloader_(reloader), compiler_(compiler), slots_(VARIANT_TABLE_INITIAL){
+    // Keep our own copy of the paths, the caller's array may be temporary
+    for(size_t i = 0; i < count; i++){
+        paths_.push_back(files[i].path);
+    }
+    for(size_t i = 0; i < count; i++){
+        files_.push_back({files[i].type, paths_[i].c_str()});
+    }
+
+    if(feature_count > MAX_FEATURES){
+        report_error(LogCategory::SHADER, "ERROR: %zu shader features, at most %zu supported\n", feature_count, MAX_FEATURES);
+        feature_count = MAX_FEATURES;
+    }
+    for(size_t i = 0; i < feature_count; i++){
+        features_.push_back(features[i]);
+    }
+}
+
+ShaderVariants::Slot& ShaderVariants::find_slot(FeatureMask mask){
+    size_t bits = slots_.size() - 1;
+    for(size_t i = mix_mask(mask) & bits;; i = (i + 1) & bits){
+        Slot& slot = slots_[i];
+        if(slot.uses == 0 || slot.mask == mask){
+            return slot;
+        }
+    }
+}
+
+void ShaderVariants::grow(){
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    for(const Slot& slot : old){
+        if(slot.uses != 0){
+            find_slot(slot.mask) = slot;
+        }
+    }
+}
+
+ProgramHandle ShaderVariants::submit(FeatureMask mask){
+    std::vector<ShaderDefine> defines;
+    for(size_t i = 0; i < features_.size(); i++){
+        if(mask & ((FeatureMask)1 << i)){
+            defines.push_back({features_[i].c_str(), "1"});
+        }
+    }
+
+    // The compiler's cache counter tells whether the variant was compiled
+    uint64_t cache_hits = compiler_.stats().cache_hits;
+    ProgramHandle handle = reloader_.load(files_.data(), files_.size(), defines.data(), defines.size());
+    if(compiler_.stats().cache_hits != cache_hits){
+        stats_.cached++;
+    } else {
+        stats_.compiled++;
+    }
+    stats_.requested++;
+    GL_LOG_DEBUG(SHADER, "shader variant %s#%llx submitted\n", paths_[0].c_str(), (unsigned long long)mask);
+    return handle;
+}
+
+ProgramHandle ShaderVariants::handle(FeatureMask mask){
+    stats_.lookups++;
+    Slot* slot = &find_slot(mask);
+    if(slot->uses == 0){
+        // Keep the table at most half full so probes stay short
+        if((used_ + 1) * 2 > slots_.size()){
+            grow();
+            slot = &find_slot(mask);
+        }
+        slot->mask = mask;
+        slot->handle = submit(mask);
+        used_++;
+    }
+    if(slot->uses != UINT32_MAX){
+        slot->uses++;
+    }
+    return slot->handle;
+}
+
+void ShaderVariants::prewarm(const FeatureMask* masks, size_t count){
+    for(size_t i = 0; i < count; i++){
+        uint64_t requested = stats_.requested;
+        handle(masks[i]);
+        stats_.lookups--;
+        stats_.prewarmed += stats_.requested - requested;
+    }
+}
+
+size_t ShaderVariants::hottest(FeatureMask* masks, size_t max) const{
+    std::vector<const Slot*> used;
+    for(const Slot& slot : slots_){
+        if(slot.uses != 0){
+            used.push_back(&slot);
+        }
+    }
+    size_t count = std::min(max, used.size());
+    std::partial_sort(used.begin(), used.begin() + count, used.end(), [](const Slot* a, const Slot* b){
+        return a->uses > b->uses;
+    });
+    for(size_t i = 0; i < count; i++){
+        masks[i] = used[i]->mask;
+    }
+    return count;
+}
+
+FeatureMask ShaderVariants::feature(const char* name) const{
+    for(size_t i = 0; i < features_.size(); i++){
+        if(strcmp(features_[i].c_str(), name) == 0){
+            return (FeatureMask)1 << i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "static_batch.h"
+
+#include <string.h>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+#include "gl_state.h"
+#include "stream_buffer.h"
+
+void StaticBatch::destroy(){
+    if(vao_){
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    if(vbo_ || ibo_){
+        GLuint buffers[] = {vbo_, ibo_};
+        glDeleteBuffers(2, buffers);
+        vbo_ = 0;
+        ibo_ = 0;
+    }
+}
+
+BatchMesh StaticBatch::add_mesh(const void* vertices, size_t vertex_count, const uint32_t* indices, size_t index_count){
+    MeshRange range;
+    range.first_index = (GLuint)indices_.size();
+    range.index_count = (GLuint)index_count;
+    range.base_vertex = (GLint)(vertices_.size() / format_.stride);
+
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    vertices_.insert(vertices_.end(), bytes, bytes + vertex_count * format_.stride);
+    indices_.insert(indices_.end(), indices, indices + index_count);
+    meshes_.push_back(range);
+    return (BatchMesh)(meshes_.size() - 1);
+}
+
+bool StaticBatch::upload(GlState& gl_state){
+    if(vertices_.empty() || indices_.empty()){
+        report_error(LogCategory::GL, "ERROR: static batch uploaded without meshes\n");
+        return false;
+    }
+    multi_draw_ = GLEW_ARB_multi_draw_indirect;
+
+    // One VAO over the shared buffers; the element binding is VAO state
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ibo_);
+    gl_state.bind_vertex_array(vao_);
+    gl_state.bind_buffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, vertices_.size(), vertices_.data(), GL_STATIC_DRAW);
+    apply_vertex_format(format_);
+    gl_state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(uint32_t), indices_.data(), GL_STATIC_DRAW);
+
+    GL_LOG_INFO(
+        GL,
+        "static batch: %zu meshes, %zu vertices, %zu indices, %s\n",
+        meshes_.size(),
+        vertices_.size() / format_.stride,
+        indices_.size(),
+        multi_draw_ ? "multi-draw indirect" : "per-draw fallback"
+    );
+
+    // The GPU copy is all that is needed from here on
+    std::vector<unsigned char>().swap(vertices_);
+    std::vector<uint32_t>().swap(indices_);
+    return true;
+}
+
+void StaticBatch::draw(BatchMesh mesh, GLuint instance_count, GLuint base_instance){
+    const MeshRange& range = meshes_[mesh];
+    commands_.push_back({range.index_count, instance_count, range.first_index, range.base_vertex, base_instance});
+}
+
+void StaticBatch::submit(GlState& gl_state, GLuint program){
+    stats_.commands = commands_.size();
+    stats_.driver_draws = 0;
+    if(commands_.empty()){
+        return;
+    }
+    gl_state.use_program(program);
+    gl_state.bind_vertex_array(vao_);
+
+    if(multi_draw_){
+        // The command list is streamed like any other per-frame data
+        size_t size = commands_.size() * sizeof(DrawElementsIndirectCommand);
+        StreamAllocation allocation = stream_.allocate(size, sizeof(GLuint));
+        if(!allocation.data){
+            commands_.clear();
+            return;
+        }
+        memcpy(allocation.data, commands_.data(), size);
+        stream_.commit(allocation);
+        gl_state.bind_buffer(GL_DRAW_INDIRECT_BUFFER, stream_.buffer());
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES,
+            GL_UNSIGNED_INT,
+            (const void*)allocation.offset,
+            (GLsizei)commands_.size(),
+            0
+        );
+        stats_.driver_draws = 1;
+    } else {
+        for(const DrawElementsIndirectCommand& command : commands_){
+            const void* offset = (const void*)((size_t)command.first_index * sizeof(uint32_t));
+            if(command.instance_count == 1){
+                glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, offset, command.base_vertex);
+            } else {
+                glDrawElementsInstancedBaseVertex(
+                    GL_TRIANGLES,
+                    command.count,
+                    GL_UNSIGNED_INT,
+                    offset,
+                    command.instance_count,
+                    command.base_vertex
+                );
+            }
+        }
+        stats_.driver_draws = commands_.size();
+    }
+    commands_.clear();
+}
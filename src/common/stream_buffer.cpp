@@ -0,0 +1,127 @@
+#include "stream_buffer.h"
+
+#include <string.h>
+
+#include "error_reporter.h"
+#include "gl_log_filter.h"
+
+bool StreamBuffer::create(size_t region_size, unsigned frames){
+    destroy();
+    region_size_ = (region_size + 255) & ~(size_t)255;
+    frames_ = frames < 1 ? 1 : (frames > MAX_FRAMES ? MAX_FRAMES : frames);
+    frame_ = frames_ - 1;
+    cursor_ = 0;
+
+    size_t total = region_size_ * frames_;
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    if(GLEW_ARB_buffer_storage){
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, total, NULL, flags);
+        mapped_ = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+        if(!mapped_){
+            report_error(LogCategory::GL, "ERROR: could not map %zu byte stream buffer\n", total);
+            destroy();
+            return false;
+        }
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, NULL, GL_STREAM_DRAW);
+        staging_.resize(total);
+    }
+
+    GL_LOG_INFO(
+        GL,
+        "stream buffer %u: %u x %zu bytes, %s\n",
+        buffer_,
+        frames_,
+        region_size_,
+        mapped_ ? "persistently mapped" : "staged"
+    );
+    return true;
+}
+
+void StreamBuffer::destroy(){
+    for(GLsync& fence : fences_){
+        if(fence){
+            glDeleteSync(fence);
+            fence = 0;
+        }
+    }
+    if(buffer_){
+        if(mapped_){
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer_);
+    }
+    buffer_ = 0;
+    mapped_ = nullptr;
+    std::vector<unsigned char>().swap(staging_);
+}
+
+void StreamBuffer::begin_frame(){
+    frame_ = (frame_ + 1) % frames_;
+    cursor_ = 0;
+
+    // Normally signalled long ago; blocking here means the GPU is frames behind
+    GLsync& fence = fences_[frame_];
+    if(fence){
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if(result == GL_TIMEOUT_EXPIRED){
+            stats_.waits++;
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        }
+        if(result == GL_WAIT_FAILED){
+            report_error(LogCategory::GL, "ERROR: stream buffer fence wait failed\n");
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+}
+
+void StreamBuffer::end_frame(){
+    if(cursor_ > 0){
+        fences_[frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    if(cursor_ > stats_.peak){
+        stats_.peak = cursor_;
+    }
+}
+
+StreamAllocation StreamBuffer::allocate(size_t size, size_t alignment){
+    size_t start = (cursor_ + alignment - 1) & ~(alignment - 1);
+    if(!buffer_ || start + size > region_size_){
+        stats_.overflows++;
+        report_error(LogCategory::GL, "ERROR: stream buffer region of %zu bytes is full\n", region_size_);
+        return {nullptr, 0, 0};
+    }
+
+    size_t offset = region_size_ * frame_ + start;
+    stats_.allocations++;
+    stats_.bytes += start + size - cursor_;
+    cursor_ = start + size;
+    unsigned char* base = mapped_ ? mapped_ : staging_.data();
+    return {base + offset, offset, size};
+}
+
+void StreamBuffer::commit(const StreamAllocation& allocation){
+    if(mapped_ || !allocation.data || allocation.size == 0){
+        return;
+    }
+
+    // The region's fence has been waited on, so the GPU is done with this
+    // range; mapping it unsynchronized skips the driver's own wait
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* target = glMapBufferRange(GL_COPY_WRITE_BUFFER, allocation.offset, allocation.size, flags);
+    if(target){
+        memcpy(target, allocation.data, allocation.size);
+        if(glUnmapBuffer(GL_COPY_WRITE_BUFFER)){
+            return;
+        }
+    }
+
+    // Mapping failed or the contents were lost on unmap
+    stats_.fallbacks++;
+    glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, allocation.size, allocation.data);
+}
@@ -0,0 +1,306 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+
+namespace {
+
+unsigned highest_bit(uint64_t value){
+    return 63 - __builtin_clzll(value);
+}
+
+unsigned lowest_bit(uint64_t value){
+    return __builtin_ctzll(value);
+}
+
+size_t gcd(size_t a, size_t b){
+    while(b){
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+size_t round_up(size_t value, size_t multiple){
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+}
+
+TlsfAllocator::TlsfAllocator(size_t capacity){
+    reset(capacity);
+}
+
+void TlsfAllocator::reset(size_t capacity){
+    blocks_.clear();
+    spare_.clear();
+    for(unsigned fl = 0; fl < FL_COUNT; fl++){
+        for(unsigned sl = 0; sl < SL_COUNT; sl++){
+            heads_[fl][sl] = TLSF_NONE;
+        }
+        sl_bitmap_[fl] = 0;
+    }
+    fl_bitmap_ = 0;
+    capacity_ = capacity / GRANULE * GRANULE;
+    used_ = 0;
+    allocations_ = 0;
+
+    if(capacity_ > 0){
+        uint32_t block = new_block();
+        blocks_[block].offset = 0;
+        blocks_[block].size = capacity_;
+        insert_free(block);
+    }
+}
+
+// Size class of a block of units granules: first level is the power of
+// two, second level splits it into SL_COUNT linear steps
+void TlsfAllocator::mapping(size_t units, unsigned& fl, unsigned& sl){
+    if(units < SL_COUNT){
+        fl = 0;
+        sl = (unsigned)units;
+        return;
+    }
+    unsigned high = highest_bit(units);
+    fl = high - SL_BITS + 1;
+    sl = (unsigned)(units >> (high - SL_BITS)) & (SL_COUNT - 1);
+    if(fl >= FL_COUNT){
+        fl = FL_COUNT - 1;
+        sl = SL_COUNT - 1;
+    }
+}
+
+uint32_t TlsfAllocator::new_block(){
+    uint32_t block;
+    if(!spare_.empty()){
+        block = spare_.back();
+        spare_.pop_back();
+        blocks_[block] = Block();
+    } else {
+        block = (uint32_t)blocks_.size();
+        blocks_.push_back(Block());
+    }
+    blocks_[block].in_use = true;
+    return block;
+}
+
+void TlsfAllocator::release_block(uint32_t block){
+    blocks_[block].in_use = false;
+    spare_.push_back(block);
+}
+
+void TlsfAllocator::insert_free(uint32_t block){
+    Block& b = blocks_[block];
+    unsigned fl, sl;
+    mapping(b.size / GRANULE, fl, sl);
+    b.free = true;
+    b.prev_free = TLSF_NONE;
+    b.next_free = heads_[fl][sl];
+    if(b.next_free != TLSF_NONE){
+        blocks_[b.next_free].prev_free = block;
+    }
+    heads_[fl][sl] = block;
+    fl_bitmap_ |= 1ull << fl;
+    sl_bitmap_[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::remove_free(uint32_t block){
+    Block& b = blocks_[block];
+    unsigned fl, sl;
+    mapping(b.size / GRANULE, fl, sl);
+    if(b.prev_free != TLSF_NONE){
+        blocks_[b.prev_free].next_free = b.next_free;
+    } else {
+        heads_[fl][sl] = b.next_free;
+    }
+    if(b.next_free != TLSF_NONE){
+        blocks_[b.next_free].prev_free = b.prev_free;
+    }
+    if(heads_[fl][sl] == TLSF_NONE){
+        sl_bitmap_[fl] &= ~(1u << sl);
+        if(sl_bitmap_[fl] == 0){
+            fl_bitmap_ &= ~(1ull << fl);
+        }
+    }
+    b.free = false;
+    b.prev_free = b.next_free = TLSF_NONE;
+}
+
+size_t TlsfAllocator::search_units(size_t size){
+    // Round up to the next class boundary so any block in the class fits
+    size_t units = size / GRANULE;
+    if(units >= SL_COUNT){
+        units += ((size_t)1 << (highest_bit(units) - SL_BITS)) - 1;
+    }
+    return units;
+}
+
+uint32_t TlsfAllocator::find_free(size_t size){
+    size_t units = search_units(size);
+    unsigned fl, sl;
+    mapping(units, fl, sl);
+
+    uint32_t sl_map = sl < 32 ? sl_bitmap_[fl] & (~0u << sl) : 0;
+    if(!sl_map){
+        uint64_t fl_map = fl + 1 < 64 ? fl_bitmap_ & (~0ull << (fl + 1)) : 0;
+        if(!fl_map){
+            return TLSF_NONE;
+        }
+        fl = lowest_bit(fl_map);
+        sl_map = sl_bitmap_[fl];
+    }
+    uint32_t block = heads_[fl][lowest_bit(sl_map)];
+
+    // The last class is open-ended, so check the size there
+    return blocks_[block].size >= size ? block : TLSF_NONE;
+}
+
+// Cuts block down to size and frees the tail; returns block
+uint32_t TlsfAllocator::split(uint32_t block, size_t size){
+    if(blocks_[block].size - size < GRANULE){
+        return block;
+    }
+    uint32_t tail = new_block();
+    Block& b = blocks_[block];
+    Block& t = blocks_[tail];
+    t.offset = b.offset + size;
+    t.size = b.size - size;
+    t.prev_physical = block;
+    t.next_physical = b.next_physical;
+    if(t.next_physical != TLSF_NONE){
+        blocks_[t.next_physical].prev_physical = tail;
+    }
+    b.size = size;
+    b.next_physical = tail;
+    insert_free(tail);
+    return block;
+}
+
+size_t TlsfAllocator::alignment(size_t alignment){
+    alignment = alignment > 0 ? alignment : GRANULE;
+    return alignment / gcd(alignment, GRANULE) * GRANULE;
+}
+
+// Bytes a free block needs to fit size wherever it starts; alignment is
+// already a granule multiple
+size_t TlsfAllocator::search_size(size_t size, size_t alignment){
+    return round_up(size > 0 ? size : 1, GRANULE) + (alignment > GRANULE ? alignment - GRANULE : 0);
+}
+
+size_t TlsfAllocator::capacity_for(size_t size, size_t alignment){
+    // The lower bound of the class find_free starts at
+    size_t units = search_units(search_size(size, TlsfAllocator::alignment(alignment)));
+    if(units >= SL_COUNT){
+        units &= ~(((size_t)1 << (highest_bit(units) - SL_BITS)) - 1);
+    }
+    return units * GRANULE;
+}
+
+TlsfBlock TlsfAllocator::allocate(size_t size, size_t alignment){
+    // Offsets are granule multiples, so align to a common multiple
+    alignment = TlsfAllocator::alignment(alignment);
+    size_t search = search_size(size, alignment);
+    size = round_up(size > 0 ? size : 1, GRANULE);
+
+    uint32_t block = find_free(search);
+    if(block == TLSF_NONE){
+        return TLSF_NONE;
+    }
+    remove_free(block);
+
+    // Give the gap in front of the aligned start back as its own free block
+    size_t padding = round_up(blocks_[block].offset, alignment) - blocks_[block].offset;
+    if(padding > 0){
+        split(block, padding);
+        uint32_t aligned = blocks_[block].next_physical;
+        remove_free(aligned);
+        insert_free(block);
+        block = aligned;
+    }
+
+    split(block, size);
+    used_ += blocks_[block].size;
+    allocations_++;
+    return block;
+}
+
+TlsfBlock TlsfAllocator::allocate_at(size_t offset, size_t size){
+    size = round_up(size > 0 ? size : 1, GRANULE);
+    if(offset % GRANULE != 0){
+        return TLSF_NONE;
+    }
+    for(uint32_t block = 0; block < blocks_.size(); block++){
+        const Block& b = blocks_[block];
+        if(!b.in_use || !b.free || offset < b.offset || offset + size > b.offset + b.size){
+            continue;
+        }
+        remove_free(block);
+        if(offset > b.offset){
+            split(block, offset - blocks_[block].offset);
+            uint32_t front = block;
+            block = blocks_[front].next_physical;
+            remove_free(block);
+            insert_free(front);
+        }
+        split(block, size);
+        used_ += blocks_[block].size;
+        allocations_++;
+        return block;
+    }
+    return TLSF_NONE;
+}
+
+void TlsfAllocator::free(TlsfBlock block){
+    if(block >= blocks_.size() || !blocks_[block].in_use || blocks_[block].free){
+        return;
+    }
+    used_ -= blocks_[block].size;
+    allocations_--;
+
+    // Merge with free physical neighbours
+    uint32_t prev = blocks_[block].prev_physical;
+    if(prev != TLSF_NONE && blocks_[prev].free){
+        remove_free(prev);
+        blocks_[prev].size += blocks_[block].size;
+        blocks_[prev].next_physical = blocks_[block].next_physical;
+        if(blocks_[prev].next_physical != TLSF_NONE){
+            blocks_[blocks_[prev].next_physical].prev_physical = prev;
+        }
+        release_block(block);
+        block = prev;
+    }
+    uint32_t next = blocks_[block].next_physical;
+    if(next != TLSF_NONE && blocks_[next].free){
+        remove_free(next);
+        blocks_[block].size += blocks_[next].size;
+        blocks_[block].next_physical = blocks_[next].next_physical;
+        if(blocks_[block].next_physical != TLSF_NONE){
+            blocks_[blocks_[block].next_physical].prev_physical = block;
+        }
+        release_block(next);
+    }
+    insert_free(block);
+}
+
+void TlsfAllocator::live_blocks(std::vector<TlsfBlock>& out) const{
+    out.clear();
+    for(uint32_t i = 0; i < blocks_.size(); i++){
+        if(blocks_[i].in_use && !blocks_[i].free){
+            out.push_back(i);
+        }
+    }
+    std::sort(out.begin(), out.end(), [this](TlsfBlock a, TlsfBlock b){
+        return blocks_[a].offset < blocks_[b].offset;
+    });
+}
+
+TlsfStats TlsfAllocator::stats() const{
+    TlsfStats stats = {capacity_, used_, capacity_ - used_, 0, allocations_, 0};
+    for(const Block& block : blocks_){
+        if(block.in_use && block.free){
+            stats.largest_free = std::max(stats.largest_free, block.size);
+            stats.free_blocks++;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,50 @@
+#include "uniform_ring.h"
+
+#include <string.h>
+
+bool UniformRing::create(size_t region_size, unsigned frames){
+    // Every bound range has to start on the driver's offset alignment
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment_ = alignment > 0 ? (size_t)alignment : 256;
+    return stream_.create(region_size, frames);
+}
+
+void UniformRing::destroy(){
+    stream_.destroy();
+}
+
+size_t UniformRing::push(const void* data, size_t size){
+    StreamAllocation allocation = stream_.allocate(size, alignment_);
+    if(!allocation.data){
+        return SIZE_MAX;
+    }
+    memcpy(allocation.data, data, size);
+    stream_.commit(allocation);
+    return allocation.offset;
+}
+
+void UniformRing::bind(GLuint binding, size_t offset, size_t size){
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, stream_.buffer(), offset, size);
+    binds_++;
+}
+
+bool UniformRing::push_and_bind(GLuint binding, const void* data, size_t size){
+    size_t offset = push(data, size);
+    if(offset == SIZE_MAX){
+        return false;
+    }
+    bind(binding, offset, size);
+    return true;
+}
+
+UniformRingStats UniformRing::stats() const{
+    StreamBufferStats stream = stream_.stats();
+    UniformRingStats stats;
+    stats.pushes = stream.allocations;
+    stats.bytes = stream.bytes;
+    stats.binds = binds_;
+    stats.waits = stream.waits;
+    stats.overflows = stream.overflows;
+    return stats;
+}
@@ -0,0 +1,313 @@
+#include "vertex_compression.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+const float* element(const float* stream, size_t stride, size_t components, size_t index){
+    if(stride){
+        return (const float*)((const unsigned char*)stream + index * stride);
+    }
+    return stream + index * components;
+}
+
+float sign_not_zero(float value){
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+int16_t to_snorm16(float value){
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return (int16_t)lrintf(value * 32767.0f);
+}
+
+float from_snorm16(int16_t value){
+    return std::max(-1.0f, value / 32767.0f);
+}
+
+void octahedral_decode(float ex, float ey, float* normal){
+    float x = ex;
+    float y = ey;
+    float z = 1.0f - fabsf(ex) - fabsf(ey);
+    if(z < 0.0f){
+        x = (1.0f - fabsf(ey)) * sign_not_zero(ex);
+        y = (1.0f - fabsf(ex)) * sign_not_zero(ey);
+    }
+    float length = sqrtf(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
+
+// Projects onto the octahedron and unfolds the lower half, then picks the
+// rounding of the two snorm values that decodes closest to the input
+void octahedral_encode(const float* normal, int16_t* encoded){
+    float l1 = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    float x = l1 > 0.0f ? normal[0] / l1 : 0.0f;
+    float y = l1 > 0.0f ? normal[1] / l1 : 0.0f;
+    if(normal[2] < 0.0f){
+        float folded_x = (1.0f - fabsf(y)) * sign_not_zero(x);
+        float folded_y = (1.0f - fabsf(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    float best = -2.0f;
+    for(int i = 0; i < 4; i++){
+        float qx = (i & 1) ? ceilf(x * 32767.0f) : floorf(x * 32767.0f);
+        float qy = (i & 2) ? ceilf(y * 32767.0f) : floorf(y * 32767.0f);
+        int16_t candidate[2] = {to_snorm16(qx / 32767.0f), to_snorm16(qy / 32767.0f)};
+        float decoded[3];
+        octahedral_decode(from_snorm16(candidate[0]), from_snorm16(candidate[1]), decoded);
+        float similarity = decoded[0] * normal[0] + decoded[1] * normal[1] + decoded[2] * normal[2];
+        if(similarity > best){
+            best = similarity;
+            encoded[0] = candidate[0];
+            encoded[1] = candidate[1];
+        }
+    }
+}
+
+}
+
+uint16_t float_to_half(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    // NaN stays NaN, anything from 65520 up rounds to infinity
+    if(magnitude > 0x7f800000){
+        return (uint16_t)(sign | 0x7e00);
+    }
+    if(magnitude >= 0x477ff000){
+        return (uint16_t)(sign | 0x7c00);
+    }
+
+    // Below 2^-14 the half is subnormal
+    if(magnitude < 0x38800000){
+        if(magnitude < 0x33000000){
+            return (uint16_t)sign;
+        }
+        uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        uint32_t shift = 126 - (magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 1))){
+            half++;
+        }
+        return (uint16_t)(sign | half);
+    }
+
+    // Rebias the exponent and round the mantissa to nearest even
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    uint32_t remainder = magnitude & 0x1fff;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1))){
+        half++;
+    }
+    return (uint16_t)(sign | half);
+}
+
+float half_to_float(uint16_t half){
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+
+    float value;
+    if(exponent == 0){
+        value = ldexpf((float)mantissa, -24);
+        return sign ? -value : value;
+    }
+    uint32_t bits = exponent == 31
+        ? sign | 0x7f800000 | (mantissa << 13)
+        : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool compress_vertices(const VertexStreams& streams, const VertexCompression& options, CompressedVertices& out){
+    if(!streams.positions || streams.count == 0){
+        return false;
+    }
+
+    // Layout: every attribute starts on 4 bytes, 3 x 16-bit positions are
+    // padded to 8
+    size_t stride = 0;
+    out.format = VertexFormat();
+    out.position_offset = stride;
+    if(options.positions){
+        out.format.add(VERTEX_POSITION_LOCATION, 3, GL_UNSIGNED_SHORT, GL_TRUE, (GLuint)stride);
+        stride += 4 * sizeof(uint16_t);
+    } else {
+        out.format.add(VERTEX_POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, (GLuint)stride);
+        stride += 3 * sizeof(float);
+    }
+    out.normal_offset = SIZE_MAX;
+    if(streams.normals){
+        out.normal_offset = stride;
+        if(options.normals){
+            out.format.add(VERTEX_NORMAL_LOCATION, 2, GL_SHORT, GL_TRUE, (GLuint)stride);
+            stride += 2 * sizeof(int16_t);
+        } else {
+            out.format.add(VERTEX_NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, (GLuint)stride);
+            stride += 3 * sizeof(float);
+        }
+    }
+    out.uv_offset = SIZE_MAX;
+    if(streams.uvs){
+        out.uv_offset = stride;
+        if(options.uvs){
+            out.format.add(VERTEX_UV_LOCATION, 2, GL_HALF_FLOAT, GL_FALSE, (GLuint)stride);
+            stride += 2 * sizeof(uint16_t);
+        } else {
+            out.format.add(VERTEX_UV_LOCATION, 2, GL_FLOAT, GL_FALSE, (GLuint)stride);
+            stride += 2 * sizeof(float);
+        }
+    }
+    out.format.stride = (GLsizei)stride;
+    out.vertex_count = streams.count;
+    out.data.assign(stride * streams.count, 0);
+
+    // Per-mesh bounds, one scale for all axes
+    float minimum[3] = {INFINITY, INFINITY, INFINITY};
+    float extent = 0.0f;
+    for(size_t i = 0; i < streams.count; i++){
+        const float* position = element(streams.positions, streams.stride, 3, i);
+        for(int axis = 0; axis < 3; axis++){
+            minimum[axis] = std::min(minimum[axis], position[axis]);
+        }
+    }
+    for(size_t i = 0; i < streams.count; i++){
+        const float* position = element(streams.positions, streams.stride, 3, i);
+        for(int axis = 0; axis < 3; axis++){
+            extent = std::max(extent, position[axis] - minimum[axis]);
+        }
+    }
+    extent = extent > 0.0f ? extent : 1.0f;
+    if(options.positions){
+        memcpy(out.position_decode, minimum, sizeof(minimum));
+        out.position_decode[3] = extent;
+    } else {
+        float identity[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        memcpy(out.position_decode, identity, sizeof(identity));
+    }
+
+    for(size_t i = 0; i < streams.count; i++){
+        unsigned char* vertex = out.data.data() + i * stride;
+
+        const float* position = element(streams.positions, streams.stride, 3, i);
+        if(options.positions){
+            uint16_t quantized[4] = {0, 0, 0, 0};
+            for(int axis = 0; axis < 3; axis++){
+                float unit = (position[axis] - minimum[axis]) / extent;
+                quantized[axis] = (uint16_t)lrintf(std::max(0.0f, std::min(1.0f, unit)) * 65535.0f);
+            }
+            memcpy(vertex + out.position_offset, quantized, sizeof(quantized));
+        } else {
+            memcpy(vertex + out.position_offset, position, 3 * sizeof(float));
+        }
+
+        if(streams.normals){
+            const float* normal = element(streams.normals, streams.stride, 3, i);
+            if(options.normals){
+                int16_t encoded[2];
+                octahedral_encode(normal, encoded);
+                memcpy(vertex + out.normal_offset, encoded, sizeof(encoded));
+            } else {
+                memcpy(vertex + out.normal_offset, normal, 3 * sizeof(float));
+            }
+        }
+
+        if(streams.uvs){
+            const float* uv = element(streams.uvs, streams.stride, 2, i);
+            if(options.uvs){
+                uint16_t halves[2] = {float_to_half(uv[0]), float_to_half(uv[1])};
+                memcpy(vertex + out.uv_offset, halves, sizeof(halves));
+            } else {
+                memcpy(vertex + out.uv_offset, uv, 2 * sizeof(float));
+            }
+        }
+    }
+    return true;
+}
+
+void decompress_vertex(const CompressedVertices& vertices, size_t index, float* position, float* normal, float* uv){
+    const unsigned char* vertex = vertices.data.data() + index * vertices.format.stride;
+
+    // Attribute types tell how each one was stored
+    for(size_t i = 0; i < vertices.format.attribute_count; i++){
+        const VertexAttribute& attribute = vertices.format.attributes[i];
+        const unsigned char* source = vertex + attribute.offset;
+        if(attribute.location == VERTEX_POSITION_LOCATION && position){
+            if(attribute.type == GL_UNSIGNED_SHORT){
+                uint16_t quantized[3];
+                memcpy(quantized, source, sizeof(quantized));
+                for(int axis = 0; axis < 3; axis++){
+                    position[axis] = quantized[axis] / 65535.0f * vertices.position_decode[3] + vertices.position_decode[axis];
+                }
+            } else {
+                memcpy(position, source, 3 * sizeof(float));
+            }
+        } else if(attribute.location == VERTEX_NORMAL_LOCATION && normal){
+            if(attribute.type == GL_SHORT){
+                int16_t encoded[2];
+                memcpy(encoded, source, sizeof(encoded));
+                octahedral_decode(from_snorm16(encoded[0]), from_snorm16(encoded[1]), normal);
+            } else {
+                memcpy(normal, source, 3 * sizeof(float));
+            }
+        } else if(attribute.location == VERTEX_UV_LOCATION && uv){
+            if(attribute.type == GL_HALF_FLOAT){
+                uint16_t halves[2];
+                memcpy(halves, source, sizeof(halves));
+                uv[0] = half_to_float(halves[0]);
+                uv[1] = half_to_float(halves[1]);
+            } else {
+                memcpy(uv, source, 2 * sizeof(float));
+            }
+        }
+    }
+}
+
+VertexCompressionError measure_compression_error(const VertexStreams& streams, const CompressedVertices& vertices){
+    VertexCompressionError error = {0.0, 0.0, 0.0, 0.0};
+    double squared_sum = 0.0;
+    size_t count = std::min(streams.count, vertices.vertex_count);
+
+    for(size_t i = 0; i < count; i++){
+        float position[3], normal[3], uv[2];
+        decompress_vertex(vertices, i, position, normal, uv);
+
+        const float* original = element(streams.positions, streams.stride, 3, i);
+        double squared = 0.0;
+        for(int axis = 0; axis < 3; axis++){
+            double delta = (double)position[axis] - original[axis];
+            squared += delta * delta;
+        }
+        error.max_position = std::max(error.max_position, sqrt(squared));
+        squared_sum += squared;
+
+        if(streams.normals){
+            original = element(streams.normals, streams.stride, 3, i);
+            double dot = 0.0, original_length = 0.0, decoded_length = 0.0;
+            for(int axis = 0; axis < 3; axis++){
+                dot += (double)normal[axis] * original[axis];
+                original_length += (double)original[axis] * original[axis];
+                decoded_length += (double)normal[axis] * normal[axis];
+            }
+            double cosine = dot / sqrt(original_length * decoded_length);
+            double degrees = acos(std::max(-1.0, std::min(1.0, cosine))) * 180.0 / M_PI;
+            error.max_normal_degrees = std::max(error.max_normal_degrees, degrees);
+        }
+
+        if(streams.uvs){
+            original = element(streams.uvs, streams.stride, 2, i);
+            error.max_uv = std::max(error.max_uv, (double)fabsf(uv[0] - original[0]));
+            error.max_uv = std::max(error.max_uv, (double)fabsf(uv[1] - original[1]));
+        }
+    }
+    error.rms_position = count > 0 ? sqrt(squared_sum / count) : 0.0;
+    return error;
+}
@@ -6,6 +6,8 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "gl_state.h"
+
 
 // Set Triangle coordinates
 GLfloat points[] = {
@@ -94,20 +96,24 @@ int main(){
     glAttachShader(shader_program, fs);
     glLinkProgram(shader_program);
 
+    // Redundant state changes in the loop are filtered from here on
+    GlState gl_state;
+
     // Draw loop
     while(!glfwWindowShouldClose(window)){
         // Clear draw surface
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         // Set background color to grey
-        glClearColor(0.5, 0.5, 0.5, 1.0);
+        gl_state.clear_colour(0.5, 0.5, 0.5, 1.0);
 
         // Fillament of the triangle area bound by vertex array
-        glUseProgram(shader_program);
+        gl_state.use_program(shader_program);
 
         // Specify the bounds and draw
-        glBindVertexArray(vao);
+        gl_state.bind_vertex_array(vao);
         glDrawArrays(GL_TRIANGLES, 0, sizeof(points)/3);
+        gl_state.end_frame();
 
         // Fetch input events
         glfwPollEvents();
@@ -1,14 +1,32 @@
-#include <assert.h>
-#include <fstream>
-#include <stdarg.h>
+#include <algorithm>
 #include <stdio.h>
-#include <string>
-#include <time.h>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#define GL_LOG_FILE "gl.log"
+#include "asset_archive.h"
+#include "asset_pipeline.h"
+#include "error_reporter.h"
+#include "gl_log.h"
+#include "gl_log_filter.h"
+#include "gl_state.h"
+#include "indexed_mesh.h"
+#include "instancing.h"
+#include "mesh_optimizer.h"
+#include "render_queue.h"
+#include "shader.h"
+#include "shader_cache.h"
+#include "shader_compiler.h"
+#include "shader_preprocessor.h"
+#include "shader_reflection.h"
+#include "shader_reloader.h"
+#include "shader_variants.h"
+#include "static_batch.h"
+#include "std140.h"
+#include "stream_buffer.h"
+#include "uniform_ring.h"
+#include "vertex_compression.h"
 
 // ######## global vars ###########
 int g_gl_width = 640;
@@ -27,107 +45,8 @@ GLfloat points[] = {
 
 };
 
-// Util tool for reading shader programs
-std::string* read_shader_program(std::string filepath){
-    std::ifstream file_stream(filepath);
-    return new std::string(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
-}
-
-bool restart_gl_log(){
-    // Handle IO 
-    FILE* log_file = fopen(GL_LOG_FILE, "w");
-    if(!log_file){
-        fprintf(
-            stderr,
-            "ERROR: could not open GL_LOG_FILE log file %s for writing\n",
-            GL_LOG_FILE
-        );
-        return false;
-    }
-
-    // Obtain current time
-    time_t now = time(NULL);
-    char* date = ctime(&now);
-
-    // Initialise logfile with date
-    fprintf(
-        log_file,
-        "[GL_LOG_FILE log. local time %s\n]",
-        date
-    );
-
-    // IO cleanup
-    fclose(log_file);
-    return true;
-}
-
-bool gl_log(std::string message, ...){
-    // Initialise the variable arguments
-    va_list arguments;
-
-    // Handle IO
-    FILE* file = fopen(GL_LOG_FILE, "a");
-    if(!file){
-        fprintf(
-            stderr,
-            "ERROR: could not open GL_LOG_FILE %s file for appending\n",
-            GL_LOG_FILE
-        );
-        return false;
-    }
-    
-    // Handle variable arguments
-    va_start(arguments, message);
-    vfprintf(
-        file,
-        message.c_str(),
-        arguments
-    );
-    va_end(arguments);
-    
-    // Cleanup IO
-    fclose(file);
-    return true;
-}
-
-bool gl_log_error(const char* message, ...){
-    // Initialise variable arguments
-    va_list arguments;
-
-    // Handle IO
-    FILE* file = fopen(GL_LOG_FILE, "a");
-    if(!file){
-        fprintf(
-            stderr,
-            "ERROR: could not open GL_LOG_FILE %s file for appending\n",
-            GL_LOG_FILE
-        );
-        return false;
-    }
-
-    // Write to logfile
-    va_start(arguments, message);
-    vfprintf(
-        file,
-        message,
-        arguments
-    ); 
-
-    // Write to stderr
-    vfprintf(
-        stderr,
-        message,
-        arguments
-    );
-
-    // IO cleanup
-    va_end(arguments);
-    fclose(file);
-    return true;
-}
-
 void glfw_error_callback(int error, const char* description){
-    gl_log_error("GLFW Error: code %i msg: %s\n", error, description);
+    report_error_detail(LogCategory::GLFW, error, "GLFW Error: code %i msg: %s\n", error, description);
 }
 
 void glfw_window_size_callback(GLFWwindow* window, int width, int height){
@@ -170,26 +89,31 @@ void log_gl_params(){
         "GL_MAX_VIEWPORT_DIMS",
         "GL_STEREO",
     };
+
+    // Skip the glGet* queries entirely when nobody will see them
+    if(!log_compiled_in(LogLevel::INFO, LogCategory::GL) || !log_enabled(LogLevel::INFO, LogCategory::GL)){
+        return;
+    }
         
-    gl_log("GL Context Params:\n");
+    GL_LOG_INFO(GL, "GL Context Params:\n");
     for(int i = 0; i < 10; i++){
         int v = 0;
         glGetIntegerv(params[i], &v);
-        gl_log("%s %i\n", names[i], v);
+        GL_LOG_INFO(GL, "%s %i\n", names[i], v);
     }
 
     int v[2];
     v[0] = v[1] = 0;
     glGetIntegerv(params[10], v);
-    gl_log("%s %i %i\n", names[10], v[0], v[1]);
+    GL_LOG_INFO(GL, "%s %i %i\n", names[10], v[0], v[1]);
 
     unsigned char s = 0;
     glGetBooleanv(params[11], &s);
-    gl_log ("%s %u\n", names[11], (unsigned int)s);
-    gl_log ("-----------------------------\n");
+    GL_LOG_INFO(GL, "%s %u\n", names[11], (unsigned int)s);
+    GL_LOG_INFO(GL, "-----------------------------\n");
 }
 
-void _update_fps_counter(GLFWwindow* window){
+void _update_fps_counter(GLFWwindow* window, const GlState& gl_state){
     static double previous_seconds = glfwGetTime();
     static int frame_count;
     double current_seconds = glfwGetTime();
@@ -202,43 +126,27 @@ void _update_fps_counter(GLFWwindow* window){
         char tmp[128];
         sprintf(tmp, "OpenGL @ fps: %.2f", fps);
         glfwSetWindowTitle(window, tmp);
+        GlStateCounters calls = gl_state.frame();
+        GL_LOG_DEBUG(
+            FRAME,
+            "frame %.3f s fps %.2f, state calls %llu issued %llu filtered\n",
+            current_seconds,
+            fps,
+            (unsigned long long)calls.issued,
+            (unsigned long long)calls.filtered
+        );
         frame_count = 0;
     }
 
     frame_count++;
 }
 
-void _print_shader_info_log(GLuint shader){
-    int max_length = 2048;
-    int actual_length = 0;
-    char log[2048];
-
-    glGetShaderInfoLog(shader, max_length, &actual_length, log);
-    gl_log_error("Shader info log GL index %u:\n%s\n", &shader, &log);
-}
-
-bool check_shader_for_errors(GLuint shader){
-    int params = -1;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &params);
-
-    if(GL_TRUE != params){
-        fprintf(
-            stderr,
-            "ERROR: Gl shader index %i did not compile\n",
-            shader
-        );
-
-        _print_shader_info_log(shader);
-        return false;
-    }
-
-    return true;
-}
-
 int main(){
-    // Assert logging works and initialise log file
-    assert(restart_gl_log());
-    gl_log("Starting GLFW\n%s\n", glfwGetVersionString());
+    // Initialise log file and start the background log writer
+    if(!restart_gl_log()){
+        return 1;
+    }
+    GL_LOG_INFO(GLFW, "Starting GLFW\n%s\n", glfwGetVersionString());
 
     // Setup GLFW
     glfwSetErrorCallback(glfw_error_callback);
@@ -293,65 +201,324 @@ int main(){
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
 
-    // Setup buffer
-    GLuint vbo = 0;
-    glGenBuffers (1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(points), points, GL_STATIC_DRAW);
-
-    // Setup Vertex Attribute Object
-    GLuint vao = 0;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, NULL);
-
-    // Load Shaders
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    const char* vertex_shader = read_shader_program("shaders/test.vert")->c_str();
-    glShaderSource(vs, 1, &vertex_shader, NULL);
-    glCompileShader(vs);
-    check_shader_for_errors(vs);
-
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fragment_shader = read_shader_program("shaders/test.frag")->c_str();
-    glShaderSource(fs, 1, &fragment_shader, NULL);
-    glCompileShader(fs);
-    check_shader_for_errors(fs);
-
-    // Combine Shaders into Shader Program
-    GLuint shader_program = glCreateProgram();
-    glAttachShader(shader_program, vs);
-    glAttachShader(shader_program, fs);
-    glLinkProgram(shader_program);
-    glUseProgram(shader_program);
-
-    // Obtain the inputColor var from the test.frag
-    GLint colour_loc = glGetUniformLocation(shader_program, "inputColour" );
-
-    // Specify the colour of our fragments
-    glUniform4f(colour_loc, 1.0f, 0.0f, 0.0f, 1.0f);
+    // Redundant state changes are filtered from here on
+    GlState gl_state;
+
+    // Per-frame and per-object constants are streamed into one uniform
+    // buffer. Created before anything else that owns GL objects, so a
+    // failure here has only these to release.
+    UniformRing uniform_ring;
+    if(!uniform_ring.create(4096)){
+        glfwTerminate();
+        return 1;
+    }
+
+    // Instance data and indirect commands are streamed the same way
+    StreamBuffer stream_buffer;
+    if(!stream_buffer.create(64 * 1024)){
+        uniform_ring.destroy();
+        glfwTerminate();
+        return 1;
+    }
+
+    // Setup buffers: the quad's duplicated corners are merged and it is
+    // drawn indexed
+    std::vector<unsigned char> quad_vertices;
+    std::vector<uint32_t> quad_indices;
+    MeshOptimizeReport quad_report = optimize_mesh(points, 6, 3 * sizeof(GLfloat), quad_vertices, quad_indices);
+    GL_LOG_INFO(
+        GL,
+        "quad: %zu -> %zu vertices, ACMR %.2f -> %.2f\n",
+        quad_report.vertices_before,
+        quad_report.vertices_after,
+        quad_report.acmr_before,
+        quad_report.acmr_after
+    );
+
+    // Positions are stored as 16-bit values within the quad's bounds,
+    // decoded with quad_decode in the shaders
+    VertexStreams quad_streams;
+    quad_streams.positions = (const float*)quad_vertices.data();
+    quad_streams.count = quad_report.vertices_after;
+    CompressedVertices quad_compressed;
+    compress_vertices(quad_streams, VertexCompression(), quad_compressed);
+    const float* quad_decode = quad_compressed.position_decode;
+
+    // Static meshes share a few large buffers instead of one each
+    BufferArena mesh_arena(256 * 1024);
+    IndexedMesh quad;
+    upload_indexed_mesh(
+        gl_state,
+        mesh_arena,
+        quad_compressed.format,
+        quad_compressed.data.data(),
+        quad_compressed.vertex_count,
+        quad_indices.data(),
+        quad_indices.size(),
+        quad
+    );
+
+    // A second VAO over the same quad for the instanced copies; the
+    // instance attributes are added to it when it is first drawn
+    GLuint instanced_vao = create_mesh_vao(gl_state, quad);
+
+    // Load Shaders and submit the Shader Program; it compiles in the
+    // background and the draw loop uses a placeholder until it is ready.
+    // Edits to the files are picked up while running. G toggles the
+    // GRADIENT variant, which is only compiled when first used. When
+    // assets.pack is present (tools/asset_pack.o assets.pack shaders) the
+    // shaders come from it with no per-file opens, and loose edits are
+    // ignored for the files it holds.
+    ShaderFile shader_files[] = {
+        {GL_VERTEX_SHADER, "shaders/test.vert"},
+        {GL_FRAGMENT_SHADER, "shaders/test.frag"},
+    };
+    ProgramBinaryCache shader_cache;
+    ShaderCompiler shader_compiler(&shader_cache);
+
+    // Without parallel compile, reloads are built on a hidden window's
+    // context that shares objects with this one
+    GLFWwindow* shader_context = nullptr;
+    if(!shader_compiler.parallel()){
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        shader_context = glfwCreateWindow(1, 1, "shader compiler", NULL, window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    }
+    if(shader_context){
+        shader_compiler.set_worker_context([shader_context](bool current){
+            glfwMakeContextCurrent(current ? shader_context : NULL);
+        });
+    }
+    AssetArchive asset_archive;
+    if(asset_exists(nullptr, "assets" ASSET_ARCHIVE_EXTENSION) && asset_archive.open("assets" ASSET_ARCHIVE_EXTENSION)){
+        GL_LOG_INFO(ASSET, "Loading %zu assets from assets%s\n", asset_archive.entries().size(), ASSET_ARCHIVE_EXTENSION);
+    }
+    ShaderPreprocessor shader_preprocessor("shaders", &asset_archive);
+    ShaderReloader shader_reloader(shader_compiler, shader_preprocessor);
+    const char* shader_features[] = {"GRADIENT"};
+    ShaderVariants test_variants(shader_reloader, shader_compiler, shader_files, 2, shader_features, 1);
+    FeatureMask test_features = 0;
+    bool gradient_key_down = false;
+    double shader_start = glfwGetTime();
+    test_variants.prewarm(&test_features, 1);
+    ProgramHandle test_program = test_variants.handle(test_features);
+    ShaderFile instanced_files[] = {
+        {GL_VERTEX_SHADER, "shaders/instanced.vert"},
+        {GL_FRAGMENT_SHADER, "shaders/instanced.frag"},
+    };
+    ProgramHandle instanced_program = shader_reloader.load(instanced_files, 2);
+    GL_LOG_INFO(SHADER, "Shader submit %.3f ms\n", (glfwGetTime() - shader_start) * 1000.0);
+    GLuint shader_program = 0;
+    uint32_t shader_generation = 0;
+    ProgramReflection shader_reflection;
+    bool shader_reported = false;
+
+    // Draws are collected per frame and sorted by state before submission
+    RenderQueue render_queue;
+
+    // Meshes are read and decoded on worker threads and uploaded a little
+    // each frame, so the window is up before they arrive. The model is
+    // optional: tools/mesh_convert.o model.obj meshes/model.mesh
+    AssetPipeline asset_pipeline(gl_state, mesh_arena, &asset_archive);
+    const char* model_path = "meshes/model" MESH_FILE_EXTENSION;
+    bool model_requested = asset_exists(&asset_archive, model_path);
+    AssetHandle model = model_requested ? asset_pipeline.load_mesh(model_path) : 0;
+    bool assets_reported = !model_requested;
+
+    // A strip of static quads along the bottom, packed into one batch and
+    // drawn with a single multi-draw call
+    StaticBatch static_batch(VertexFormat(3 * sizeof(float)).add(0, 3, GL_FLOAT, GL_FALSE, 0), stream_buffer);
+    const int strip_quads = 16;
+    std::vector<BatchMesh> strip;
+    for(int i = 0; i < strip_quads; i++){
+        float left = -0.95f + i * 0.12f;
+        float quad[] = {
+            left, -0.95f, 0.0f,
+            left + 0.1f, -0.95f, 0.0f,
+            left + 0.1f, -0.85f, 0.0f,
+            left, -0.85f, 0.0f,
+        };
+        uint32_t quad_indices[] = {0, 1, 2, 0, 2, 3};
+        strip.push_back(static_batch.add_mesh(quad, 4, quad_indices, 6));
+    }
+    static_batch.upload(gl_state);
+
+    // A grid of small copies of the quad, one instanced draw
+    InstanceRenderer instance_renderer(stream_buffer);
+    InstancedMesh instanced_quad;
+    instanced_quad.vao = instanced_vao;
+    instanced_quad.count = quad.index_count;
+    instanced_quad.index_type = quad.index_type;
+    instanced_quad.first = quad.first_index;
+    instanced_quad.base_vertex = quad.base_vertex;
 
     // Draw loop
     while(!glfwWindowShouldClose(window)){
         // Write FPS in window's title bar
-        _update_fps_counter(window);
+        _update_fps_counter(window, gl_state);
+        uniform_ring.begin_frame();
+        stream_buffer.begin_frame();
+
+        // Summarise any error storm from the last window
+        error_reporter_tick();
 
         // Clear draw surface
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glViewport(0, 0, g_gl_width, g_gl_width);
+        gl_state.viewport(0, 0, g_gl_width, g_gl_width);
 
         // Set background color to grey
-        glClearColor(0.5, 0.5, 0.5, 1.0);
+        gl_state.clear_colour(0.5, 0.5, 0.5, 1.0);
+
+        // Pick up the Shader Program once it finishes (re)compiling
+        shader_reloader.poll();
+        shader_compiler.poll();
+        test_program = test_variants.handle(test_features);
+        GLuint current_program = shader_compiler.program(test_program);
+        // A relinked program may reuse the old name, so compare generations too
+        uint32_t current_generation = shader_compiler.generation(test_program);
+        if(current_program != shader_program || current_generation != shader_generation){
+            shader_program = current_program;
+            shader_generation = current_generation;
+
+            // The shadow may already hold a reused name, so force the bind
+            gl_state.invalidate();
+            shader_reflection.reflect(shader_program);
+            shader_reflection.bind_block(SHADER_NAME("FrameConstants"), FRAME_BLOCK_BINDING);
+            shader_reflection.bind_block(SHADER_NAME("ObjectConstants"), OBJECT_BLOCK_BINDING);
+        }
 
-        // Specify the bounds and draw
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, sizeof(points)/3);
+        // Write the frame's constants and the colour of our fragments as
+        // std140 blocks, matching shaders/constants.glsl
+        unsigned char constants[64];
+        Std140Writer frame_constants(constants, sizeof(constants));
+        frame_constants.write_vec4(0.0f, 0.0f, (float)g_gl_width, (float)g_gl_height);
+        frame_constants.write_float((float)glfwGetTime());
+        uniform_ring.push_and_bind(FRAME_BLOCK_BINDING, constants, frame_constants.size());
+
+        // Queue the quad with its own constants, bound when it is drawn
+        Std140Writer object_constants(constants, sizeof(constants));
+        object_constants.write_vec4(1.0f, 0.0f, 0.0f, 1.0f);
+        object_constants.write_vec4(quad_decode[0], quad_decode[1], quad_decode[2], quad_decode[3]);
+        DrawItem quad_item;
+        quad_item.key = draw_sort_key(0, shader_program, 0, quad.vao, 0.0f);
+        quad_item.program = shader_program;
+        quad_item.vao = quad.vao;
+        quad_item.index_type = quad.index_type;
+        quad_item.count = quad.index_count;
+        quad_item.first = quad.first_index;
+        quad_item.base_vertex = quad.base_vertex;
+        quad_item.constants_offset = uniform_ring.push(constants, object_constants.size());
+        quad_item.constants_size = object_constants.size();
+        render_queue.push(quad_item);
+
+        // The model is drawn once streamed in, its position decode folded
+        // together with a fit into the right half of the window
+        asset_pipeline.update();
+        const IndexedMesh* model_mesh = model_requested ? asset_pipeline.mesh(model) : nullptr;
+        if(model_mesh){
+            const MeshFileHeader& header = *asset_pipeline.mesh_header(model);
+            float extent = 0.0f;
+            for(int axis = 0; axis < 3; axis++){
+                extent = std::max(extent, header.bounds_max[axis] - header.bounds_min[axis]);
+            }
+            float scale = extent > 0.0f ? 0.6f / extent : 1.0f;
+            const float* decode = header.position_decode;
+            float centre[3];
+            for(int axis = 0; axis < 3; axis++){
+                centre[axis] = (header.bounds_min[axis] + header.bounds_max[axis]) * 0.5f;
+            }
+            Std140Writer model_constants(constants, sizeof(constants));
+            model_constants.write_vec4(0.9f, 0.7f, 0.2f, 1.0f);
+            model_constants.write_vec4(
+                (decode[0] - centre[0]) * scale + 0.55f,
+                (decode[1] - centre[1]) * scale,
+                (decode[2] - centre[2]) * scale,
+                decode[3] * scale
+            );
+            DrawItem model_item;
+            model_item.key = draw_sort_key(0, shader_program, 1, model_mesh->vao, 0.0f);
+            model_item.program = shader_program;
+            model_item.vao = model_mesh->vao;
+            model_item.index_type = model_mesh->index_type;
+            model_item.count = model_mesh->index_count;
+            model_item.first = model_mesh->first_index;
+            model_item.base_vertex = model_mesh->base_vertex;
+            model_item.constants_offset = uniform_ring.push(constants, model_constants.size());
+            model_item.constants_size = model_constants.size();
+            render_queue.push(model_item);
+        }
+        if(!assets_reported && asset_pipeline.idle()){
+            AssetPipelineStats asset_stats = asset_pipeline.stats();
+            GL_LOG_INFO(
+                ASSET,
+                "Assets streamed in %.2f ms (load %.2f ms, upload %.2f ms, %llu bytes)\n",
+                asset_stats.total.max_ms,
+                asset_stats.load.max_ms,
+                asset_stats.upload.max_ms,
+                (unsigned long long)asset_stats.uploaded_bytes
+            );
+            assets_reported = true;
+        }
+
+        if(!shader_reported && shader_compiler.status(test_program) != ProgramStatus::PENDING){
+            ProgramCacheStats cache_stats = shader_cache.stats();
+            GL_LOG_INFO(
+                SHADER,
+                "Shader startup %.3f ms (cache hits %llu, misses %llu, rejected %llu)\n",
+                (glfwGetTime() - shader_start) * 1000.0,
+                (unsigned long long)cache_stats.hits,
+                (unsigned long long)cache_stats.misses,
+                (unsigned long long)cache_stats.rejected
+            );
+            shader_reported = true;
+        }
+
+        // Sort the frame's draws by state and issue them
+        render_queue.submit(gl_state, &uniform_ring);
+
+        // The static strip shares one colour, then goes out in one call
+        Std140Writer strip_constants(constants, sizeof(constants));
+        strip_constants.write_vec4(0.2f, 0.3f, 0.8f, 1.0f);
+        strip_constants.write_vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        uniform_ring.push_and_bind(OBJECT_BLOCK_BINDING, constants, strip_constants.size());
+        for(BatchMesh mesh : strip){
+            static_batch.draw(mesh);
+        }
+        static_batch.submit(gl_state, shader_program);
+
+        // Instanced grid across the top of the window; the quad's position
+        // decode is folded into each instance's offset and scale
+        GLuint grid_program = shader_compiler.program(instanced_program);
+        for(int y = 0; y < 4; y++){
+            for(int x = 0; x < 32; x++){
+                float scale = 0.05f;
+                InstanceData instance = {
+                    {
+                        -0.94f + x * 0.06f + quad_decode[0] * scale,
+                        0.65f + y * 0.08f + quad_decode[1] * scale,
+                        quad_decode[2] * scale,
+                        quad_decode[3] * scale,
+                    },
+                    {x / 31.0f, y / 3.0f, 1.0f - x / 31.0f, 1.0f},
+                };
+                instance_renderer.add(grid_program, instanced_quad, instance);
+            }
+        }
+        instance_renderer.submit(gl_state);
+        uniform_ring.end_frame();
+        stream_buffer.end_frame();
+        gl_state.end_frame();
 
         // Fetch input events
         glfwPollEvents();
 
+        // Toggle the gradient variant on key press
+        bool gradient_key = GLFW_PRESS == glfwGetKey(window, GLFW_KEY_G);
+        if(gradient_key && !gradient_key_down){
+            test_features ^= test_variants.feature("GRADIENT");
+        }
+        gradient_key_down = gradient_key;
+
         // Make Esc key close window
         if(GLFW_PRESS == glfwGetKey(window, GLFW_KEY_ESCAPE)){
             glfwSetWindowShouldClose(window, 1);
@@ -361,7 +528,72 @@ int main(){
         glfwSwapBuffers(window);
     }
 
+    // Report variant usage so the hot ones can be pre-warmed next time
+    ShaderVariantStats variant_stats = test_variants.stats();
+    FeatureMask hot_variants[4];
+    size_t hot_count = test_variants.hottest(hot_variants, 4);
+    GL_LOG_INFO(
+        SHADER,
+        "Shader variants: %llu requested, %llu compiled, %llu cached, %llu prewarmed, hottest %#llx\n",
+        (unsigned long long)variant_stats.requested,
+        (unsigned long long)variant_stats.compiled,
+        (unsigned long long)variant_stats.cached,
+        (unsigned long long)variant_stats.prewarmed,
+        hot_count ? (unsigned long long)hot_variants[0] : 0ull
+    );
+
+    GlStateCounters state_calls = gl_state.total();
+    GL_LOG_INFO(
+        GL,
+        "GL state calls: %llu issued, %llu filtered\n",
+        (unsigned long long)state_calls.issued,
+        (unsigned long long)state_calls.filtered
+    );
+
+    BufferArenaStats arena_stats = mesh_arena.stats();
+    GL_LOG_INFO(
+        GL,
+        "Mesh arena: %zu pages, %zu of %zu bytes in %zu allocations, fragmentation %.2f\n",
+        arena_stats.pages,
+        arena_stats.used,
+        arena_stats.capacity,
+        arena_stats.allocations,
+        arena_stats.fragmentation
+    );
+
+    AssetPipelineStats asset_stats = asset_pipeline.stats();
+    GL_LOG_INFO(
+        ASSET,
+        "Asset pipeline: %llu ready, %llu failed, max queue %zu, max uploads %zu, "
+        "wait %.2f/%.2f ms, load %.2f/%.2f ms, upload wait %.2f/%.2f ms, upload %.2f/%.2f ms (mean/max)\n",
+        (unsigned long long)asset_stats.ready,
+        (unsigned long long)asset_stats.failed,
+        asset_stats.max_queued,
+        asset_stats.max_uploads,
+        asset_stats.wait.count ? asset_stats.wait.total_ms / asset_stats.wait.count : 0.0,
+        asset_stats.wait.max_ms,
+        asset_stats.load.count ? asset_stats.load.total_ms / asset_stats.load.count : 0.0,
+        asset_stats.load.max_ms,
+        asset_stats.upload_wait.count ? asset_stats.upload_wait.total_ms / asset_stats.upload_wait.count : 0.0,
+        asset_stats.upload_wait.max_ms,
+        asset_stats.upload.count ? asset_stats.upload.total_ms / asset_stats.upload.count : 0.0,
+        asset_stats.upload.max_ms
+    );
+
     // Cleanup and exit
+    asset_pipeline.destroy();
+    glDeleteVertexArrays(1, &instanced_vao);
+    destroy_indexed_mesh(quad);
+    static_batch.destroy();
+    mesh_arena.destroy();
+    stream_buffer.destroy();
+    uniform_ring.destroy();
+    shader_compiler.destroy();
+    if(shader_context){
+        glfwDestroyWindow(shader_context);
+    }
     glfwTerminate();
+    error_reporter_flush();
+    gl_log_shutdown();
     return 0;
 }
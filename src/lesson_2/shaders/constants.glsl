@@ -0,0 +1,13 @@
+#pragma once
+
+// std140 blocks streamed through UniformRing, bound by name from main.cpp
+
+layout(std140) uniform FrameConstants {
+    vec4 viewport;      // x, y, width, height
+    float time;
+};
+
+layout(std140) uniform ObjectConstants {
+    vec4 inputColour;
+    vec4 positionDecode;    // quantized positions: xyz offset, w scale
+};
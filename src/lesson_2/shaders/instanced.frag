@@ -0,0 +1,8 @@
+#version 400
+
+in vec4 colour;
+out vec4 fragColour;
+
+void main(){
+    fragColour = colour;
+}
@@ -0,0 +1,12 @@
+#version 400
+
+layout(location = 0) in vec3 vertex_position;
+layout(location = 1) in vec4 instance_transform;   // offset xyz, scale w
+layout(location = 2) in vec4 instance_colour;
+
+out vec4 colour;
+
+void main(){
+    colour = instance_colour;
+    gl_Position = vec4(vertex_position * instance_transform.w + instance_transform.xyz, 1.0);
+}
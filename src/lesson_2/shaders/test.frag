@@ -1,8 +1,12 @@
 #version 400
 
-uniform vec4 inputColour;
+#include "constants.glsl"
+
 out vec4 fragColour;
 
 void main(){
     fragColour = inputColour;
+#ifdef GRADIENT
+    fragColour.rgb *= gl_FragCoord.y / viewport.w;
+#endif
 }
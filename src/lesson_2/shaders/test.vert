@@ -1,7 +1,9 @@
 #version 400
 
+#include "constants.glsl"
+
 in vec3 vertex_position;
 
 void main(){
-    gl_Position = vec4(vertex_position, 1.0);
+    gl_Position = vec4(vertex_position * positionDecode.w + positionDecode.xyz, 1.0);
 }
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "asset_archive.h"
+
+// Packs files and directories into an asset archive, each file stored by
+// the path it was given as (run it from where the program loads assets),
+// or lists and verifies an existing archive.
+//   ./asset_pack.o <archive.pack> <file|directory>... [--store]
+//   ./asset_pack.o --list <archive.pack>
+
+double elapsed_ms(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void collect(const std::string& path, std::vector<AssetSource>& sources){
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0){
+        fprintf(stderr, "%s: not found\n", path.c_str());
+        return;
+    }
+    if(!S_ISDIR(info.st_mode)){
+        sources.push_back({path, path});
+        return;
+    }
+
+    // Sorted, so the same tree always packs to the same bytes
+    std::vector<std::string> names;
+    DIR* directory = opendir(path.c_str());
+    if(!directory){
+        return;
+    }
+    for(dirent* item = readdir(directory); item; item = readdir(directory)){
+        if(item->d_name[0] != '.'){
+            names.push_back(item->d_name);
+        }
+    }
+    closedir(directory);
+    std::sort(names.begin(), names.end());
+    for(const std::string& name : names){
+        collect(path + "/" + name, sources);
+    }
+}
+
+int list(const char* path){
+    AssetArchive archive;
+    if(!archive.open(path)){
+        return 1;
+    }
+    std::vector<const AssetArchiveEntry*> entries = archive.entries();
+    std::sort(entries.begin(), entries.end(), [](const AssetArchiveEntry* a, const AssetArchiveEntry* b){
+        return a->offset < b->offset;
+    });
+    for(const AssetArchiveEntry* entry : entries){
+        printf(
+            "%10llu %10llu %-4s %016llx  %s\n",
+            (unsigned long long)entry->size,
+            (unsigned long long)entry->stored_size,
+            entry->compression == (uint32_t)AssetCompression::LZ4 ? "lz4" : "-",
+            (unsigned long long)entry->content_hash,
+            archive.name(*entry)
+        );
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool valid = archive.verify();
+    printf("%zu entries, %zu bytes, verified in %.2f ms: %s\n", entries.size(), archive.size(), elapsed_ms(start), valid ? "ok" : "FAILED");
+    return valid ? 0 : 1;
+}
+
+int main(int argc, char** argv){
+    const char* output = nullptr;
+    std::vector<std::string> inputs;
+    AssetPackOptions options;
+    bool listing = false;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--store") == 0){
+            options.compress = false;
+        } else if(strcmp(argv[i], "--list") == 0){
+            listing = true;
+        } else if(!output){
+            output = argv[i];
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if(output && listing){
+        return list(output);
+    }
+    if(!output || inputs.empty()){
+        fprintf(stderr, "usage: %s <archive%s> <file|directory>... [--store]\n", argv[0], ASSET_ARCHIVE_EXTENSION);
+        fprintf(stderr, "       %s --list <archive%s>\n", argv[0], ASSET_ARCHIVE_EXTENSION);
+        return 1;
+    }
+
+    std::vector<AssetSource> sources;
+    for(const std::string& input : inputs){
+        collect(input, sources);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    AssetPackStats stats;
+    if(!write_asset_archive(output, sources.data(), sources.size(), options, &stats)){
+        return 1;
+    }
+    printf(
+        "%s: %llu files (%llu unique, %llu compressed), %llu -> %llu bytes of data, %llu byte archive, %.2f ms\n",
+        output,
+        (unsigned long long)stats.entries,
+        (unsigned long long)stats.unique,
+        (unsigned long long)stats.compressed,
+        (unsigned long long)stats.bytes,
+        (unsigned long long)stats.stored_bytes,
+        (unsigned long long)stats.archive_bytes,
+        elapsed_ms(start)
+    );
+    return 0;
+}
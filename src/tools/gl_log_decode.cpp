@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gl_log.h"
+#include "gl_log_binary.h"
+
+// Rebuilds the text gl.log from a binary log written with LogFormat::BINARY
+int main(int argc, char** argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s <%s> [%s]\n", argv[0], GL_LOG_BINARY_FILE, GL_LOG_FILE);
+        return 1;
+    }
+    const char* output_path = argc > 2 ? argv[2] : GL_LOG_FILE;
+
+    // Handle IO
+    FILE* input = fopen(argv[1], "rb");
+    if(!input){
+        fprintf(stderr, "ERROR: could not open binary log %s for reading\n", argv[1]);
+        return 1;
+    }
+    FILE* output = strcmp(output_path, "-") == 0 ? stdout : fopen(output_path, "w");
+    if(!output){
+        fprintf(stderr, "ERROR: could not open %s for writing\n", output_path);
+        fclose(input);
+        return 1;
+    }
+
+    // Check file header
+    char magic[sizeof(GL_LOG_BINARY_MAGIC) - 1];
+    uint32_t version = 0;
+    if(fread(magic, 1, sizeof(magic), input) != sizeof(magic) ||
+       memcmp(magic, GL_LOG_BINARY_MAGIC, sizeof(magic)) != 0 ||
+       fread(&version, sizeof(version), 1, input) != 1 ||
+       version != GL_LOG_BINARY_VERSION){
+        fprintf(stderr, "ERROR: %s is not a version %u binary GL log\n", argv[1], GL_LOG_BINARY_VERSION);
+        fclose(input);
+        return 1;
+    }
+
+    std::unordered_map<uint32_t, std::string> formats;
+    std::vector<uint8_t> payload;
+    std::string text;
+    size_t records = 0;
+    size_t failures = 0;
+
+    for(;;){
+        uint32_t id = 0;
+        uint16_t length = 0;
+        if(fread(&id, sizeof(id), 1, input) != 1 || fread(&length, sizeof(length), 1, input) != 1){
+            break;
+        }
+        payload.resize(length);
+        if(length > 0 && fread(payload.data(), 1, length, input) != length){
+            fprintf(stderr, "WARNING: truncated record at end of %s\n", argv[1]);
+            break;
+        }
+
+        // Format definitions
+        if(id & LOG_DEFINITION_BIT){
+            formats[id & ~LOG_DEFINITION_BIT] = std::string((const char*)payload.data(), length);
+            continue;
+        }
+
+        // Preformatted text
+        records++;
+        if(id == LOG_TEXT_ID){
+            fwrite(payload.data(), 1, length, output);
+            continue;
+        }
+
+        // Deferred events
+        std::unordered_map<uint32_t, std::string>::const_iterator format = formats.find(id);
+        text.clear();
+        if(format == formats.end() || !format_log_event(format->second.c_str(), payload.data(), length, text)){
+            fprintf(output, "<undecodable record id %u, %u bytes>\n", id, length);
+            failures++;
+            continue;
+        }
+        fwrite(text.data(), 1, text.size(), output);
+    }
+
+    // IO cleanup
+    fclose(input);
+    if(output != stdout){
+        fclose(output);
+    }
+    fprintf(stderr, "decoded %zu records (%zu formats, %zu failures)\n", records, formats.size(), failures);
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "mesh_file.h"
+#include "mesh_importer.h"
+#include "mesh_optimizer.h"
+#include "vertex_compression.h"
+
+// Converts an OBJ or PLY file into the binary mesh format: imports it,
+// reorders it for the vertex cache and fetch, packs the attributes and
+// writes vertex/index blobs ready for upload.
+//   ./mesh_convert.o <input.obj|input.ply> [output.mesh] [--float] [--no-optimize]
+
+double elapsed_ms(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv){
+    const char* input = nullptr;
+    std::string output;
+    bool compress = true;
+    bool optimize = true;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--float") == 0){
+            compress = false;
+        } else if(strcmp(argv[i], "--no-optimize") == 0){
+            optimize = false;
+        } else if(!input){
+            input = argv[i];
+        } else {
+            output = argv[i];
+        }
+    }
+    if(!input){
+        fprintf(stderr, "usage: %s <input.obj|input.ply> [output%s] [--float] [--no-optimize]\n", argv[0], MESH_FILE_EXTENSION);
+        return 1;
+    }
+    if(output.empty()){
+        output = input;
+        output = output.substr(0, output.find_last_of('.')) + MESH_FILE_EXTENSION;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ImportedMesh mesh;
+    MeshImportStats import_stats;
+    if(!import_mesh(input, mesh, MeshImportOptions(), &import_stats)){
+        return 1;
+    }
+    double import_ms = elapsed_ms(start);
+
+    // Interleave position, normal, uv as floats so the optimizer can move
+    // whole vertices
+    start = std::chrono::steady_clock::now();
+    size_t vertex_count = mesh.vertex_count();
+    bool has_normals = !mesh.normals.empty();
+    bool has_uvs = !mesh.uvs.empty();
+    size_t floats = 3 + (has_normals ? 3 : 0) + (has_uvs ? 2 : 0);
+    std::vector<float> vertices(vertex_count * floats);
+    for(size_t i = 0; i < vertex_count; i++){
+        float* vertex = &vertices[i * floats];
+        std::copy(&mesh.positions[i * 3], &mesh.positions[i * 3] + 3, vertex);
+        if(has_normals){
+            std::copy(&mesh.normals[i * 3], &mesh.normals[i * 3] + 3, vertex + 3);
+        }
+        if(has_uvs){
+            std::copy(&mesh.uvs[i * 2], &mesh.uvs[i * 2] + 2, vertex + (has_normals ? 6 : 3));
+        }
+    }
+
+    float acmr_before = compute_acmr(mesh.indices.data(), mesh.indices.size(), vertex_count);
+    float acmr_after = acmr_before;
+    if(optimize){
+        optimize_vertex_cache(mesh.indices.data(), mesh.indices.size(), vertex_count);
+        vertex_count = optimize_vertex_fetch(vertices.data(), vertex_count, floats * sizeof(float), mesh.indices.data(), mesh.indices.size());
+        acmr_after = compute_acmr(mesh.indices.data(), mesh.indices.size(), vertex_count);
+    }
+
+    VertexStreams streams;
+    streams.positions = vertices.data();
+    streams.normals = has_normals ? vertices.data() + 3 : nullptr;
+    streams.uvs = has_uvs ? vertices.data() + (has_normals ? 6 : 3) : nullptr;
+    streams.stride = floats * sizeof(float);
+    streams.count = vertex_count;
+    VertexCompression compression;
+    compression.positions = compression.normals = compression.uvs = compress;
+    CompressedVertices packed;
+    if(!compress_vertices(streams, compression, packed)){
+        fprintf(stderr, "ERROR: %s has no vertices\n", input);
+        return 1;
+    }
+    VertexCompressionError error = measure_compression_error(streams, packed);
+
+    // Bounds, and one submesh over everything
+    MeshFileSubmesh submesh = {0, (uint32_t)mesh.indices.size(), 0, 0, {INFINITY, INFINITY, INFINITY}, {-INFINITY, -INFINITY, -INFINITY}};
+    for(size_t i = 0; i < vertex_count; i++){
+        for(int axis = 0; axis < 3; axis++){
+            submesh.bounds_min[axis] = std::min(submesh.bounds_min[axis], vertices[i * floats + axis]);
+            submesh.bounds_max[axis] = std::max(submesh.bounds_max[axis], vertices[i * floats + axis]);
+        }
+    }
+
+    MeshFileData data;
+    data.format = packed.format;
+    data.vertices = packed.data.data();
+    data.vertex_count = vertex_count;
+    std::vector<uint16_t> short_indices;
+    if(vertex_count <= 0xffff){
+        short_indices.assign(mesh.indices.begin(), mesh.indices.end());
+        data.indices = short_indices.data();
+        data.index_type = GL_UNSIGNED_SHORT;
+    } else {
+        data.indices = mesh.indices.data();
+        data.index_type = GL_UNSIGNED_INT;
+    }
+    data.index_count = mesh.indices.size();
+    data.submeshes = &submesh;
+    data.submesh_count = 1;
+    memcpy(data.bounds_min, submesh.bounds_min, sizeof(data.bounds_min));
+    memcpy(data.bounds_max, submesh.bounds_max, sizeof(data.bounds_max));
+    memcpy(data.position_decode, packed.position_decode, sizeof(data.position_decode));
+    if(!write_mesh_file(output.c_str(), data)){
+        return 1;
+    }
+    double convert_ms = elapsed_ms(start);
+
+    // What loading it costs now: map, validate, touch every byte
+    start = std::chrono::steady_clock::now();
+    MeshFile file;
+    if(!file.open(output.c_str())){
+        return 1;
+    }
+    uint64_t checksum = 0;
+    const uint64_t* words = (const uint64_t*)file.vertices();
+    for(size_t i = 0; i < file.vertex_bytes() / sizeof(uint64_t); i++){
+        checksum += words[i];
+    }
+    words = (const uint64_t*)file.indices();
+    for(size_t i = 0; i < file.index_bytes() / sizeof(uint64_t); i++){
+        checksum += words[i];
+    }
+    double load_ms = elapsed_ms(start);
+
+    printf("%s: %zu vertices, %zu triangles\n", input, vertex_count, mesh.indices.size() / 3);
+    printf("imported in %.1f ms (%.1f MB), converted in %.1f ms\n", import_ms, import_stats.bytes / (1024.0 * 1024.0), convert_ms);
+    printf("ACMR %.3f -> %.3f, %d bytes/vertex\n", acmr_before, acmr_after, packed.format.stride);
+    printf("error: position %.3g, normal %.3g deg, uv %.3g\n", error.max_position, error.max_normal_degrees, error.max_uv);
+    printf("wrote %s (%.1f MB), mapped in %.1f ms (checksum %llx)\n", output.c_str(), file.size() / (1024.0 * 1024.0), load_ms, (unsigned long long)checksum);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "vertex_compression.h"
+
+// Bytes per vertex and decode error of each vertex compression option on
+// a UV sphere with positions, normals and texture coordinates.
+//   ./vertex_compress.o [segments] [radius]
+
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+std::vector<Vertex> uv_sphere(int segments, float radius){
+    std::vector<Vertex> vertices;
+    int rings = segments / 2;
+    for(int ring = 0; ring <= rings; ring++){
+        float v = (float)ring / rings;
+        float theta = v * (float)M_PI;
+        for(int segment = 0; segment <= segments; segment++){
+            float u = (float)segment / segments;
+            float phi = u * 2.0f * (float)M_PI;
+            float normal[3] = {sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)};
+            vertices.push_back({
+                {normal[0] * radius, normal[1] * radius, normal[2] * radius},
+                {normal[0], normal[1], normal[2]},
+                {u, v},
+            });
+        }
+    }
+    return vertices;
+}
+
+int main(int argc, char** argv){
+    int segments = argc > 1 ? atoi(argv[1]) : 200;
+    float radius = argc > 2 ? (float)atof(argv[2]) : 10.0f;
+    if(segments < 4){
+        fprintf(stderr, "usage: %s [segments >= 4] [radius]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Vertex> vertices = uv_sphere(segments, radius);
+    VertexStreams streams;
+    streams.positions = vertices[0].position;
+    streams.normals = vertices[0].normal;
+    streams.uvs = vertices[0].uv;
+    streams.stride = sizeof(Vertex);
+    streams.count = vertices.size();
+
+    struct Option {
+        const char* name;
+        VertexCompression compression;
+    };
+    Option options[] = {
+        {"float", {false, false, false}},
+        {"positions", {true, false, false}},
+        {"normals", {false, true, false}},
+        {"uvs", {false, false, true}},
+        {"all", {true, true, true}},
+    };
+
+    printf("sphere, %zu vertices, radius %g\n", vertices.size(), radius);
+    printf("%-10s %6s %12s %12s %12s %12s\n", "packed", "bytes", "pos max", "pos rms", "normal deg", "uv max");
+    for(const Option& option : options){
+        CompressedVertices compressed;
+        if(!compress_vertices(streams, option.compression, compressed)){
+            fprintf(stderr, "ERROR: could not compress with %s\n", option.name);
+            return 1;
+        }
+        VertexCompressionError error = measure_compression_error(streams, compressed);
+        printf(
+            "%-10s %6d %12.3g %12.3g %12.3g %12.3g\n",
+            option.name,
+            compressed.format.stride,
+            error.max_position,
+            error.rms_position,
+            error.max_normal_degrees,
+            error.max_uv
+        );
+    }
+    return 0;
+}